@@ -0,0 +1,73 @@
+/**
+ * @file bench.hpp
+ * @author Lygaen
+ * @brief The file containing the benchmarks utilities
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MINESERVER_BENCH_H
+#define MINESERVER_BENCH_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+/**
+ * @brief Benchmarks utilities
+ *
+ */
+namespace bench
+{
+    /**
+     * @brief Prevents the compiler from optimizing a value away
+     *
+     * @tparam T the type of the value
+     * @param value the value to keep
+     */
+    template <typename T>
+    inline void keep(T const &value)
+    {
+#if defined(_MSC_VER)
+        static volatile const void *sink;
+        sink = &value;
+#else
+        asm volatile("" : : "r,m"(value) : "memory");
+#endif
+    }
+
+    /**
+     * @brief Runs a benchmark and prints its results
+     *
+     * @tparam F the type of the benchmarked function
+     * @param name the name of the benchmark
+     * @param iterations the number of times to call @p fn
+     * @param bytes the number of bytes processed per call, 0 to not print throughput
+     * @param fn the benchmarked function
+     * @return double the nanoseconds per call
+     */
+    template <typename F>
+    double run(const char *name, std::size_t iterations, std::size_t bytes, F &&fn)
+    {
+        // Warm up caches and lazy allocations
+        for (std::size_t i = 0; i < iterations / 10 + 1; i++)
+            fn();
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < iterations; i++)
+            fn();
+        auto end = std::chrono::steady_clock::now();
+
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+        if (bytes == 0)
+            std::printf("%-40s %10.1f ns/op\n", name, ns);
+        else
+            std::printf("%-40s %10.1f ns/op %10.1f MB/s\n", name, ns, bytes * 1000.0 / ns);
+        return ns;
+    }
+}
+
+#endif // MINESERVER_BENCH_H
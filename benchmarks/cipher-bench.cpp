@@ -0,0 +1,86 @@
+/**
+ * @file cipher-bench.cpp
+ * @author Lygaen
+ * @brief The file benchmarking the AES/CFB8 cipher
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <bench.hpp>
+#include <net/stream.h>
+#include <utils/crypto.h>
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief Stream endlessly reading the same bytes
+ *
+ * Source of the cipher stream, so that only
+ * the decryption is measured.
+ */
+class RepeatStream : public IMCStream
+{
+public:
+    void read(std::byte *buffer, std::size_t offset, std::size_t len) override
+    {
+        std::memset(buffer + offset, 0x42, len);
+    }
+    void write(const std::byte *buffer, std::size_t offset, std::size_t len) override
+    {
+        (void)buffer;
+        (void)offset;
+        (void)len;
+    }
+    void flush() override {}
+    size_t available() override
+    {
+        return 0;
+    }
+    void finishPacketWrite(const std::byte *packetData, size_t len) override
+    {
+        (void)packetData;
+        (void)len;
+    }
+};
+
+int main()
+{
+    std::unique_ptr<std::byte[]> key = crypto::randomSecure(16);
+
+    for (std::size_t size : {16, 64, 256, 1024, 16384, 65536})
+    {
+        std::vector<std::byte> data(size, std::byte(0x42));
+        std::size_t iterations = 16 * 1024 * 1024 / size / 4 + 100;
+        std::printf("-- %zu bytes spans\n", size);
+
+        crypto::AES128CFB8Cipher encipher(crypto::CipherState::ENCRYPT, key.get(), key.get());
+        bench::run("encrypt", iterations, size, [&]()
+                   { encipher.update(data.data(), data.size()); });
+
+        crypto::AES128CFB8Cipher decipher(crypto::CipherState::DECRYPT, key.get(), key.get());
+        bench::run("decrypt", iterations, size, [&]()
+                   { decipher.update(data.data(), data.size()); });
+
+        // OpenSSL's own CFB8 mode, one block at a time
+        EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+        EVP_DecryptInit(ctx, EVP_aes_128_cfb8(), (const unsigned char *)key.get(), (const unsigned char *)key.get());
+        bench::run("decrypt (evp cfb8)", iterations, size, [&]()
+                   {
+            int outLen;
+            EVP_DecryptUpdate(ctx, (unsigned char *)data.data(), &outLen, (const unsigned char *)data.data(), size); });
+        EVP_CIPHER_CTX_free(ctx);
+
+        CipherStream stream(new RepeatStream(), key.get(), key.get());
+        bench::run("stream read", iterations, size, [&]()
+                   { stream.read(data.data(), 0, data.size()); });
+        bench::run("stream read byte by byte", iterations / 4 + 1, size, [&]()
+                   {
+            for (std::size_t i = 0; i < size; i++)
+                bench::keep(stream.readByte()); });
+    }
+
+    return 0;
+}
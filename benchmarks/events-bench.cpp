@@ -0,0 +1,76 @@
+/**
+ * @file events-bench.cpp
+ * @author Lygaen
+ * @brief The file benchmarking the events firing
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <bench.hpp>
+#include <plugins/event.h>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Event fired by the benchmarks
+ *
+ */
+class BenchEvent : public IEvent<BenchEvent>
+{
+public:
+    int amount = 0;
+};
+
+/**
+ * @brief Other event, only subscribed to
+ *
+ * Takes the slots before BenchEvent, like the
+ * events a server registers before firing any.
+ * @tparam N the index of the event
+ */
+template <int N>
+class OtherEvent : public IEvent<OtherEvent<N>>
+{
+};
+
+/**
+ * @brief Subscribes to other events
+ *
+ * @tparam N the indexes of the events
+ * @param events the events manager
+ */
+template <int... N>
+void subscribeOthers(EventsManager &events, std::integer_sequence<int, N...>)
+{
+    (events.subscribe<OtherEvent<N>>([](OtherEvent<N> &) {}), ...);
+}
+
+int main()
+{
+    EventsManager events;
+    subscribeOthers(events, std::make_integer_sequence<int, 16>());
+
+    BenchEvent event;
+    std::vector<EventHandler<BenchEvent>::subId> subs;
+    for (int subscribers : {0, 1, 10})
+    {
+        while (subs.size() < static_cast<std::size_t>(subscribers))
+            subs.push_back(events.subscribe<BenchEvent>([](BenchEvent &e)
+                                                        { e.amount++; }));
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "fire, %d subscribers", subscribers);
+        bench::run(name, 10000000, 0, [&]()
+                   {
+            events.fire(event);
+            bench::keep(event.amount); });
+    }
+
+    for (auto sub : subs)
+        events.unsubscribe<BenchEvent>(sub);
+    return 0;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file login-bench.cpp
+ * @author Lygaen
+ * @brief The file benchmarking the login cryptography throughput
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <bench.hpp>
+#include <net/logincrypto.h>
+#include <utils/crypto.h>
+#include <openssl/pem.h>
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Previous decryption, with a new context per call
+ *
+ * @param key the keypair
+ * @param data the data to decrypt
+ * @param len the length of @p data
+ * @param outLen the length of the decrypted data
+ * @return std::unique_ptr<std::byte[]> the decrypted data
+ */
+std::unique_ptr<std::byte[]> contextDecrypt(EVP_PKEY *key, const std::byte *data, size_t len, size_t *outLen)
+{
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new(key, nullptr);
+    EVP_PKEY_decrypt_init(ctx);
+    EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING);
+
+    EVP_PKEY_decrypt(ctx, nullptr, outLen, (const unsigned char *)data, len);
+    std::unique_ptr<std::byte[]> out(new std::byte[*outLen]);
+    EVP_PKEY_decrypt(ctx, (unsigned char *)out.get(), outLen, (const unsigned char *)data, len);
+
+    EVP_PKEY_CTX_free(ctx);
+    return out;
+}
+
+/**
+ * @brief Previous digest formatting, through BIGNUM
+ *
+ * @param data the digest
+ * @param size the length of @p data
+ * @return std::string the formatted digest
+ */
+std::string bignumDigest(const unsigned char *data, unsigned int size)
+{
+    std::string result;
+    BIGNUM *bn = BN_bin2bn(data, size, nullptr);
+
+    if (BN_is_bit_set(bn, 159))
+    {
+        result += '-';
+
+        auto tmp = std::vector<unsigned char>(BN_num_bytes(bn));
+        BN_bn2bin(bn, tmp.data());
+        std::transform(tmp.begin(), tmp.end(), tmp.begin(), [](unsigned char b)
+                       { return ~b; });
+        BN_bin2bn(tmp.data(), tmp.size(), bn);
+
+        BN_add_word(bn, 1);
+    }
+
+    char *hex = BN_bn2hex(bn);
+    auto view = std::string_view(hex);
+    while (!view.empty() && view[0] == '0')
+        view = view.substr(1);
+
+    result.append(view.begin(), view.end());
+    OPENSSL_free(hex);
+    BN_free(bn);
+
+    std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c)
+                   { return std::tolower(c); });
+    return result;
+}
+
+int main()
+{
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "mineserver-login-bench.key";
+    std::filesystem::remove(path);
+    crypto::init(path.string());
+
+    // Same keypair as the crypto one, for the previous path
+    FILE *file = std::fopen(path.string().c_str(), "rb");
+    EVP_PKEY *key = PEM_read_PrivateKey(file, nullptr, nullptr, nullptr);
+    std::fclose(file);
+
+    std::unique_ptr<std::byte[]> secret = crypto::randomSecure(16);
+    std::unique_ptr<std::byte[]> token = crypto::randomSecure(4);
+    size_t secretLen, tokenLen;
+    std::unique_ptr<std::byte[]> encryptedSecret = crypto::rsaEncrypt(secret.get(), 16, &secretLen);
+    std::unique_ptr<std::byte[]> encryptedToken = crypto::rsaEncrypt(token.get(), 4, &tokenLen);
+    LoginCrypto::Request request{std::vector<std::byte>(encryptedSecret.get(), encryptedSecret.get() + secretLen),
+                                 std::vector<std::byte>(encryptedToken.get(), encryptedToken.get() + tokenLen)};
+
+    unsigned char digest[20];
+    for (std::size_t i = 0; i < sizeof(digest); i++)
+        digest[i] = (unsigned char)(0x80 + i * 7);
+
+    std::printf("-- digest\n");
+    bench::run("format (BIGNUM)", 200000, 0, [&digest]()
+               { bench::keep(bignumDigest(digest, sizeof(digest))); });
+    bench::run("format (direct)", 200000, 0, [&digest]()
+               { bench::keep(crypto::MinecraftHash::formatDigest(digest, sizeof(digest))); });
+
+    std::printf("-- single login\n");
+    bench::run("decrypt (context per call)", 2000, 0, [&]()
+               {
+        size_t len;
+        bench::keep(contextDecrypt(key, encryptedSecret.get(), secretLen, &len));
+        bench::keep(contextDecrypt(key, encryptedToken.get(), tokenLen, &len)); });
+    bench::run("decrypt and hash (thread contexts)", 2000, 0, [&request]()
+               { bench::keep(LoginCrypto::decrypt(request)); });
+
+    std::printf("-- throughput, batches of %zu logins\n", LoginCrypto::MAX_QUEUED);
+    unsigned int hardware = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int workers : {1u, 2u, 4u, hardware})
+    {
+        LoginCrypto pool;
+        pool.start(workers);
+
+        std::mutex lock;
+        std::condition_variable cond;
+        std::size_t done = 0;
+        char name[64];
+        std::snprintf(name, sizeof(name), "%u workers (per batch)", workers);
+        double ns = bench::run(name, 5, 0, [&]()
+                               {
+            done = 0;
+            for (std::size_t i = 0; i < LoginCrypto::MAX_QUEUED; i++)
+                pool.submit(request, [&](const LoginCrypto::Result &)
+                            {
+                    std::lock_guard<std::mutex> guard(lock);
+                    done++;
+                    cond.notify_all(); });
+
+            std::unique_lock<std::mutex> guard(lock);
+            cond.wait(guard, [&done]()
+                      { return done == LoginCrypto::MAX_QUEUED; }); });
+        std::printf("%-40s %10.0f logins/s\n", "  throughput", LoginCrypto::MAX_QUEUED * 1e9 / ns);
+
+        pool.stop();
+    }
+
+    EVP_PKEY_free(key);
+    crypto::cleanup();
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file pipeline-bench.cpp
+ * @author Lygaen
+ * @brief The file benchmarking the outgoing packets pipeline
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <bench.hpp>
+#include <net/pipeline.h>
+#include <net/stream.h>
+#include <utils/crypto.h>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Stream discarding everything written to it
+ *
+ * Sink of the decorators chain, so that only the
+ * chain itself is measured.
+ */
+class NullStream : public IMCStream
+{
+public:
+    std::size_t written = 0;
+
+    void read(std::byte *buffer, std::size_t offset, std::size_t len) override
+    {
+        (void)buffer;
+        (void)offset;
+        (void)len;
+    }
+    void write(const std::byte *buffer, std::size_t offset, std::size_t len) override
+    {
+        bench::keep(buffer[offset]);
+        written += len;
+    }
+    void flush() override {}
+    size_t available() override
+    {
+        return 0;
+    }
+    void finishPacketWrite(const std::byte *packetData, size_t len) override
+    {
+        writeVarInt(len);
+        write(packetData, 0, len);
+    }
+};
+
+/**
+ * @brief Socket stage discarding everything sent to it
+ *
+ */
+class NullSink
+{
+public:
+    std::size_t written = 0;
+
+    void send(SocketBuffer *buffers, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            bench::keep(buffers[i].data[0]);
+            written += buffers[i].len;
+        }
+    }
+};
+
+/**
+ * @brief Builds a packet, compressible like most game packets
+ *
+ * @param len the length of the packet
+ * @return std::vector<std::byte> the packet id and data
+ */
+std::vector<std::byte> makePacket(std::size_t len)
+{
+    std::vector<std::byte> packet(len);
+    for (std::size_t i = 0; i < len; i++)
+        packet[i] = std::byte(i % 64 < 48 ? 0 : (i * 31) & 0xFF);
+    return packet;
+}
+
+int main()
+{
+    std::unique_ptr<std::byte[]> key = crypto::randomSecure(16);
+    const int level = -1;
+    const int threshold = 256;
+
+    for (std::size_t size : {64, 1024, 16384})
+    {
+        std::vector<std::byte> packet = makePacket(size);
+        std::size_t iterations = 4 * 1024 * 1024 / size + 1000;
+        std::printf("-- %zu bytes packets\n", size);
+
+        {
+            NullStream sink;
+            bench::run("chain plain", iterations, size, [&]()
+                       { sink.finishPacketWrite(packet.data(), packet.size()); });
+
+            Pipeline composed{pipeline::NoCompression(), pipeline::NoEncryption(), NullSink()};
+            bench::run("pipeline plain", iterations, size, [&]()
+                       { composed.writePacket(packet.data(), packet.size()); });
+        }
+
+        {
+            CipherStream chain(new NullStream(), key.get(), key.get());
+            bench::run("chain encrypted", iterations, size, [&]()
+                       { chain.finishPacketWrite(packet.data(), packet.size()); });
+
+            Pipeline composed{pipeline::NoCompression(), pipeline::AESEncryption(key.get()), NullSink()};
+            bench::run("pipeline encrypted", iterations, size, [&]()
+                       { composed.writePacket(packet.data(), packet.size()); });
+        }
+
+        {
+            ZLibStream chain(new CipherStream(new NullStream(), key.get(), key.get()), level, threshold);
+            bench::run("chain compressed+encrypted", iterations, size, [&]()
+                       { chain.finishPacketWrite(packet.data(), packet.size()); });
+
+            Pipeline composed{pipeline::ZLibCompression(level, threshold), pipeline::AESEncryption(key.get()), NullSink()};
+            bench::run("pipeline compressed+encrypted", iterations, size, [&]()
+                       { composed.writePacket(packet.data(), packet.size()); });
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file rsa-bench.cpp
+ * @author Lygaen
+ * @brief The file benchmarking the startup and login cryptography
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <bench.hpp>
+#include <utils/crypto.h>
+#include <openssl/x509.h>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+/**
+ * @brief Previous public key, encoded and copied on every call
+ *
+ * @param key the keypair
+ * @param outLen the length of the key returned
+ * @return std::unique_ptr<std::byte[]> the key in DER format
+ */
+std::unique_ptr<std::byte[]> encodePublicKey(EVP_PKEY *key, int *outLen)
+{
+    unsigned char *buff = nullptr;
+    int len = i2d_PUBKEY(key, &buff);
+    auto *out = new std::byte[len];
+    std::memcpy(out, buff, len);
+
+    *outLen = len;
+    OPENSSL_free(buff);
+    return std::unique_ptr<std::byte[]>(out);
+}
+
+int main()
+{
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "mineserver-bench.key";
+    std::filesystem::remove(path);
+
+    std::printf("-- startup\n");
+    bench::run("init (generate)", 20, 0, []()
+               { crypto::init(); crypto::cleanup(); });
+    crypto::init(path.string());
+    crypto::cleanup();
+    bench::run("init (load key file)", 200, 0, [&path]()
+               { crypto::init(path.string()); crypto::cleanup(); });
+
+    crypto::init(path.string());
+    std::unique_ptr<std::byte[]> secret = crypto::randomSecure(16);
+    std::unique_ptr<std::byte[]> token = crypto::randomSecure(4);
+    size_t secretLen, tokenLen;
+    std::unique_ptr<std::byte[]> encryptedSecret = crypto::rsaEncrypt(secret.get(), 16, &secretLen);
+    std::unique_ptr<std::byte[]> encryptedToken = crypto::rsaEncrypt(token.get(), 4, &tokenLen);
+
+    // Same key as crypto::getPublicRSAKey(), decoded back
+    std::span<const std::byte> der = crypto::getPublicRSAKey();
+    const unsigned char *derData = (const unsigned char *)der.data();
+    EVP_PKEY *key = d2i_PUBKEY(nullptr, &derData, der.size());
+
+    std::printf("-- login\n");
+    bench::run("public key (encode and copy)", 100000, 0, [key]()
+               {
+        int len;
+        bench::keep(encodePublicKey(key, &len)); });
+    bench::run("public key (cached)", 100000, 0, []()
+               { bench::keep(crypto::getPublicRSAKey()); });
+
+    crypto::MinecraftHash hash;
+    bench::run("server hash (string copies)", 100000, 0, [&]()
+               {
+        int len;
+        std::unique_ptr<std::byte[]> encoded = encodePublicKey(key, &len);
+        hash.update("");
+        hash.update(std::string((const char *)secret.get(), 16));
+        hash.update(std::string((const char *)encoded.get(), len));
+        bench::keep(hash.finalize()); });
+    bench::run("server hash (borrowed)", 100000, 0, [&]()
+               {
+        hash.update({secret.get(), 16});
+        hash.update(crypto::getPublicRSAKey());
+        bench::keep(hash.finalize()); });
+
+    bench::run("encryption response", 2000, 0, [&]()
+               {
+        size_t len;
+        bench::keep(crypto::rsaDecrypt(encryptedSecret.get(), secretLen, &len));
+        bench::keep(crypto::rsaDecrypt(encryptedToken.get(), tokenLen, &len));
+        hash.update({secret.get(), 16});
+        hash.update(crypto::getPublicRSAKey());
+        bench::keep(hash.finalize()); });
+
+    EVP_PKEY_free(key);
+    crypto::cleanup();
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file shared-bench.cpp
+ * @author Lygaen
+ * @brief The file benchmarking packets shared by many connections
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <bench.hpp>
+#include <net/outbound.h>
+#include <net/pipeline.h>
+#include <net/sharedpacket.h>
+#include <net/stream.h>
+#include <utils/crypto.h>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <vector>
+#if defined(__linux__)
+#include <sys/socket.h>
+
+/**
+ * @brief Number of connections a packet is sent to
+ *
+ */
+constexpr std::size_t CONNECTIONS = 64;
+
+/**
+ * @brief Connections over socket pairs
+ *
+ * Readers discard everything, so that
+ * the sockets never fill up.
+ */
+struct Connections
+{
+    std::vector<std::unique_ptr<NetSocketStream>> readers;
+    std::vector<std::unique_ptr<NetSocketStream>> writers;
+    std::vector<std::unique_ptr<PipelineStream>> pipelines;
+
+    Connections(bool compressed, bool encrypted, const std::byte *key)
+    {
+        char address[] = "localhost";
+        for (std::size_t i = 0; i < CONNECTIONS; i++)
+        {
+            int fds[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+            readers.push_back(std::make_unique<NetSocketStream>(ClientSocket(fds[0], address)));
+            writers.push_back(std::make_unique<NetSocketStream>(ClientSocket(fds[1], address)));
+            pipelines.push_back(std::make_unique<PipelineStream>(writers.back().get()));
+
+            if (encrypted)
+                pipelines.back()->enableEncryption(key);
+            if (compressed)
+                pipelines.back()->enableCompression(-1, 256);
+        }
+    }
+};
+
+/**
+ * @brief Sends a packet to all of the connections and prints the copied bytes
+ *
+ * @param name the name of the benchmark
+ * @param connections the connections to send to
+ * @param congested whether sockets are held back, as if they could not take anything
+ * @param send sends the packet through a pipeline
+ */
+static void measure(const char *name, Connections &connections, bool congested, const std::function<void(PipelineStream &)> &send)
+{
+    std::uint64_t copied = OutboundQueue::totalCopied();
+    auto start = std::chrono::steady_clock::now();
+
+    bench::run(name, 200, 0, [&]()
+               {
+        for (std::size_t i = 0; i < CONNECTIONS; i++)
+        {
+            if (congested)
+                connections.writers[i]->cork();
+            send(*connections.pipelines[i]);
+            if (congested)
+                connections.writers[i]->flush();
+
+            connections.readers[i]->fill();
+            connections.readers[i]->consume(connections.readers[i]->receivedSize());
+        } });
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-40s %10.1f MB/s copied\n", "", (OutboundQueue::totalCopied() - copied) / seconds / 1e6);
+}
+
+int main()
+{
+    std::unique_ptr<std::byte[]> key = crypto::randomSecure(16);
+
+    for (std::size_t size : {8192, 65536})
+    {
+        // Compressible like a status response with its favicon
+        std::vector<std::byte> packet(size);
+        for (std::size_t i = 0; i < size; i++)
+            packet[i] = std::byte(i % 64 < 32 ? 0 : (i * 31) & 0xFF);
+
+        std::printf("-- %zu bytes packet, to %zu connections\n", size, CONNECTIONS);
+        for (int mode = 0; mode < 3; mode++)
+        {
+            const char *names[] = {"plain", "compressed", "encrypted"};
+            std::printf("- %s\n", names[mode]);
+
+            for (bool congested : {false, true})
+            {
+                Connections connections(mode == 1, mode == 2, key.get());
+                SharedPacket shared(packet);
+
+                measure(congested ? "per connection (congested)" : "per connection", connections, congested, [&packet](PipelineStream &pipeline)
+                        { pipeline.finishPacketWrite(packet.data(), packet.size()); });
+                measure(congested ? "shared (congested)" : "shared", connections, congested, [&shared](PipelineStream &pipeline)
+                        { pipeline.writeShared(shared); });
+            }
+        }
+    }
+
+    return 0;
+}
+#else
+int main()
+{
+    std::printf("Socket pairs are only available on Linux\n");
+    return 0;
+}
+#endif
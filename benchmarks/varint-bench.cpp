@@ -0,0 +1,172 @@
+/**
+ * @file varint-bench.cpp
+ * @author Lygaen
+ * @brief The file benchmarking the VarInt codec
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <bench.hpp>
+#include <net/stream.h>
+#include <net/varint.hpp>
+#include <random>
+#include <vector>
+
+/**
+ * @brief Previous VarInt decoding, one byte at a time
+ *
+ * @param data the buffer to decode from
+ * @param len the length of @p data
+ * @param value the decoded value
+ * @return std::size_t the number of bytes read
+ */
+std::size_t loopDecode(const std::byte *data, std::size_t len, std::int32_t &value)
+{
+    value = 0;
+    int position = 0;
+
+    for (std::size_t i = 0; i < len; i++)
+    {
+        auto currentByte = static_cast<std::uint8_t>(data[i]);
+        value |= (currentByte & 0x7F) << position;
+
+        if ((currentByte & 0x80) == 0)
+            return i + 1;
+
+        position += 7;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Previous VarInt encoding, one byte at a time
+ *
+ * @param value the value to encode
+ * @param out the buffer to encode to
+ * @return std::size_t the number of bytes written
+ */
+std::size_t loopEncode(std::int32_t value, std::byte *out)
+{
+    auto bits = static_cast<std::uint32_t>(value);
+    std::size_t size = 0;
+
+    while (true)
+    {
+        if ((bits & ~0x7Fu) == 0)
+        {
+            out[size++] = static_cast<std::byte>(bits);
+            return size;
+        }
+
+        out[size++] = static_cast<std::byte>((bits & 0x7F) | 0x80);
+        bits >>= 7;
+    }
+}
+
+/**
+ * @brief Previous VarInt size calculation, through a stream
+ *
+ * @param i the value
+ * @return std::size_t the size of @p i in VarInt format
+ */
+std::size_t streamSize(int i)
+{
+    MemoryStream m;
+    m.writeVarInt(i);
+    return m.getData().size();
+}
+
+/**
+ * @brief Benchmarks the codec against the previous implementation
+ *
+ * @param name the name of the values distribution
+ * @param values the values to encode and decode
+ */
+void runAll(const char *name, const std::vector<std::int32_t> &values)
+{
+    const std::size_t count = values.size();
+    std::vector<std::byte> encoded(count * varint::MAX_VARINT_SIZE + 8);
+    std::size_t encodedSize = varint::encodeArray(values.data(), count, encoded.data());
+    std::vector<std::int32_t> decoded(count);
+
+    std::printf("-- %zu VarInts, %s (%zu bytes)\n", count, name, encodedSize);
+
+    bench::run("size (MemoryStream)", 5, 0, [&]()
+               {
+        std::size_t total = 0;
+        for (std::int32_t value : values)
+            total += streamSize(value);
+        bench::keep(total); });
+    bench::run("size (varint::size)", 50, 0, [&]()
+               {
+        std::size_t total = 0;
+        for (std::int32_t value : values)
+            total += varint::size(value);
+        bench::keep(total); });
+
+    bench::run("encode (loop)", 50, encodedSize, [&]()
+               {
+        std::size_t written = 0;
+        for (std::int32_t value : values)
+            written += loopEncode(value, encoded.data() + written);
+        bench::keep(written); });
+    bench::run("encode (varint::encodeArray)", 50, encodedSize, [&]()
+               { bench::keep(varint::encodeArray(values.data(), count, encoded.data())); });
+
+    bench::run("decode (loop)", 50, encodedSize, [&]()
+               {
+        std::size_t read = 0;
+        for (std::size_t i = 0; i < count; i++)
+            read += loopDecode(encoded.data() + read, encodedSize - read, decoded[i]);
+        bench::keep(read); });
+    bench::run("decode (varint::decodeArray)", 50, encodedSize, [&]()
+               { bench::keep(varint::decodeArray(encoded.data(), encodedSize, decoded.data(), count)); });
+
+    MemoryStream stream;
+    stream.reserve(encodedSize);
+    bench::run("IMCStream::writeVarInt (before)", 20, encodedSize, [&]()
+               {
+        stream.clear();
+        for (std::int32_t value : values)
+        {
+            std::byte buffer[varint::MAX_VARINT_SIZE];
+            std::size_t size = loopEncode(value, buffer);
+            for (std::size_t i = 0; i < size; i++)
+                stream.writeByte(static_cast<std::int8_t>(buffer[i]));
+        }
+        bench::keep(stream.getData().size()); });
+    bench::run("IMCStream::writeVarInt", 20, encodedSize, [&]()
+               {
+        stream.clear();
+        for (std::int32_t value : values)
+            stream.writeVarInt(value);
+        bench::keep(stream.getData().size()); });
+    bench::run("IMCStream::writeVarInts", 20, encodedSize, [&]()
+               {
+        stream.clear();
+        stream.writeVarInts(values.data(), count);
+        bench::keep(stream.getData().size()); });
+}
+
+int main()
+{
+    constexpr std::size_t COUNT = 1 << 18;
+    std::mt19937 random(42);
+
+    // Every size equally likely, defeats branch prediction
+    std::vector<std::int32_t> values(COUNT);
+    for (auto &value : values)
+        value = static_cast<std::int32_t>(random() >> (random() % 32));
+    runAll("mixed sizes", values);
+
+    // Like ids, lengths and small coordinates
+    for (auto &value : values)
+        value = static_cast<std::int32_t>(random() % 8 == 0 ? random() % 16384 : random() % 128);
+    runAll("mostly 1 byte", values);
+
+    return 0;
+}
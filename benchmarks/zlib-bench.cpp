@@ -0,0 +1,115 @@
+/**
+ * @file zlib-bench.cpp
+ * @author Lygaen
+ * @brief The file benchmarking the ZLib compressor
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <bench.hpp>
+#include <utils/crypto.h>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * @brief Previous compression, with a new zlib state per call
+ *
+ * @param level the compression level
+ * @param data the data to compress
+ * @param len the length of @p data
+ * @param out the output buffer
+ * @param outLen the length of @p out
+ * @return int the compressed length
+ */
+int initCompress(int level, const std::byte *data, size_t len, std::byte *out, size_t outLen)
+{
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+
+    if (deflateInit(&stream, level) != Z_OK)
+        throw std::runtime_error("Failed to initialize ZLib");
+
+    stream.avail_in = len;
+    stream.next_in = (Bytef *)data;
+    stream.avail_out = outLen;
+    stream.next_out = (Bytef *)out;
+
+    do
+        deflate(&stream, Z_SYNC_FLUSH);
+    while (stream.avail_out == 0);
+    while (deflate(&stream, Z_FINISH) != Z_STREAM_END)
+        ;
+
+    deflateEnd(&stream);
+    return stream.total_out;
+}
+
+/**
+ * @brief Previous uncompression, with a new zlib state per call
+ *
+ * @param data the data to uncompress
+ * @param len the length of @p data
+ * @param out the output buffer
+ * @param outLen the length of @p out
+ * @return int the uncompressed length
+ */
+int initUncompress(const std::byte *data, size_t len, std::byte *out, size_t outLen)
+{
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+
+    if (inflateInit(&stream) != Z_OK)
+        throw std::runtime_error("Failed to initialize ZLib");
+
+    stream.avail_in = len;
+    stream.next_in = (Bytef *)data;
+    stream.avail_out = outLen;
+    stream.next_out = (Bytef *)out;
+
+    do
+        inflate(&stream, Z_NO_FLUSH);
+    while (stream.avail_in != 0);
+
+    inflateEnd(&stream);
+    return stream.total_out;
+}
+
+int main()
+{
+    const int level = -1;
+
+    for (std::size_t size : {1024, 16384, 65536})
+    {
+        // Compressible like most game packets
+        std::vector<std::byte> data(size);
+        for (std::size_t i = 0; i < size; i++)
+            data[i] = std::byte(i % 64 < 48 ? 0 : (i * 31) & 0xFF);
+
+        std::vector<std::byte> compressed(2 * size + 64);
+        std::vector<std::byte> uncompressed(size);
+        std::size_t iterations = 64 * 1024 * 1024 / size / 16 + 100;
+        std::printf("-- %zu bytes payloads\n", size);
+
+        bench::run("compress (state per call)", iterations, size, [&]()
+                   { bench::keep(initCompress(level, data.data(), size, compressed.data(), compressed.size())); });
+
+        crypto::ZLibCompressor comp(level);
+        int compressedLen = 0;
+        bench::run("compress (reset state)", iterations, size, [&]()
+                   { compressedLen = comp.compress(data.data(), size, compressed.data(), compressed.size()); });
+
+        bench::run("uncompress (state per call)", iterations, size, [&]()
+                   { bench::keep(initUncompress(compressed.data(), compressedLen, uncompressed.data(), size)); });
+        bench::run("uncompress (reset state)", iterations, size, [&]()
+                   { bench::keep(comp.uncompress(compressed.data(), compressedLen, uncompressed.data(), size)); });
+    }
+
+    return 0;
+}
@@ -18,34 +18,75 @@
 #include <net/packets/login/encryptionexchange.h>
 #include <net/packets/login/setcompression.h>
 #include <net/packets/play/disconnect.h>
+#include <net/reactor.h>
+#include <net/compressionpool.h>
+#include <net/logincrypto.h>
+#include <net/sessioncache.h>
 #include <plugins/events/clientevents.hpp>
 #include <plugins/event.h>
-
-Client::Client(const ClientSocket& sock) : isRunning(), state(ClientState::HANDSHAKE), sock(sock), stream(new NetSocketStream(sock))
+#include <atomic>
+
+static std::atomic<std::uint64_t> nextClientId(0);
+
+Client::Client(const ClientSocket &sock, Reactor &reactor) : sock(sock),
+                                                             reactor(reactor),
+                                                             id(nextClientId++),
+                                                             socketStream(new NetSocketStream(sock)),
+                                                             stream(socketStream),
+                                                             frames(socketStream),
+                                                             running(true),
+                                                             state(ClientState::HANDSHAKE),
+                                                             authenticating(false),
+                                                             decrypting(false)
 {
+    socketStream->getQueue().setBudget(std::max(OutboundQueue::HIGH_WATERMARK, (std::size_t)Config::inst()->SEND_BUFFER_LIMIT.getValue()));
+
     ClientConnectedEvent connectedEvent;
     EventsManager::inst()->fire(connectedEvent);
 }
 
 Client::~Client()
 {
-    if (!stream)
-        return;
-    delete stream;
+    delete socketStream;
 }
 
-void Client::loop()
+void Client::onReadable()
 {
-    int32_t len = stream->readVarInt();
-    if (len == 0xFE && state == ClientState::HANDSHAKE)
+    try
     {
-        close("Connection prior to 1.7");
-        return;
+        // Everything sent while handling is coalesced, see Client::flush()
+        socketStream->cork();
+        frames.fill();
+
+        PacketView packet;
+        // Data after an encryption response can only be read once it is decrypted
+        while (running && !decrypting)
+        {
+            if (state == ClientState::HANDSHAKE && frames.isLegacyPing())
+            {
+                close("Connection prior to 1.7");
+                return;
+            }
+
+            if (!frames.next(packet))
+                break;
+            loop(packet);
+        }
     }
+    catch (const std::exception &err)
+    {
+        if (state == ClientState::HANDSHAKE)
+            logger::error("Connection seems not minecrafty or protocol is too old");
+        logger::error("Client ended badly : %s", err.what());
+        close(err.what());
+    }
+}
 
-    int32_t id = stream->readVarInt();
+void Client::loop(PacketView &packet)
+{
+    int32_t id = packet.readVarInt();
 
-    logger::debug("C->S Len:%d Id:%d", len, id);
+    logger::debug("C->S Len:%d Id:%d", packet.getSize(), id);
 
     switch (state)
     {
@@ -59,7 +100,7 @@ void Client::loop()
         }
 
         HandshakePacket handshake;
-        handshake.read(stream);
+        handshake.read(packet);
 
         state = handshake.nextState;
 
@@ -80,14 +121,14 @@ void Client::loop()
             ServerListPacket serverlist;
             ClientStatusEvent statusEvent(&serverlist);
             EventsManager::inst()->fire(statusEvent);
-            serverlist.send(stream);
+            serverlist.sendCached(&stream);
             break;
         }
         case 0x01:
         {
             PingPongPacket pingpong;
-            pingpong.read(stream);
-            pingpong.send(stream);
+            pingpong.read(packet);
+            pingpong.send(&stream);
 
             logger::debug("Finished Server List Ping !");
             close("Ping Protocol finished");
@@ -103,12 +144,19 @@ void Client::loop()
     }
     case ClientState::LOGIN:
     {
+        if (authenticating)
+        {
+            // Nothing is expected until the login succeeds
+            close("Unexpected packet while authenticating");
+            return;
+        }
+
         switch (id)
         {
         case 0x00:
         {
             LoginStart loginStart;
-            loginStart.read(stream);
+            loginStart.read(packet);
 
             player.name = loginStart.name;
             if (!Config::inst()->ONLINE_MODE.getValue())
@@ -121,46 +169,24 @@ void Client::loop()
             verifyToken = crypto::randomSecure(sizeof(verifyToken));
 
             EncryptionRequest request(verifyToken.get(), sizeof(verifyToken));
-            request.send(stream);
+            request.send(&stream);
             break;
         }
         case 0x01:
         {
-            EncryptionResponse response;
-            response.read(stream);
-
-            if (response.verifyTokenLength != sizeof(verifyToken) ||
-                !std::equal(response.verifyToken.get(), response.verifyToken.get() + response.verifyTokenLength, verifyToken.get()))
-            {
-                close("Invalid verify token");
-                return;
-            }
-            stream = new CipherStream(stream, response.sharedSecret.get(), response.sharedSecret.get());
-
-            crypto::MinecraftHash hash;
-            hash.update("");
-            hash.update(std::string((const char *)response.sharedSecret.get(), response.sharedSecretLength));
-
-            int outLen;
-            std::unique_ptr<std::byte[]> b = crypto::getPublicRSAKey(&outLen);
-            hash.update(std::string((const char *)b.get(), outLen));
-
-            mojangapi::HasJoinedResponse hasJoined;
-            if (Config::inst()->PREVENT_PROXY_CONNECTIONS.getValue() && !sock.isLocal())
-            {
-                hasJoined = mojangapi::hasJoined(player.name, hash.finalize(), sock.getAddress());
-            }
-            else
-            {
-                hasJoined = mojangapi::hasJoined(player.name, hash.finalize());
-            }
-
-            if (player.name != hasJoined.name)
-                close("Invalid joining name");
-
-            player.uuid = hasJoined.id;
-
-            initiatePlayerJoin();
+            std::span<const std::byte> secret = packet.readByteArray();
+            std::span<const std::byte> token = packet.readByteArray();
+            LoginCrypto::Request request{std::vector<std::byte>(secret.begin(), secret.end()),
+                                         std::vector<std::byte>(token.begin(), token.end())};
+
+            // The login resumes on this thread once the response is decrypted
+            decrypting = true;
+            Reactor *owner = &reactor;
+            socket_t handle = sock.getHandle();
+            std::uint64_t clientId = this->id;
+            LoginCrypto::inst().submit(std::move(request), [owner, handle, clientId](const LoginCrypto::Result &result)
+                                       { owner->post(handle, clientId, [result](Client &client)
+                                                     { client.onLoginDecrypted(result); }); });
             return;
         }
         default:
@@ -179,18 +205,142 @@ void Client::loop()
     }
 }
 
+void Client::onLoginDecrypted(const LoginCrypto::Result &result)
+{
+    decrypting = false;
+    if (!running)
+        return;
+
+    socketStream->cork();
+
+    if (!result.decrypted)
+    {
+        close(result.error);
+        return;
+    }
+
+    if (result.verifyToken.size() != sizeof(verifyToken) ||
+        !std::equal(result.verifyToken.begin(), result.verifyToken.end(), verifyToken.get()))
+    {
+        close("Invalid verify token");
+        return;
+    }
+    if (result.sharedSecret.size() != 16)
+    {
+        close("Invalid shared secret");
+        return;
+    }
+    stream.enableEncryption(result.sharedSecret.data());
+    // Anything received after the response was already encrypted
+    frames.enableEncryption(result.sharedSecret.data());
+
+    // The session server only checks the address of the player
+    // when asked to, only then can the address be trusted again
+    std::string ip;
+    if (Config::inst()->PREVENT_PROXY_CONNECTIONS.getValue() && !sock.isLocal())
+    {
+        ip = sock.getAddress();
+
+        // Reconnecting players were verified from this very address moments ago
+        SessionClient::Result cached;
+        if (SessionCache::inst().find(player.name, ip, cached.response))
+        {
+            cached.joined = true;
+            onSessionVerified(cached);
+            return;
+        }
+    }
+
+    // The login resumes on this thread once the session server answered
+    authenticating = true;
+    Reactor *owner = &reactor;
+    socket_t handle = sock.getHandle();
+    std::uint64_t clientId = this->id;
+    std::string name = player.name;
+    SessionClient::inst().hasJoined(player.name, result.serverId, ip, [owner, handle, clientId, name, ip](const SessionClient::Result &result)
+                                    {
+        if (result.joined && result.response.name == name && !ip.empty())
+            SessionCache::inst().store(name, ip, result.response);
+        owner->post(handle, clientId, [result](Client &client)
+                    { client.onSessionVerified(result); }); });
+}
+
+void Client::onSessionVerified(const SessionClient::Result &result)
+{
+    authenticating = false;
+    if (!running)
+        return;
+
+    socketStream->cork();
+
+    if (!result.joined)
+    {
+        close(result.error);
+        return;
+    }
+
+    if (player.name != result.response.name)
+    {
+        close("Invalid joining name");
+        return;
+    }
+
+    player.uuid = result.response.id;
+
+    try
+    {
+        initiatePlayerJoin();
+    }
+    catch (const std::exception &err)
+    {
+        logger::error("Client ended badly : %s", err.what());
+        close(err.what());
+    }
+}
+
+void Client::onCompressed(std::uint64_t ticket, std::vector<std::byte> &frame)
+{
+    // Closed clients still send it, the disconnect packet may be held back behind it
+    socketStream->cork();
+
+    try
+    {
+        stream.completeOffload(ticket, frame);
+    }
+    catch (const std::exception &err)
+    {
+        logger::error("Client ended badly : %s", err.what());
+        running = false;
+    }
+}
+
 void Client::initiatePlayerJoin()
 {
     if (Config::inst()->COMPRESSION_LVL.getValue() != 0 && !sock.isLocal())
     {
         SetCompression comp(Config::inst()->COMPRESSION_THRESHOLD.getValue());
-        comp.send(stream);
+        comp.send(&stream);
+
+        stream.enableCompression(Config::inst()->COMPRESSION_LVL.getValue(), Config::inst()->COMPRESSION_THRESHOLD.getValue(), CompressionPolicy::inst());
+        frames.enableCompression(Config::inst()->COMPRESSION_THRESHOLD.getValue());
 
-        stream = new ZLibStream(stream, Config::inst()->COMPRESSION_LVL.getValue(), Config::inst()->COMPRESSION_THRESHOLD.getValue());
+        if (Config::inst()->COMPRESSION_WORKERS.getValue() > 0)
+        {
+            // Workers compress without any threshold, smaller packets must stay here
+            std::size_t offloadSize = std::max(1, std::max(Config::inst()->COMPRESSION_OFFLOAD_SIZE.getValue(),
+                                                           Config::inst()->COMPRESSION_THRESHOLD.getValue()));
+            Reactor *owner = &reactor;
+            socket_t handle = sock.getHandle();
+            std::uint64_t clientId = id;
+            stream.enableOffload(offloadSize, [owner, handle, clientId](std::uint64_t ticket, const std::byte *packet, std::size_t len)
+                                 { return CompressionPool::inst().submit(std::vector<std::byte>(packet, packet + len), [owner, handle, clientId, ticket](std::vector<std::byte> &frame)
+                                                                         { owner->post(handle, clientId, [ticket, frame = std::move(frame)](Client &client) mutable
+                                                                                       { client.onCompressed(ticket, frame); }); }); });
+        }
     }
 
     LoginSuccess loginSuccess(player.name, player.uuid);
-    loginSuccess.send(stream);
+    loginSuccess.send(&stream);
 
     state = ClientState::PLAY;
 
@@ -198,42 +348,38 @@ void Client::initiatePlayerJoin()
     close("Not yet implemented");
 }
 
-void Client::start()
+bool Client::flush()
 {
-    isRunning = true;
-    state = ClientState::HANDSHAKE;
-
     try
     {
-        while (isRunning)
-        {
-            loop();
-
-            stream->flush();
-        }
+        socketStream->flush();
     }
     catch (const std::exception &err)
     {
-        if (state == ClientState::HANDSHAKE)
-            logger::error("Connection seems not minecrafty or protocol is too old");
-        logger::error("Client ended badly : %s", err.what());
-        close(err.what());
+        running = false;
+        logger::debug("Connection closed : %s", err.what());
+        return true;
     }
+
+    OutboundQueue &queue = socketStream->getQueue();
+    if (queue.isOverflowed() && running)
+        close("Send buffer limit exceeded");
+    return queue.empty();
 }
 
 void Client::close(const std::string &reason)
 {
-    isRunning = false;
+    running = false;
 
     if (state == ClientState::LOGIN)
     {
         DisconnectLogin disconnect(reason);
-        disconnect.send(stream);
+        disconnect.send(&stream);
     }
     else if (state == ClientState::PLAY)
     {
         DisconnectPlay disconnect(reason);
-        disconnect.send(stream);
+        disconnect.send(&stream);
     }
 
     // sock.close();
@@ -13,31 +13,49 @@
 #define MINESERVER_CLIENT_H
 
 #include <net/stream.h>
+#include <net/framedecoder.h>
+#include <net/pipeline.h>
+#include <net/session.h>
+#include <net/logincrypto.h>
 #include <types/clientstate.h>
 #include <entities/player.h>
 #include <types/uuid.h>
+#include <cstdint>
+
+class Reactor;
 
 /**
  * @brief Client class
  *
  * Class that wraps around a socket and does
  * all of the client handling.
+ * It never blocks waiting for data : the ::Reactor
+ * calls Client::onReadable() when bytes come in,
+ * and packets are only handled once they were
+ * fully received.
  */
 class Client
 {
 private:
     ClientSocket sock;
-    IMCStream *stream;
-    bool isRunning;
+    Reactor &reactor;
+    std::uint64_t id;
+    NetSocketStream *socketStream;
+    PipelineStream stream;
+    FrameDecoder frames;
+    bool running;
     ClientState state;
+    bool authenticating;
+    bool decrypting;
     std::unique_ptr<std::byte[]> verifyToken;
     Player player;
 
     /**
      * @brief Single packet loop
      *
+     * @param packet the received packet id and data
      */
-    void loop();
+    void loop(PacketView &packet);
 
     /**
      * @brief Makes player join server
@@ -45,6 +63,25 @@ private:
      * Makes the current player join the server.
      */
     void initiatePlayerJoin();
+    /**
+     * @brief Resumes the login once the encryption response was decrypted
+     *
+     * @param result the decrypted response
+     */
+    void onLoginDecrypted(const LoginCrypto::Result &result);
+    /**
+     * @brief Resumes the login once the session server answered
+     *
+     * @param result the result of the verification
+     */
+    void onSessionVerified(const SessionClient::Result &result);
+    /**
+     * @brief Sends a packet once a compression worker compressed it
+     *
+     * @param ticket the ticket of the packet
+     * @param frame the compressed frame
+     */
+    void onCompressed(std::uint64_t ticket, std::vector<std::byte> &frame);
 
 public:
     /**
@@ -52,8 +89,9 @@ public:
      *
      * Wraps around a client socket to handle it.
      * @param sock the socket to wrap around
+     * @param reactor the reactor running the client
      */
-    Client(const ClientSocket& sock);
+    Client(const ClientSocket &sock, Reactor &reactor);
     /**
      * @brief Destroy the Client object
      *
@@ -61,10 +99,71 @@ public:
     ~Client();
 
     /**
-     * @brief Starts the client, blocking
+     * @brief Handles incoming data, non-blocking
+     *
+     * Reads what is pending on the socket and
+     * handles every packet that was fully received.
+     * Packets sent meanwhile are held back until
+     * Client::flush().
+     */
+    void onReadable();
+    /**
+     * @brief Sends what the client has to send, non-blocking
+     *
+     * Sends the packets held back while handling data and
+     * whatever the socket could not take before. Closes the
+     * client if its send buffer limit was exceeded.
+     * @return true everything was sent
+     * @return false some data is still waiting for the socket
+     */
+    bool flush();
+    /**
+     * @brief Whether sent data is waiting for the socket
+     *
+     * @return true some data is waiting
+     * @return false everything was sent
+     */
+    bool hasPendingWrites()
+    {
+        return !socketStream->getQueue().empty();
+    }
+    /**
+     * @brief Whether packets are still being compressed by the workers
      *
+     * Closed clients are kept until they are sent.
+     * @return true some packets are being compressed
+     * @return false every packet was sent
      */
-    void start();
+    bool hasPendingOffloads() const
+    {
+        return stream.hasPendingOffloads();
+    }
+    /**
+     * @brief Whether the client is too slow to take its data
+     *
+     * Non essential packets should not be sent to
+     * a congested client (see OutboundQueue::isCongested()).
+     * Packets waiting for the compression workers count too.
+     * @return true the client is congested
+     * @return false the client is not congested
+     */
+    bool isCongested()
+    {
+        return socketStream->getQueue().isCongested() || stream.getDeferredSize() >= OutboundQueue::HIGH_WATERMARK;
+    }
+    /**
+     * @brief Whether the client should be read from
+     *
+     * Congested clients would only get more to send, and
+     * what is sent after an encryption response can not
+     * be read before it is decrypted, it would only pile up.
+     * @return true the client is read from
+     * @return false it is not, until this changes
+     */
+    bool isReading()
+    {
+        return running && !decrypting && !isCongested();
+    }
     /**
      * @brief Stops the client
      *
@@ -74,6 +173,39 @@ public:
      *@param reason the reason for closing the connection
      */
     void close(const std::string &reason = "");
+
+    /**
+     * @brief Whether the client is still running
+     *
+     * @return true the client is running
+     * @return false the client was closed
+     */
+    bool isRunning() const
+    {
+        return running;
+    }
+
+    /**
+     * @brief Get the Socket of the client
+     *
+     * @return const ClientSocket& the socket
+     */
+    const ClientSocket &getSocket() const
+    {
+        return sock;
+    }
+
+    /**
+     * @brief Get the id of the client
+     *
+     * Unique for the lifetime of the server, unlike
+     * the handle of its socket.
+     * @return std::uint64_t the id
+     */
+    std::uint64_t getId() const
+    {
+        return id;
+    }
 };
 
 #endif // MINESERVER_CLIENT_H
\ No newline at end of file
@@ -1,10 +1,11 @@
 #include "commands.h"
 #include <utils/logger.h>
 #include <cmd/commandsreg.hpp>
+#include <plugins/executor.h>
 #include <utility>
 
 CommandsManager *CommandsManager::instance = nullptr;
-CommandsManager::CommandsManager() : commands()
+CommandsManager::CommandsManager() : commands(), commandsLock()
 {
     if (instance)
         throw std::runtime_error("Commands handler should not be constructed twice");
@@ -22,29 +23,37 @@ CommandsManager::~CommandsManager()
 
 static std::regex nameRegex("[a-z][a-z-A-Z]+");
 
-void CommandsManager::addCommand(const std::string &name, Command::HandlerType handler,
+bool CommandsManager::addCommand(const std::string &name, Command::HandlerType handler,
                                  const std::string &usage, const std::string &description)
 {
     if (name.empty() || !std::regex_match(name, nameRegex))
     {
         logger::warn("Could not register command '%s'", name.c_str());
         logger::debug("Command name '%s' doesn't match name regex '[a-z][a-z-A-Z]+'", name.c_str());
-        return;
+        return false;
     }
 
+    std::lock_guard<std::mutex> guard(commandsLock);
     if (commands.contains(name))
     {
         logger::warn("Command '%s' is already registered", name.c_str());
-        return;
+        return false;
     }
 
-    Command c;
-    c.name = name;
-    c.usage = usage;
-    c.description = description;
-    c.handler = handler;
+    auto c = std::make_shared<Command>();
+    c->name = name;
+    c->usage = usage;
+    c->description = description;
+    c->handler = std::move(handler);
 
-    commands[name] = c;
+    commands[name] = std::move(c);
+    return true;
+}
+
+void CommandsManager::removeCommand(const std::string &name)
+{
+    std::lock_guard<std::mutex> guard(commandsLock);
+    commands.erase(name);
 }
 
 CommandsManager::CallCommandError CommandsManager::callCommand(const ISender::SenderType type, ISender *sender, std::string commandString)
@@ -76,17 +85,21 @@ CommandsManager::CallCommandError CommandsManager::callCommand(const ISender::Se
     if (!std::regex_match(name, nameRegex))
         return CommandsManager::FORMAT;
 
-    if (!commands.contains(name))
-        return CommandsManager::COMMAND_NOT_FOUND;
-
-    Command &cmd = commands[name];
+    std::shared_ptr<const Command> cmd;
+    {
+        std::lock_guard<std::mutex> guard(commandsLock);
+        auto it = commands.find(name);
+        if (it == commands.end())
+            return CommandsManager::COMMAND_NOT_FOUND;
+        cmd = it->second;
+    }
     try
     {
-        cmd.handler(type, *sender, args);
+        cmd->handler(type, *sender, args);
     }
     catch (const std::exception &err)
     {
-        logger::error("Command '%s' errored : %s", cmd.name.c_str(), err.what());
+        logger::error("Command '%s' errored : %s", cmd->name.c_str(), err.what());
         logger::debug("Command context : command (%s), sender type (%d)", commandString.c_str(), (int)type);
         return CommandsManager::RUNTIME_ERROR;
     }
@@ -94,6 +107,39 @@ CommandsManager::CallCommandError CommandsManager::callCommand(const ISender::Se
     return CommandsManager::NONE;
 }
 
+void CommandsManager::addLuaCommand(const std::string &name, const luabridge::LuaRef &ref,
+                                    const std::string &usage, const std::string &description)
+{
+    auto callback = std::make_shared<luabridge::LuaRef>(ref);
+    std::shared_ptr<PluginExecutor> executor = PluginExecutor::of(ref.state());
+
+    if (!executor)
+    {
+        addCommand(name, [callback](const ISender::SenderType senderType, ISender &sender, const std::vector<std::string> &args)
+                   { luabridge::call(*callback, senderType, sender, args); }, usage, description);
+        return;
+    }
+
+    // Only used on the executor, which is stopped before the ref is released
+    luabridge::LuaRef *function = callback.get();
+    std::weak_ptr<PluginExecutor> weak = executor;
+    bool added = addCommand(name, [weak, function](const ISender::SenderType senderType, ISender &sender, const std::vector<std::string> &args)
+                            {
+        auto executor = weak.lock();
+        if (!executor)
+            throw std::runtime_error("plugin was unloaded");
+
+        ISender *target = &sender;
+        if (!executor->call([function, senderType, target, args]()
+                            { luabridge::call(*function, senderType, *target, args); }))
+            throw std::runtime_error("plugin did not handle it in time"); }, usage, description);
+
+    // Holds the ref until the plugin is unloaded
+    if (added)
+        executor->onUnload([name, callback]()
+                           { CommandsManager::inst().removeCommand(name); });
+}
+
 void CommandsManager::loadLua(lua_State *state, const char *namespaceName)
 {
     luabridge::getGlobalNamespace(state)
@@ -104,11 +150,13 @@ void CommandsManager::loadLua(lua_State *state, const char *namespaceName)
                     if (!ref.isFunction())
                         return;
 
-                    CommandsManager::inst().addCommand(name, [ref](const ISender::SenderType senderType, ISender & sender, const std::vector<std::string> & args) {
-                        luabridge::call(ref, senderType, sender, args);
-                    }, usage, description); })
+                    CommandsManager::inst().addLuaCommand(name, ref, usage, description); })
         .addFunction("getCommands", []()
-                     { return CommandsManager::inst().getCommands(); })
+                     {
+                    std::unordered_map<std::string, Command> commands;
+                    for (auto &kv : CommandsManager::inst().getCommands())
+                        commands[kv.first] = *kv.second;
+                    return commands; })
         .endNamespace();
 }
 
@@ -13,6 +13,7 @@
 
 #include <unordered_map>
 #include <memory>
+#include <mutex>
 #include <functional>
 #include <string>
 #include <regex>
@@ -137,7 +138,10 @@ struct Command
 class CommandsManager
 {
 private:
-    std::unordered_map<std::string, Command> commands;
+    // Shared so that calling a command never copies its handler
+    std::unordered_map<std::string, std::shared_ptr<const Command>> commands;
+    // Plugins add and remove commands while the console calls them
+    std::mutex commandsLock;
 
     static CommandsManager *instance;
 
@@ -161,19 +165,42 @@ public:
      * @param handler Command::handler
      * @param usage Command::usage
      * @param description Command::description
+     * @return true the command was added
+     * @return false its name is invalid or already registered
      */
-    void addCommand(const std::string &name,
+    bool addCommand(const std::string &name,
                     Command::HandlerType handler,
                     const std::string &usage = "",
                     const std::string &description = "");
+    /**
+     * @brief Removes a command
+     *
+     * @param name see Command::name
+     */
+    void removeCommand(const std::string &name);
+    /**
+     * @brief Adds a command handled by a lua function
+     *
+     * The function is called on the executor of the plugin
+     * owning it, up to the plugin timeout. The command is
+     * removed when the plugin is unloaded, and the function
+     * only released then, once its executor is stopped.
+     * @param name see Command::name
+     * @param ref the lua function
+     * @param usage Command::usage
+     * @param description Command::description
+     */
+    void addLuaCommand(const std::string &name, const luabridge::LuaRef &ref,
+                       const std::string &usage, const std::string &description);
 
     /**
      * @brief Get all registered commands
      *
-     * @return const std::unordered_map<std::string, Command>& commands as map, key for command name
+     * @return std::unordered_map<std::string, std::shared_ptr<const Command>> commands as map, key for command name
      */
-    const std::unordered_map<std::string, Command> &getCommands() const
+    std::unordered_map<std::string, std::shared_ptr<const Command>> getCommands()
     {
+        std::lock_guard<std::mutex> guard(commandsLock);
         return commands;
     }
 
@@ -15,7 +15,11 @@
 #include <cmd/commands.h>
 #include <utils/config.h>
 #include <plugins/plugins.h>
+#include <utils/metrics.h>
 #include <server.h>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
 
 /**
  * @brief Handler for help message
@@ -37,7 +41,7 @@ void helpMessage(const ISender::SenderType senderType, ISender &sender, const st
 
     for (auto &kv : mapCommands)
     {
-        Command &command = kv.second;
+        const Command &command = *kv.second;
         finalString += "/" + command.name + " " + command.usage + "\n";
         finalString += command.description + "\n";
     }
@@ -83,6 +87,91 @@ void pluginsMessage(const ISender::SenderType senderType, ISender &sender, const
     sender.sendMessage(finalString);
 }
 
+/**
+ * @brief Handler for stats message
+ *
+ * @param senderType sender type
+ * @param sender the actual sender
+ * @param args all of the args
+ */
+void statsMessage(const ISender::SenderType senderType, ISender &sender, const std::vector<std::string> &args)
+{
+    (void)senderType;
+    if (args.size() > 1)
+    {
+        sender.sendMessage(ChatMessage("/stats only accepts a metric prefix as argument !"));
+        return;
+    }
+
+    auto metrics = MetricsManager::inst().collect(args.empty() ? "" : args[0]);
+    if (metrics.empty())
+    {
+        sender.sendMessage(ChatMessage("No metrics found"));
+        return;
+    }
+
+    std::string finalString;
+    char value[32];
+
+    for (const auto &kv : metrics)
+    {
+        std::snprintf(value, sizeof(value), "%.15g", kv.second);
+        finalString += kv.first + ": " + value + "\n";
+    }
+
+    finalString.pop_back();
+    sender.sendMessage(finalString);
+}
+
+/**
+ * @brief Handler for top message
+ *
+ * @param senderType sender type
+ * @param sender the actual sender
+ * @param args all of the args
+ */
+void topMessage(const ISender::SenderType senderType, ISender &sender, const std::vector<std::string> &args)
+{
+    (void)senderType;
+    std::size_t count = 10;
+    if (args.size() > 1 || (args.size() == 1 && std::sscanf(args[0].c_str(), "%zu", &count) != 1))
+    {
+        sender.sendMessage(ChatMessage("/top only accepts a number of plugins as argument !"));
+        return;
+    }
+
+    std::vector<std::shared_ptr<PluginExecutor>> executors;
+    for (const auto &plugin : PluginsManager::inst().getPlugins())
+        executors.push_back(plugin->getExecutor());
+
+    if (executors.empty())
+    {
+        sender.sendMessage(ChatMessage("No plugins registered"));
+        return;
+    }
+
+    std::sort(executors.begin(), executors.end(), [](const auto &a, const auto &b)
+              { return a->getCPUTime() > b->getCPUTime(); });
+    executors.resize(std::min(count, executors.size()));
+
+    std::string finalString;
+    char line[256];
+
+    for (const auto &executor : executors)
+    {
+        double calls = (double)executor->getHandled();
+        std::snprintf(line, sizeof(line), "%s: %.1f ms CPU, %.0f calls (%.3f ms avg), %llu slow, %llu stopped, %llu timeouts\n",
+                      executor->getName().c_str(), executor->getCPUTime(), calls,
+                      calls == 0 ? 0 : executor->getCPUTime() / calls,
+                      (unsigned long long)executor->getSlow(), (unsigned long long)executor->getAborted(),
+                      (unsigned long long)executor->getTimeouts());
+        finalString += line;
+    }
+
+    finalString.pop_back();
+    sender.sendMessage(finalString);
+}
+
 /**
  * @brief Register commands for the console and general usage
  *
@@ -102,6 +191,14 @@ void registerCommands()
         "plugins", std::ref(pluginsMessage),
         "", "Shows a list of installed plugins");
 
+    CommandsManager::inst().addCommand(
+        "stats", std::ref(statsMessage),
+        "[prefix]", "Shows the server metrics, optionally only those starting with prefix");
+
+    CommandsManager::inst().addCommand(
+        "top", std::ref(topMessage),
+        "[count]", "Shows the plugins that spent the most CPU time handling events");
+
     Config::inst()->registerCommands();
 }
 
@@ -26,6 +26,10 @@ int main()
 
     std::signal(SIGINT, [](int signal)
                 { (void) signal; Server::inst()->stop(); });
+#if defined(__linux__)
+    // Writing to a TLS connection closed by its peer must fail, not kill the server
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
 
     server.start();
     return 0;
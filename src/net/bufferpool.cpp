@@ -0,0 +1,65 @@
+/**
+ * @file bufferpool.cpp
+ * @author Lygaen
+ * @brief The file containing the logic of the pool of packet buffers
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "bufferpool.h"
+#include <atomic>
+#include <vector>
+
+static std::atomic<std::uint64_t> poolAllocations = 0;
+
+/**
+ * @brief Buffers of the current thread
+ *
+ */
+static thread_local std::vector<std::unique_ptr<MemoryStream>> threadBuffers;
+
+PooledBuffer::PooledBuffer(std::unique_ptr<MemoryStream> stream) : stream(std::move(stream))
+{
+    capacity = this->stream->capacity();
+}
+
+PooledBuffer::~PooledBuffer()
+{
+    bool grew = stream->capacity() != capacity;
+    PacketBufferPool::release(std::move(stream), grew);
+}
+
+PooledBuffer PacketBufferPool::acquire()
+{
+    if (threadBuffers.empty())
+    {
+        auto stream = std::make_unique<MemoryStream>();
+        stream->reserve(INITIAL_CAPACITY);
+        poolAllocations++;
+        return PooledBuffer(std::move(stream));
+    }
+
+    std::unique_ptr<MemoryStream> stream = std::move(threadBuffers.back());
+    threadBuffers.pop_back();
+    return PooledBuffer(std::move(stream));
+}
+
+std::uint64_t PacketBufferPool::allocations()
+{
+    return poolAllocations;
+}
+
+void PacketBufferPool::release(std::unique_ptr<MemoryStream> stream, bool grew)
+{
+    if (grew)
+        poolAllocations++;
+
+    if (threadBuffers.size() >= MAX_POOLED || stream->capacity() > MAX_RETAINED_CAPACITY)
+        return;
+
+    stream->clear();
+    threadBuffers.push_back(std::move(stream));
+}
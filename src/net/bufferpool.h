@@ -0,0 +1,113 @@
+/**
+ * @file bufferpool.h
+ * @author Lygaen
+ * @brief The file containing the pool of packet buffers
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MINESERVER_BUFFERPOOL_H
+#define MINESERVER_BUFFERPOOL_H
+
+#include <net/stream.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief Buffer borrowed from the PacketBufferPool
+ *
+ * Gives the buffer back to the pool of the
+ * thread when destroyed, keeping its memory.
+ */
+class PooledBuffer
+{
+private:
+    std::unique_ptr<MemoryStream> stream;
+    std::size_t capacity;
+
+public:
+    /**
+     * @brief Construct a new Pooled Buffer object
+     *
+     * @param stream the cleared buffer
+     */
+    PooledBuffer(std::unique_ptr<MemoryStream> stream);
+    /**
+     * @brief Destroy the Pooled Buffer object
+     *
+     * Gives back the buffer to the pool.
+     */
+    ~PooledBuffer();
+
+    PooledBuffer(const PooledBuffer &) = delete;
+    PooledBuffer &operator=(const PooledBuffer &) = delete;
+
+    /**
+     * @brief Get the buffer
+     *
+     * @return MemoryStream& the buffer, cleared
+     */
+    MemoryStream &get()
+    {
+        return *stream;
+    }
+};
+
+/**
+ * @brief Pool of packet buffers
+ *
+ * Each thread keeps its own buffers, so that
+ * serializing a packet does not allocate once
+ * the buffers grew to the size of the packets
+ * sent (see IPacket::send()).
+ */
+class PacketBufferPool
+{
+public:
+    /**
+     * @brief Initial capacity of the buffers
+     *
+     */
+    static constexpr std::size_t INITIAL_CAPACITY = 512;
+    /**
+     * @brief Max capacity of a buffer kept in the pool
+     *
+     * Bigger buffers are freed, a single huge
+     * packet does not stay in memory forever.
+     */
+    static constexpr std::size_t MAX_RETAINED_CAPACITY = 1 << 20;
+    /**
+     * @brief Max number of buffers kept per thread
+     *
+     */
+    static constexpr std::size_t MAX_POOLED = 8;
+
+    /**
+     * @brief Borrows a buffer from the pool of the thread
+     *
+     * @return PooledBuffer the cleared buffer
+     */
+    static PooledBuffer acquire();
+    /**
+     * @brief Get the number of heap allocations made for buffers
+     *
+     * Counts new buffers and buffers that had to grow,
+     * across all threads. It stays the same once the
+     * server reached its steady state.
+     * @return std::uint64_t the number of allocations
+     */
+    static std::uint64_t allocations();
+    /**
+     * @brief Gives back a buffer to the pool of the thread
+     *
+     * @param stream the buffer
+     * @param grew whether the buffer had to grow while borrowed
+     */
+    static void release(std::unique_ptr<MemoryStream> stream, bool grew);
+};
+
+#endif // MINESERVER_BUFFERPOOL_H
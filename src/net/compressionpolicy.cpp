@@ -0,0 +1,240 @@
+/**
+ * @file compressionpolicy.cpp
+ * @author Lygaen
+ * @brief The file containing the per packet compression policy logic
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "compressionpolicy.h"
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+
+/**
+ * @brief Level of ids that are neither pinned nor learnt
+ *
+ */
+constexpr int UNSET = -2;
+/**
+ * @brief Max compressed to uncompressed ratio worth compressing for
+ *
+ */
+constexpr double MAX_RATIO = 0.95;
+/**
+ * @brief How much larger the fastest level output can be to be used
+ *
+ */
+constexpr double FAST_MARGIN = 1.05;
+
+static bool isValidLevel(int level)
+{
+    return level >= -1 && level <= 9;
+}
+
+CompressionPolicy *CompressionPolicy::instance = nullptr;
+CompressionPolicy::CompressionPolicy(int level) : level(level), types(), learningLock(), metrics(nullptr)
+{
+    if (instance)
+        throw std::runtime_error("Compression policy should not be constructed twice");
+
+    for (Type &type : types)
+    {
+        type.pinned = UNSET;
+        type.learnt = UNSET;
+    }
+
+    instance = this;
+}
+
+CompressionPolicy::~CompressionPolicy()
+{
+    if (instance == this)
+        instance = nullptr;
+}
+
+void CompressionPolicy::setLevel(int value)
+{
+    level = value;
+}
+
+bool CompressionPolicy::pin(std::int32_t id, int value)
+{
+    if (id < 0 || id >= MAX_PACKET_ID || !isValidLevel(value))
+        return false;
+
+    types[id].pinned = value;
+    return true;
+}
+
+bool CompressionPolicy::pin(const std::string &pins)
+{
+    bool valid = true;
+    std::stringstream stream(pins);
+    std::string entry;
+    while (std::getline(stream, entry, ','))
+    {
+        std::size_t separator = entry.find(':');
+        if (separator == std::string::npos)
+        {
+            valid = valid && entry.find_first_not_of(" \t") == std::string::npos;
+            continue;
+        }
+
+        try
+        {
+            // Base 0 takes both 0x21 and 33
+            std::int32_t id = std::stoi(entry.substr(0, separator), nullptr, 0);
+            int value = std::stoi(entry.substr(separator + 1));
+            valid = pin(id, value) && valid;
+        }
+        catch (const std::exception &)
+        {
+            valid = false;
+        }
+    }
+
+    return valid;
+}
+
+void CompressionPolicy::exposeMetrics(MetricsManager *manager)
+{
+    metrics = manager;
+    if (!manager)
+        return;
+
+    for (std::int32_t id = 0; id < MAX_PACKET_ID; id++)
+        if (types[id].seen)
+            expose(id);
+}
+
+void CompressionPolicy::expose(std::int32_t id)
+{
+    MetricsManager *manager = metrics;
+    if (!manager)
+        return;
+
+    char prefix[32];
+    std::snprintf(prefix, sizeof(prefix), "compression.packet_0x%02X.", id);
+    std::string name(prefix);
+
+    manager->add(name + "packets", [this, id]()
+                 { return (double)types[id].packets; });
+    manager->add(name + "compressed", [this, id]()
+                 { return (double)types[id].compressed; });
+    manager->add(name + "ratio", [this, id]()
+                 {
+        double in = (double)types[id].bytesIn;
+        return in == 0 ? 0 : (double)types[id].bytesOut / in; });
+    manager->add(name + "cpu_ms", [this, id]()
+                 { return (double)types[id].time / 1e6; });
+    manager->add(name + "level", [this, id]()
+                 { return (double)getLevel(id); });
+}
+
+CompressionPolicy::Decision CompressionPolicy::decide(std::int32_t id)
+{
+    if (id < 0 || id >= MAX_PACKET_ID)
+        return {level, false};
+
+    Type &type = types[id];
+    int pinned = type.pinned;
+    if (pinned != UNSET)
+        return {pinned, false};
+
+    // The first packets of every period alternate between the default and fastest levels
+    std::uint64_t decision = type.decisions++ % LEARN_PERIOD;
+    if (decision < LEARN_PACKETS)
+        return {decision % 2 == 0 ? level.load() : FAST, true};
+
+    int learnt = type.learnt;
+    return {learnt == UNSET ? level.load() : learnt, false};
+}
+
+void CompressionPolicy::record(std::int32_t id, const Decision &decision, std::size_t bytesIn, std::size_t bytesOut, std::uint64_t time)
+{
+    if (id < 0 || id >= MAX_PACKET_ID)
+        return;
+
+    Type &type = types[id];
+    type.packets++;
+    if (!type.seen.exchange(true))
+        expose(id);
+
+    if (decision.level == NONE)
+        return;
+
+    type.compressed++;
+    type.bytesIn += bytesIn;
+    type.bytesOut += bytesOut;
+    type.time += time;
+
+    if (!decision.learning)
+        return;
+
+    std::lock_guard<std::mutex> guard(learningLock);
+    Learning &learning = type.learning;
+    int arm = decision.level == level ? 0 : 1;
+    learning.packets[arm]++;
+    learning.bytesIn[arm] += bytesIn;
+    learning.bytesOut[arm] += bytesOut;
+    learning.time[arm] += time;
+
+    if (learning.packets[0] + learning.packets[1] >= LEARN_PACKETS)
+    {
+        learn(type);
+        learning = {};
+    }
+}
+
+void CompressionPolicy::learn(Type &type)
+{
+    const Learning &learning = type.learning;
+    if (learning.bytesIn[0] == 0)
+        return;
+
+    double ratio = (double)learning.bytesOut[0] / (double)learning.bytesIn[0];
+    if (learning.bytesIn[1] == 0)
+    {
+        // The default level is the fastest one
+        type.learnt = ratio > MAX_RATIO ? NONE : UNSET;
+        return;
+    }
+
+    double fastRatio = (double)learning.bytesOut[1] / (double)learning.bytesIn[1];
+    double cost = (double)learning.time[0] / (double)learning.bytesIn[0];
+    double fastCost = (double)learning.time[1] / (double)learning.bytesIn[1];
+
+    if (std::min(ratio, fastRatio) > MAX_RATIO)
+        type.learnt = NONE;
+    else if (fastRatio <= ratio * FAST_MARGIN && fastCost < cost)
+        type.learnt = FAST;
+    else
+        type.learnt = UNSET;
+}
+
+CompressionPolicy::Stats CompressionPolicy::getStats(std::int32_t id) const
+{
+    if (id < 0 || id >= MAX_PACKET_ID)
+        return {};
+
+    const Type &type = types[id];
+    return {type.packets, type.compressed, type.bytesIn, type.bytesOut, type.time};
+}
+
+int CompressionPolicy::getLevel(std::int32_t id) const
+{
+    if (id < 0 || id >= MAX_PACKET_ID)
+        return level;
+
+    int pinned = types[id].pinned;
+    if (pinned != UNSET)
+        return pinned;
+
+    int learnt = types[id].learnt;
+    return learnt == UNSET ? level.load() : learnt;
+}
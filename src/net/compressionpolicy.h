@@ -0,0 +1,244 @@
+/**
+ * @file compressionpolicy.h
+ * @author Lygaen
+ * @brief The file containing the per packet compression policy
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MINESERVER_COMPRESSIONPOLICY_H
+#define MINESERVER_COMPRESSIONPOLICY_H
+
+#include <utils/metrics.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief Compression policy of outgoing packets
+ *
+ * Picks the compression level of each packet from its id.
+ * Ids can be pinned to a level, the other ones are learnt :
+ * every once in a while, a few packets of an id are sent
+ * alternating between the default level and the fastest
+ * one. The fastest level is then used if it saves about
+ * as much, and the id stops being compressed if neither
+ * saves anything worth the time.
+ * Notchian clients accept uncompressed packets of any size,
+ * only packets under the threshold can not be compressed.
+ * The policy is shared by all of the connections.
+ */
+class CompressionPolicy
+{
+public:
+    /**
+     * @brief Level of packets that are not compressed
+     *
+     */
+    static constexpr int NONE = 0;
+    /**
+     * @brief Fastest compression level
+     *
+     */
+    static constexpr int FAST = 1;
+    /**
+     * @brief Number of packet ids the policy knows about
+     *
+     * Packets with a greater id use the default level.
+     */
+    static constexpr std::int32_t MAX_PACKET_ID = 128;
+    /**
+     * @brief Number of packets of an id between two learnings
+     *
+     */
+    static constexpr std::uint64_t LEARN_PERIOD = 1024;
+    /**
+     * @brief Number of packets of an id compressed to learn its level
+     *
+     */
+    static constexpr std::uint64_t LEARN_PACKETS = 32;
+
+    /**
+     * @brief Choice of the policy for a packet
+     *
+     */
+    struct Decision
+    {
+        /**
+         * @brief Compression level, CompressionPolicy::NONE to not compress
+         *
+         */
+        int level;
+        /**
+         * @brief Whether the packet is used to learn the level of its id
+         *
+         */
+        bool learning;
+    };
+
+    /**
+     * @brief Statistics of a packet id
+     *
+     */
+    struct Stats
+    {
+        /**
+         * @brief Number of packets sent
+         *
+         */
+        std::uint64_t packets;
+        /**
+         * @brief Number of packets compressed
+         *
+         */
+        std::uint64_t compressed;
+        /**
+         * @brief Length of the compressed packets before compression
+         *
+         */
+        std::uint64_t bytesIn;
+        /**
+         * @brief Length of the compressed packets after compression
+         *
+         */
+        std::uint64_t bytesOut;
+        /**
+         * @brief Time spent compressing, in nanoseconds
+         *
+         */
+        std::uint64_t time;
+    };
+
+private:
+    struct Learning
+    {
+        std::uint64_t packets[2];
+        std::uint64_t bytesIn[2];
+        std::uint64_t bytesOut[2];
+        std::uint64_t time[2];
+    };
+
+    struct Type
+    {
+        std::atomic<int> pinned;
+        std::atomic<int> learnt;
+        std::atomic<std::uint64_t> decisions;
+        std::atomic<bool> seen;
+
+        std::atomic<std::uint64_t> packets;
+        std::atomic<std::uint64_t> compressed;
+        std::atomic<std::uint64_t> bytesIn;
+        std::atomic<std::uint64_t> bytesOut;
+        std::atomic<std::uint64_t> time;
+
+        Learning learning;
+    };
+
+    std::atomic<int> level;
+    std::array<Type, MAX_PACKET_ID> types;
+    std::mutex learningLock;
+    std::atomic<MetricsManager *> metrics;
+
+    static CompressionPolicy *instance;
+
+    void learn(Type &type);
+    void expose(std::int32_t id);
+
+public:
+    /**
+     * @brief Construct a new Compression Policy object
+     *
+     * @param level the default compression level
+     */
+    CompressionPolicy(int level = -1);
+    /**
+     * @brief Destroy the Compression Policy object
+     *
+     */
+    ~CompressionPolicy();
+
+    /**
+     * @brief Set the default compression level
+     *
+     * @param level the level of the ids that are not learnt yet
+     */
+    void setLevel(int level);
+    /**
+     * @brief Pins the compression level of a packet id
+     *
+     * @param id the packet id
+     * @param level the level to always use, CompressionPolicy::NONE to never compress
+     * @return true the level is pinned
+     * @return false the id or the level is invalid
+     */
+    bool pin(std::int32_t id, int level);
+    /**
+     * @brief Pins the compression levels from a string
+     *
+     * The string is a comma separated list of `id:level`,
+     * the ids being hexadecimal, like `0x21:6,0x15:0`.
+     * @param pins the levels to pin
+     * @return true every level is pinned
+     * @return false some of them are invalid, the valid ones are pinned
+     */
+    bool pin(const std::string &pins);
+    /**
+     * @brief Exposes the statistics of the packet ids as metrics
+     *
+     * Each id gets its metrics once it is seen, named
+     * `compression.packet_0xID.*`.
+     * @param manager the metrics manager, nullptr to stop exposing
+     */
+    void exposeMetrics(MetricsManager *manager);
+
+    /**
+     * @brief Picks the level of a packet
+     *
+     * @param id the packet id
+     * @return Decision the level to compress the packet with
+     */
+    Decision decide(std::int32_t id);
+    /**
+     * @brief Records how a packet was compressed
+     *
+     * @param id the packet id
+     * @param decision the decision the packet was compressed with
+     * @param bytesIn the length of the packet
+     * @param bytesOut the length of the compressed packet
+     * @param time the time spent compressing, in nanoseconds
+     */
+    void record(std::int32_t id, const Decision &decision, std::size_t bytesIn, std::size_t bytesOut, std::uint64_t time);
+
+    /**
+     * @brief Get the statistics of a packet id
+     *
+     * @param id the packet id
+     * @return Stats the statistics, all zero for unknown ids
+     */
+    Stats getStats(std::int32_t id) const;
+    /**
+     * @brief Get the level currently used for a packet id
+     *
+     * @param id the packet id
+     * @return int the pinned or learnt level
+     */
+    int getLevel(std::int32_t id) const;
+
+    /**
+     * @brief Gets Compression Policy instance
+     *
+     * @return CompressionPolicy* the instance, nullptr if there is none
+     */
+    static CompressionPolicy *inst()
+    {
+        return instance;
+    }
+};
+
+#endif // MINESERVER_COMPRESSIONPOLICY_H
@@ -0,0 +1,133 @@
+/**
+ * @file compressionpool.cpp
+ * @author Lygaen
+ * @brief The file containing the compression workers logic
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "compressionpool.h"
+#include <net/pipeline.h>
+#include <utils/logger.h>
+#include <algorithm>
+#include <stdexcept>
+
+CompressionPool *CompressionPool::instance = nullptr;
+CompressionPool::CompressionPool() : level(-1),
+                                     policy(nullptr),
+                                     running(false),
+                                     queueLock(),
+                                     queueCond(),
+                                     queue(),
+                                     workers(),
+                                     pending(0),
+                                     jobs(0),
+                                     latency(0)
+{
+    if (instance)
+        throw std::runtime_error("Compression pool should not be constructed twice");
+
+    instance = this;
+}
+
+CompressionPool::~CompressionPool()
+{
+    stop();
+
+    if (instance == this)
+        instance = nullptr;
+}
+
+void CompressionPool::start(unsigned int count, int lvl, CompressionPolicy *pol)
+{
+    if (running)
+        throw std::runtime_error("Compression pool is already started");
+
+    level = lvl;
+    policy = pol;
+    running = true;
+    for (unsigned int i = 0; i < std::max(1u, count); i++)
+        workers.emplace_back(&CompressionPool::work, this);
+
+    logger::debug("Compression pool started with %u workers", std::max(1u, count));
+}
+
+void CompressionPool::stop()
+{
+    std::deque<Job> dropped;
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        if (!running)
+            return;
+        running = false;
+        dropped.swap(queue);
+    }
+    queueCond.notify_all();
+
+    for (std::thread &worker : workers)
+        worker.join();
+    workers.clear();
+
+    pending -= dropped.size();
+}
+
+bool CompressionPool::submit(std::vector<std::byte> packet, Callback callback)
+{
+    std::lock_guard<std::mutex> guard(queueLock);
+    if (!running || queue.size() >= MAX_QUEUED)
+        return false;
+
+    pending++;
+    queue.push_back({std::move(packet), std::move(callback), std::chrono::steady_clock::now()});
+    queueCond.notify_one();
+    return true;
+}
+
+void CompressionPool::work()
+{
+    // Each worker keeps its own zlib state
+    pipeline::ZLibCompression compress(level, 0, policy);
+    std::vector<std::byte> frame;
+
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(queueLock);
+            queueCond.wait(lock, [this]()
+                           { return !running || !queue.empty(); });
+            if (!running)
+                break;
+
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        frame.clear();
+        try
+        {
+            compress.frame(job.packet.data(), job.packet.size(), frame);
+        }
+        catch (const std::exception &err)
+        {
+            // The connection gets an empty frame and gives up
+            logger::error("Compression job failed : %s", err.what());
+            frame.clear();
+        }
+        latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - job.queued).count();
+        jobs++;
+        pending--;
+
+        try
+        {
+            job.callback(frame);
+        }
+        catch (const std::exception &err)
+        {
+            logger::error("Compression callback failed : %s", err.what());
+        }
+    }
+}
@@ -0,0 +1,162 @@
+/**
+ * @file compressionpool.h
+ * @author Lygaen
+ * @brief The file containing the compression workers
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MINESERVER_COMPRESSIONPOOL_H
+#define MINESERVER_COMPRESSIONPOOL_H
+
+#include <net/compressionpolicy.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Compression workers
+ *
+ * Compresses the largest outgoing packets out of the
+ * network threads, so that a connection sending a lot
+ * of data does not stall the ones sharing its thread.
+ * Workers only build the compressed frames, encryption
+ * and sending stay on the network thread of the
+ * connection, which keeps them in order (see
+ * PipelineStream::enableOffload()).
+ */
+class CompressionPool
+{
+public:
+    /**
+     * @brief Called with the compressed frame of a packet
+     *
+     * Runs on one of the workers, it must not block
+     * and should hand the frame over to the network
+     * thread of the client (see Reactor::post()).
+     */
+    typedef std::function<void(std::vector<std::byte> &frame)> Callback;
+
+    /**
+     * @brief Max number of packets waiting for a worker
+     *
+     * Past it, packets are compressed by their
+     * network thread instead.
+     */
+    static constexpr std::size_t MAX_QUEUED = 1024;
+
+private:
+    struct Job
+    {
+        std::vector<std::byte> packet;
+        Callback callback;
+        std::chrono::steady_clock::time_point queued;
+    };
+
+    int level;
+    CompressionPolicy *policy;
+    bool running;
+    std::mutex queueLock;
+    std::condition_variable queueCond;
+    std::deque<Job> queue;
+    std::vector<std::thread> workers;
+
+    std::atomic<std::uint64_t> pending;
+    std::atomic<std::uint64_t> jobs;
+    std::atomic<double> latency;
+
+    static CompressionPool *instance;
+
+    void work();
+
+public:
+    /**
+     * @brief Construct a new Compression Pool object
+     *
+     * The pool is idle until CompressionPool::start() is called.
+     */
+    CompressionPool();
+    /**
+     * @brief Destroy the Compression Pool object
+     *
+     */
+    ~CompressionPool();
+
+    /**
+     * @brief Starts the workers
+     *
+     * @param count the number of workers
+     * @param level the compression level
+     * @param policy the policy picking the level of each packet, not owned, nullptr to always use @p level
+     */
+    void start(unsigned int count, int level, CompressionPolicy *policy = nullptr);
+    /**
+     * @brief Stops the workers
+     *
+     * Waits for the packets being compressed, the
+     * ones still queued are dropped without calling
+     * their callbacks.
+     */
+    void stop();
+
+    /**
+     * @brief Queues a packet to compress
+     *
+     * @param packet the packet id and data
+     * @param callback the callback to call with the frame
+     * @return true the packet was queued
+     * @return false the pool is not started or full, nothing was queued
+     */
+    bool submit(std::vector<std::byte> packet, Callback callback);
+
+    /**
+     * @brief Get the number of packets not compressed yet
+     *
+     * @return std::uint64_t the number of queued and in progress packets
+     */
+    std::uint64_t getPending() const
+    {
+        return pending;
+    }
+    /**
+     * @brief Get the number of compressed packets
+     *
+     * @return std::uint64_t the number of packets
+     */
+    std::uint64_t getJobs() const
+    {
+        return jobs;
+    }
+    /**
+     * @brief Get the latency of the last packet
+     *
+     * Time from it being queued to it being compressed.
+     * @return double the latency in milliseconds
+     */
+    double getLatency() const
+    {
+        return latency;
+    }
+
+    /**
+     * @brief Gets Compression Pool instance
+     *
+     * @return CompressionPool& the instance
+     */
+    static CompressionPool &inst()
+    {
+        return *instance;
+    }
+};
+
+#endif // MINESERVER_COMPRESSIONPOOL_H
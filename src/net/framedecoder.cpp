@@ -0,0 +1,92 @@
+/**
+ * @file framedecoder.cpp
+ * @author Lygaen
+ * @brief The file containing the received frames decoding logic
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "framedecoder.h"
+#include <stdexcept>
+
+/**
+ * @brief Max length of a received packet
+ *
+ * Biggest value a 3 bytes VarInt can hold,
+ * which is the limit used by notchian servers.
+ */
+constexpr std::int32_t MAX_PACKET_LENGTH = 2097151;
+
+FrameDecoder::FrameDecoder(NetSocketStream *socket) : socket(socket),
+                                                      decipher(),
+                                                      decompressor(),
+                                                      threshold(0),
+                                                      uncompressed(),
+                                                      frameSize(0)
+{
+}
+
+void FrameDecoder::fill()
+{
+    std::size_t read = socket->fill();
+    if (decipher)
+    {
+        std::byte *data = socket->received() + socket->receivedSize() - read;
+        decipher->update(data, read, data);
+    }
+}
+
+bool FrameDecoder::next(PacketView &packet)
+{
+    socket->consume(frameSize);
+    frameSize = 0;
+
+    std::int32_t len;
+    std::size_t headerSize = varint::decode(socket->received(), socket->receivedSize(), len);
+    if (headerSize == 0)
+        return false;
+
+    if (len <= 0 || len > MAX_PACKET_LENGTH)
+        throw std::runtime_error("Invalid packet length");
+
+    if (socket->receivedSize() - headerSize < static_cast<std::size_t>(len))
+        return false;
+
+    const std::byte *frame = socket->received() + headerSize;
+    frameSize = headerSize + len;
+
+    if (decompressor)
+    {
+        std::span<const std::byte> data = decodeCompressedFrame(*decompressor, threshold, frame, len, uncompressed);
+        packet = PacketView(data.data(), data.size());
+    }
+    else
+    {
+        packet = PacketView(frame, len);
+    }
+
+    return true;
+}
+
+bool FrameDecoder::isLegacyPing()
+{
+    return socket->receivedSize() > frameSize && socket->received()[frameSize] == std::byte{0xFE};
+}
+
+void FrameDecoder::enableEncryption(const std::byte *key)
+{
+    decipher = std::make_unique<crypto::AES128CFB8Cipher>(crypto::CipherState::DECRYPT, key, key);
+
+    std::byte *data = socket->received() + frameSize;
+    decipher->update(data, socket->receivedSize() - frameSize, data);
+}
+
+void FrameDecoder::enableCompression(int compressionThreshold)
+{
+    // Level is only used to compress
+    decompressor = std::make_unique<crypto::ZLibCompressor>(-1);
+    threshold = compressionThreshold;
+}
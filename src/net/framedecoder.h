@@ -0,0 +1,96 @@
+/**
+ * @file framedecoder.h
+ * @author Lygaen
+ * @brief The file containing the received frames decoding
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MINESERVER_FRAMEDECODER_H
+#define MINESERVER_FRAMEDECODER_H
+
+#include <net/stream.h>
+#include <net/packetview.hpp>
+#include <utils/crypto.h>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Decoder for received frames
+ *
+ * Splits the data received by a NetSocketStream into
+ * length-prefixed frames. Received data is decrypted
+ * in bulk as soon as it comes in and whole frames are
+ * uncompressed at once, packets are then read through
+ * a PacketView over the decoded frame.
+ */
+class FrameDecoder
+{
+private:
+    NetSocketStream *socket;
+    std::unique_ptr<crypto::AES128CFB8Cipher> decipher;
+    std::unique_ptr<crypto::ZLibCompressor> decompressor;
+    int threshold;
+    std::vector<std::byte> uncompressed;
+    std::size_t frameSize;
+
+public:
+    /**
+     * @brief Construct a new Frame Decoder object
+     *
+     * @param socket the stream to decode the received data of, not owned
+     */
+    FrameDecoder(NetSocketStream *socket);
+    /**
+     * @brief Destroy the Frame Decoder object
+     *
+     */
+    ~FrameDecoder() = default;
+
+    /**
+     * @brief Receives pending data
+     *
+     * Reads everything that was received without
+     * waiting, decrypting it if needed.
+     */
+    void fill();
+    /**
+     * @brief Decodes the next frame
+     *
+     * The previous frame is dropped, invalidating any
+     * view, string or bytes that were read from it.
+     * @param packet the view to set over the packet id and data
+     * @return true a whole frame was decoded
+     * @return false the next frame was not fully received yet
+     */
+    bool next(PacketView &packet);
+    /**
+     * @brief Checks for a pre-1.7 server list ping
+     *
+     * Those start with 0xFE instead of a frame length.
+     * @return true the pending data is a legacy ping
+     * @return false the pending data is not one or nothing is pending
+     */
+    bool isLegacyPing();
+
+    /**
+     * @brief Enables decryption
+     *
+     * Everything received after the current frame
+     * is decrypted, including data already received.
+     * @param key the shared secret, used as both key and IV
+     */
+    void enableEncryption(const std::byte *key);
+    /**
+     * @brief Enables compression
+     *
+     * Frames after the current one are uncompressed.
+     * @param compressionThreshold the compression threshold of the connection
+     */
+    void enableCompression(int compressionThreshold);
+};
+
+#endif // MINESERVER_FRAMEDECODER_H
@@ -0,0 +1,172 @@
+/**
+ * @file logincrypto.cpp
+ * @author Lygaen
+ * @brief The file containing the login cryptography workers logic
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "logincrypto.h"
+#include <utils/crypto.h>
+#include <utils/logger.h>
+#include <algorithm>
+#include <stdexcept>
+
+static std::atomic<std::uint64_t> logins(0);
+static std::atomic<std::uint64_t> loginTime(0);
+
+LoginCrypto *LoginCrypto::instance = nullptr;
+LoginCrypto::LoginCrypto() : running(false),
+                             queueLock(),
+                             queueCond(),
+                             queue(),
+                             workers(),
+                             pending(0),
+                             rejected(0),
+                             latency(0)
+{
+    if (instance)
+        throw std::runtime_error("Login crypto should not be constructed twice");
+
+    instance = this;
+}
+
+LoginCrypto::~LoginCrypto()
+{
+    stop();
+
+    if (instance == this)
+        instance = nullptr;
+}
+
+void LoginCrypto::start(unsigned int count)
+{
+    if (running)
+        throw std::runtime_error("Login crypto is already started");
+
+    running = true;
+    for (unsigned int i = 0; i < std::max(1u, count); i++)
+        workers.emplace_back(&LoginCrypto::work, this);
+
+    logger::debug("Login crypto started with %u workers", std::max(1u, count));
+}
+
+void LoginCrypto::stop()
+{
+    std::deque<Job> dropped;
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        if (!running)
+            return;
+        running = false;
+        dropped.swap(queue);
+    }
+    queueCond.notify_all();
+
+    for (std::thread &worker : workers)
+        worker.join();
+    workers.clear();
+
+    pending -= dropped.size();
+}
+
+void LoginCrypto::submit(Request request, Callback callback)
+{
+    bool busy;
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        if (running && queue.size() < MAX_QUEUED)
+        {
+            pending++;
+            queue.push_back({std::move(request), std::move(callback), std::chrono::steady_clock::now()});
+            queueCond.notify_one();
+            return;
+        }
+        busy = running;
+    }
+
+    if (busy)
+    {
+        rejected++;
+        Result result;
+        result.error = "Too many players logging in";
+        callback(result);
+        return;
+    }
+
+    callback(decrypt(request));
+}
+
+LoginCrypto::Result LoginCrypto::decrypt(const Request &request)
+{
+    // Hashing contexts are reused like the decryption ones
+    thread_local crypto::MinecraftHash hash;
+
+    auto start = std::chrono::steady_clock::now();
+    Result result;
+
+    size_t secretLength, tokenLength;
+    std::unique_ptr<std::byte[]> secret = crypto::rsaDecrypt(request.sharedSecret.data(), request.sharedSecret.size(), &secretLength);
+    std::unique_ptr<std::byte[]> token = crypto::rsaDecrypt(request.verifyToken.data(), request.verifyToken.size(), &tokenLength);
+    if (!secret || !token)
+    {
+        result.error = "Could not decrypt encryption response";
+        return result;
+    }
+
+    result.decrypted = true;
+    result.sharedSecret.assign(secret.get(), secret.get() + secretLength);
+    result.verifyToken.assign(token.get(), token.get() + tokenLength);
+
+    hash.update(result.sharedSecret);
+    hash.update(crypto::getPublicRSAKey());
+    result.serverId = hash.finalize();
+
+    logins++;
+    loginTime += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void LoginCrypto::work()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(queueLock);
+            queueCond.wait(lock, [this]()
+                           { return !running || !queue.empty(); });
+            if (!running)
+                break;
+
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        Result result = decrypt(job.request);
+        latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - job.queued).count();
+        pending--;
+
+        try
+        {
+            job.callback(result);
+        }
+        catch (const std::exception &err)
+        {
+            logger::error("Login crypto callback failed : %s", err.what());
+        }
+    }
+}
+
+std::uint64_t LoginCrypto::getLogins()
+{
+    return logins;
+}
+
+double LoginCrypto::getTime()
+{
+    return (double)loginTime / 1e6;
+}
@@ -0,0 +1,233 @@
+/**
+ * @file logincrypto.h
+ * @author Lygaen
+ * @brief The file containing the login cryptography workers
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MINESERVER_LOGINCRYPTO_H
+#define MINESERVER_LOGINCRYPTO_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Login cryptography workers
+ *
+ * Decrypts the shared secret and verify token of the
+ * encryption responses and computes the server hash out
+ * of the network threads. RSA decryption is by far the
+ * most expensive part of a login, a flood of logins
+ * would otherwise starve the connections sharing their
+ * thread. The number of queued logins is bounded, past
+ * it logins are refused.
+ */
+class LoginCrypto
+{
+public:
+    /**
+     * @brief Max number of logins waiting for a worker
+     *
+     */
+    static constexpr std::size_t MAX_QUEUED = 256;
+
+    /**
+     * @brief Encrypted fields of an encryption response
+     *
+     */
+    struct Request
+    {
+        /**
+         * @brief The shared secret, encrypted with the server's public key
+         *
+         */
+        std::vector<std::byte> sharedSecret;
+        /**
+         * @brief The verify token, encrypted with the server's public key
+         *
+         */
+        std::vector<std::byte> verifyToken;
+    };
+
+    /**
+     * @brief Decrypted fields of an encryption response
+     *
+     */
+    struct Result
+    {
+        /**
+         * @brief Whether both fields were decrypted, the others being set
+         *
+         */
+        bool decrypted = false;
+        /**
+         * @brief The shared secret
+         *
+         */
+        std::vector<std::byte> sharedSecret;
+        /**
+         * @brief The verify token
+         *
+         */
+        std::vector<std::byte> verifyToken;
+        /**
+         * @brief The server hash sent to the session server
+         *
+         */
+        std::string serverId;
+        /**
+         * @brief Why the fields could not be decrypted
+         *
+         */
+        std::string error;
+    };
+
+    /**
+     * @brief Called with the result of a login
+     *
+     * Runs on one of the workers, it must not block
+     * and should hand the result over to the network
+     * thread of the client (see Reactor::post()).
+     */
+    typedef std::function<void(const Result &)> Callback;
+
+private:
+    struct Job
+    {
+        Request request;
+        Callback callback;
+        std::chrono::steady_clock::time_point queued;
+    };
+
+    bool running;
+    std::mutex queueLock;
+    std::condition_variable queueCond;
+    std::deque<Job> queue;
+    std::vector<std::thread> workers;
+
+    std::atomic<std::uint64_t> pending;
+    std::atomic<std::uint64_t> rejected;
+    std::atomic<double> latency;
+
+    static LoginCrypto *instance;
+
+    void work();
+
+public:
+    /**
+     * @brief Construct a new Login Crypto object
+     *
+     * The workers are idle until LoginCrypto::start() is called,
+     * logins are decrypted by the thread submitting them meanwhile.
+     */
+    LoginCrypto();
+    /**
+     * @brief Destroy the Login Crypto object
+     *
+     */
+    ~LoginCrypto();
+
+    /**
+     * @brief Starts the workers
+     *
+     * @param count the number of workers
+     */
+    void start(unsigned int count);
+    /**
+     * @brief Stops the workers
+     *
+     * Waits for the logins being decrypted, the
+     * ones still queued are dropped without calling
+     * their callbacks.
+     */
+    void stop();
+
+    /**
+     * @brief Decrypts an encryption response
+     *
+     * The callback is called right away when the response
+     * can not be queued, with an error if the workers are
+     * busy, or with the result if they are not started.
+     * @param request the encrypted fields
+     * @param callback the callback to call with the result
+     */
+    void submit(Request request, Callback callback);
+
+    /**
+     * @brief Decrypts an encryption response on the current thread
+     *
+     * @param request the encrypted fields
+     * @return Result the decrypted fields
+     */
+    static Result decrypt(const Request &request);
+
+    /**
+     * @brief Get the number of logins not decrypted yet
+     *
+     * @return std::uint64_t the number of queued and in progress logins
+     */
+    std::uint64_t getPending() const
+    {
+        return pending;
+    }
+    /**
+     * @brief Get the number of logins refused because the workers were busy
+     *
+     * @return std::uint64_t the number of refused logins
+     */
+    std::uint64_t getRejected() const
+    {
+        return rejected;
+    }
+    /**
+     * @brief Get the latency of the last login
+     *
+     * Time from it being queued to it being decrypted.
+     * @return double the latency in milliseconds
+     */
+    double getLatency() const
+    {
+        return latency;
+    }
+
+    /**
+     * @brief Get the number of decrypted logins
+     *
+     * Counts the ones decrypted by any thread.
+     * @return std::uint64_t the number of logins
+     */
+    static std::uint64_t getLogins();
+    /**
+     * @brief Get the time spent decrypting logins
+     *
+     * Decrypting the shared secret and verify token
+     * and hashing the server id.
+     * @return double the total time in milliseconds
+     */
+    static double getTime();
+
+    /**
+     * @brief Gets Login Crypto instance
+     *
+     * @return LoginCrypto& the instance
+     */
+    static LoginCrypto &inst()
+    {
+        return *instance;
+    }
+};
+
+#endif // MINESERVER_LOGINCRYPTO_H
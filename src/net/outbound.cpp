@@ -0,0 +1,193 @@
+/**
+ * @file outbound.cpp
+ * @author Lygaen
+ * @brief The file containing the outbound queue logic
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "outbound.h"
+#include <atomic>
+#include <stdexcept>
+
+static std::atomic<std::uint64_t> queuedBytes(0);
+static std::atomic<std::uint64_t> overflows(0);
+static std::atomic<std::uint64_t> copiedBytes(0);
+static std::atomic<std::uint64_t> sharedBytes(0);
+
+OutboundQueue::OutboundQueue(std::size_t budget) : blocks(),
+                                                   spare(),
+                                                   sent(0),
+                                                   queued(0),
+                                                   budget(budget),
+                                                   congested(false),
+                                                   overflowed(false)
+{
+}
+
+OutboundQueue::~OutboundQueue()
+{
+    queuedBytes -= queued;
+}
+
+void OutboundQueue::append(const std::byte *data, std::size_t len)
+{
+    copiedBytes += len;
+
+    // Shared blocks are immutable, frames are packed in the owned ones only
+    if (!blocks.empty() && !blocks.back().shared &&
+        blocks.back().owned.capacity() - blocks.back().owned.size() >= len)
+    {
+        blocks.back().owned.insert(blocks.back().owned.end(), data, data + len);
+        return;
+    }
+
+    if (len >= BLOCK_SIZE)
+    {
+        blocks.push_back({std::vector<std::byte>(data, data + len), nullptr, 0});
+        return;
+    }
+
+    // Sent blocks are recycled, most connections never need more than one
+    std::vector<std::byte> block;
+    block.swap(spare);
+    block.clear();
+    block.reserve(BLOCK_SIZE);
+    block.insert(block.end(), data, data + len);
+    blocks.push_back({std::move(block), nullptr, 0});
+}
+
+bool OutboundQueue::push(const SocketBuffer *buffers, std::size_t count)
+{
+    std::size_t len = 0;
+    for (std::size_t i = 0; i < count; i++)
+        len += buffers[i].len;
+
+    // Dropping only part of the frames would corrupt the stream, the connection is lost anyway
+    if (overflowed || queued + len > budget)
+    {
+        if (!overflowed)
+            overflows++;
+        overflowed = true;
+        return false;
+    }
+
+    for (std::size_t i = 0; i < count; i++)
+        append(buffers[i].data, buffers[i].len);
+
+    queued += len;
+    queuedBytes += len;
+    if (queued >= HIGH_WATERMARK)
+        congested = true;
+    return true;
+}
+
+bool OutboundQueue::push(const SharedPacket::Buffer &buffer, std::size_t offset)
+{
+    std::size_t len = buffer->size() - offset;
+    if (len == 0)
+        return true;
+
+    if (overflowed || queued + len > budget)
+    {
+        if (!overflowed)
+            overflows++;
+        overflowed = true;
+        return false;
+    }
+
+    blocks.push_back({{}, buffer, offset});
+
+    queued += len;
+    queuedBytes += len;
+    if (queued >= HIGH_WATERMARK)
+        congested = true;
+    return true;
+}
+
+void OutboundQueue::consume(std::size_t len)
+{
+    queued -= len;
+    queuedBytes -= len;
+
+    while (len > 0)
+    {
+        Block &front = blocks.front();
+        std::size_t left = front.size() - sent;
+        if (len < left)
+        {
+            sent += len;
+            break;
+        }
+
+        len -= left;
+        sent = 0;
+        if (!front.shared && front.owned.capacity() == BLOCK_SIZE)
+            spare.swap(front.owned);
+        blocks.pop_front();
+    }
+
+    if (queued <= LOW_WATERMARK)
+        congested = false;
+}
+
+bool OutboundQueue::flush(const ClientSocket &socket)
+{
+    while (queued > 0)
+    {
+        SocketBuffer buffers[ClientSocket::MAX_WRITE_BUFFERS];
+        std::size_t count = 0;
+        for (auto it = blocks.begin(); it != blocks.end() && count < ClientSocket::MAX_WRITE_BUFFERS; it++, count++)
+            buffers[count] = {it->data(), it->size()};
+        buffers[0].data += sent;
+        buffers[0].len -= sent;
+
+        ssize_t written = socket.writeAvailable(buffers, count);
+        if (written < 0)
+            throw std::runtime_error("Invalid socket write !");
+        if (written == 0)
+            return false;
+
+        consume(static_cast<std::size_t>(written));
+    }
+
+    return true;
+}
+
+void OutboundQueue::setBudget(std::size_t value)
+{
+    budget = value;
+}
+
+std::uint64_t OutboundQueue::totalQueued()
+{
+    return queuedBytes;
+}
+
+std::uint64_t OutboundQueue::totalOverflows()
+{
+    return overflows;
+}
+
+void OutboundQueue::countCopied(std::size_t len)
+{
+    copiedBytes += len;
+}
+
+void OutboundQueue::countShared(std::size_t len)
+{
+    sharedBytes += len;
+}
+
+std::uint64_t OutboundQueue::totalCopied()
+{
+    return copiedBytes;
+}
+
+std::uint64_t OutboundQueue::totalShared()
+{
+    return sharedBytes;
+}
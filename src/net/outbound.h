@@ -0,0 +1,225 @@
+/**
+ * @file outbound.h
+ * @author Lygaen
+ * @brief The file containing the outbound queue of connections
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MINESERVER_OUTBOUND_H
+#define MINESERVER_OUTBOUND_H
+
+#include <net/sharedpacket.h>
+#include <utils/network.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+/**
+ * @brief Outbound queue of a connection
+ *
+ * Holds the encoded frames the socket could not take
+ * yet, or that were held back to be sent together.
+ * Small frames are packed in the same blocks, so that
+ * many of them go out in a single vectored write, while
+ * shared frames (see SharedPacket) are queued by reference.
+ * The queue is bounded : past its budget, frames are
+ * dropped and the connection should be closed. Between
+ * its watermarks, it tells whether the connection is
+ * congested, in which case nothing more should be
+ * produced for it.
+ */
+class OutboundQueue
+{
+private:
+    struct Block
+    {
+        std::vector<std::byte> owned;
+        SharedPacket::Buffer shared;
+        std::size_t start;
+
+        const std::byte *data() const
+        {
+            return shared ? shared->data() + start : owned.data();
+        }
+        std::size_t size() const
+        {
+            return shared ? shared->size() - start : owned.size();
+        }
+    };
+
+    std::deque<Block> blocks;
+    std::vector<std::byte> spare;
+    std::size_t sent;
+    std::size_t queued;
+    std::size_t budget;
+    bool congested;
+    bool overflowed;
+
+    void append(const std::byte *data, std::size_t len);
+    void consume(std::size_t len);
+
+public:
+    /**
+     * @brief Size of the blocks frames are packed in
+     *
+     * Larger frames get a block of their own.
+     */
+    static constexpr std::size_t BLOCK_SIZE = 16 * 1024;
+    /**
+     * @brief Queued size from which the connection is congested
+     *
+     */
+    static constexpr std::size_t HIGH_WATERMARK = 256 * 1024;
+    /**
+     * @brief Queued size under which the connection is not congested anymore
+     *
+     */
+    static constexpr std::size_t LOW_WATERMARK = 64 * 1024;
+    /**
+     * @brief Default max queued size
+     *
+     */
+    static constexpr std::size_t DEFAULT_BUDGET = 4 * 1024 * 1024;
+
+    /**
+     * @brief Construct a new Outbound Queue object
+     *
+     * @param budget the max queued size
+     */
+    OutboundQueue(std::size_t budget = DEFAULT_BUDGET);
+    /**
+     * @brief Destroy the Outbound Queue object
+     *
+     */
+    ~OutboundQueue();
+
+    /**
+     * @brief Queues buffers
+     *
+     * The buffers are copied. If the budget would be
+     * exceeded, nothing is queued anymore and the queue
+     * is marked as overflowed.
+     * @param buffers the buffers to queue, in order
+     * @param count the number of buffers
+     * @return true the buffers were queued
+     * @return false the buffers were dropped
+     */
+    bool push(const SocketBuffer *buffers, std::size_t count);
+    /**
+     * @brief Queues a shared buffer
+     *
+     * The buffer is not copied, the queue keeps a
+     * reference to it until it is sent. Same budget
+     * as OutboundQueue::push(const SocketBuffer *, std::size_t).
+     * @param buffer the buffer to queue
+     * @param offset the offset of the first byte to queue
+     * @return true the buffer was queued
+     * @return false the buffer was dropped
+     */
+    bool push(const SharedPacket::Buffer &buffer, std::size_t offset);
+    /**
+     * @brief Sends queued data without waiting
+     *
+     * Sends as much as the socket takes right away.
+     * @param socket the socket to send to
+     * @return true everything was sent
+     * @return false some data is still queued
+     */
+    bool flush(const ClientSocket &socket);
+
+    /**
+     * @brief Whether nothing is queued
+     *
+     * @return true the queue is empty
+     * @return false some data is queued
+     */
+    bool empty() const
+    {
+        return queued == 0;
+    }
+    /**
+     * @brief Get the queued size
+     *
+     * @return std::size_t the number of queued bytes
+     */
+    std::size_t size() const
+    {
+        return queued;
+    }
+    /**
+     * @brief Whether the connection is congested
+     *
+     * Set once the queued size reaches OutboundQueue::HIGH_WATERMARK,
+     * cleared once it gets back under OutboundQueue::LOW_WATERMARK.
+     * @return true the connection is congested
+     * @return false the connection is not congested
+     */
+    bool isCongested() const
+    {
+        return congested;
+    }
+    /**
+     * @brief Whether data was dropped
+     *
+     * @return true the budget was exceeded
+     * @return false everything was queued
+     */
+    bool isOverflowed() const
+    {
+        return overflowed;
+    }
+    /**
+     * @brief Set the max queued size
+     *
+     * @param budget the max number of queued bytes
+     */
+    void setBudget(std::size_t budget);
+
+    /**
+     * @brief Get the size queued by all of the connections
+     *
+     * @return std::uint64_t the number of queued bytes
+     */
+    static std::uint64_t totalQueued();
+    /**
+     * @brief Get the number of queues that exceeded their budget
+     *
+     * @return std::uint64_t the number of overflows
+     */
+    static std::uint64_t totalOverflows();
+    /**
+     * @brief Counts bytes copied on their way to a socket
+     *
+     * Copies of whole packets or frames, by the queues
+     * and by the pipelines, excluding the encoding of
+     * the packets and the compression or encryption
+     * passes producing new data.
+     * @param len the number of bytes copied
+     */
+    static void countCopied(std::size_t len);
+    /**
+     * @brief Counts bytes handed to a socket straight from shared frames
+     *
+     * @param len the number of bytes
+     */
+    static void countShared(std::size_t len);
+    /**
+     * @brief Get the number of bytes copied on their way to a socket
+     *
+     * @return std::uint64_t the number of copied bytes
+     */
+    static std::uint64_t totalCopied();
+    /**
+     * @brief Get the number of bytes sent or queued without a copy
+     *
+     * @return std::uint64_t the number of shared bytes
+     */
+    static std::uint64_t totalShared();
+};
+
+#endif // MINESERVER_OUTBOUND_H
@@ -11,16 +11,28 @@
 
 #include "packet.h"
 #include <utils/logger.h>
+#include <net/bufferpool.h>
 
 void IPacket::send(IMCStream *stream)
 {
-    MemoryStream m;
+    // Buffers are reused, steady-state sends do not allocate
+    PooledBuffer buffer = PacketBufferPool::acquire();
+    MemoryStream &m = buffer.get();
     m.writeVarInt(id);
     write(&m);
 
-    std::vector<std::byte> d = m.getData();
+    const std::vector<std::byte> &d = m.getData();
 
-    stream->finishPacketWrite(&d[0], d.size());
+    stream->finishPacketWrite(d.data(), d.size());
 
     logger::debug("C<-S Len:%d Id:%d", d.size(), id);
-}
\ No newline at end of file
+}
+
+void IPacket::read(PacketView &packet)
+{
+    std::span<const std::byte> data = packet.readBytes(packet.remaining());
+
+    MemoryStream m;
+    m.write(data.data(), 0, data.size());
+    read(&m);
+}
@@ -13,6 +13,7 @@
 #define MINESERVER_PACKET_H
 
 #include <net/stream.h>
+#include <net/packetview.hpp>
 
 /**
  * @brief Interface for all Packets
@@ -70,6 +71,17 @@ public:
      * @param stream the stream to read from
      */
     virtual void read(IMCStream *stream) = 0;
+    /**
+     * @brief Reads a received packet
+     *
+     * Same as IPacket#read(IMCStream *) but from a
+     * decoded frame, right after the packet id. Should
+     * be overriden by the packets received by the server,
+     * the default implementation copies the packet data
+     * to a stream and reads from it.
+     * @param packet the view over the packet data
+     */
+    virtual void read(PacketView &packet);
     /**
      * @brief Sends a Packet in Minecraft format
      *
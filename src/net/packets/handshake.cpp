@@ -15,9 +15,10 @@
 
 void HandshakePacket::write(IMCStream *stream)
 {
-    (void)stream;
-    // Does nothing
-    throw std::runtime_error("Handshake write should not be called !");
+    stream->writeVarInt(protocolVersion);
+    stream->writeString(serverAddress);
+    stream->writeUnsignedShort(serverPort);
+    stream->writeVarInt(static_cast<std::int32_t>(nextState));
 }
 
 void HandshakePacket::read(IMCStream *stream)
@@ -28,6 +29,14 @@ void HandshakePacket::read(IMCStream *stream)
     nextState = static_cast<ClientState>(stream->readVarInt());
 }
 
+void HandshakePacket::read(PacketView &packet)
+{
+    protocolVersion = packet.readVarInt();
+    serverAddress = packet.readString();
+    serverPort = packet.readUnsignedShort();
+    nextState = static_cast<ClientState>(packet.readVarInt());
+}
+
 void HandshakePacket::loadLua(lua_State *state, const char *baseNamespaceName) {
     luabridge::getGlobalNamespace(state)
             .beginNamespace(baseNamespaceName)
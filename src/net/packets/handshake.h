@@ -20,7 +20,8 @@
  * @brief Handshake Packet
  *
  * First packet that is read by the server
- * from the client. No writing should be involved.
+ * from the client. Only written by bots
+ * connecting to a server (see tools/loadgen.cpp).
  */
 class HandshakePacket : public IPacket
 {
@@ -28,10 +29,8 @@ protected:
     /**
      * @brief Write Packet Data
      *
-     * Should not be called ! Handshake packet
-     * should only be read, not written to !
+     * Writes handshake data to the stream
      * @param stream the stream to write to
-     * @deprecated Do not call this function
      */
     void write(IMCStream *stream) override;
 
@@ -84,6 +83,13 @@ public:
      * @param stream the stream to read from
      */
     void read(IMCStream *stream) override;
+    /**
+     * @brief Read Packet Data
+     *
+     * Reads handshake data from a received packet
+     * @param packet the packet to read from
+     */
+    void read(PacketView &packet) override;
 
     /**
      * @brief Loads packet as lua class
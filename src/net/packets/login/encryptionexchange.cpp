@@ -16,10 +16,9 @@ void EncryptionRequest::write(IMCStream *stream)
 {
     stream->writeString("");
 
-    int len;
-    auto publicKey = crypto::getPublicRSAKey(&len);
-    stream->writeVarInt(len);
-    stream->write(publicKey.get(), 0, len);
+    std::span<const std::byte> publicKey = crypto::getPublicRSAKey();
+    stream->writeVarInt(publicKey.size());
+    stream->write(publicKey.data(), 0, publicKey.size());
 
     stream->writeVarInt(verifyTokenLength);
     stream->write(verifyToken, 0, verifyTokenLength);
@@ -56,3 +55,12 @@ void EncryptionResponse::read(IMCStream *stream)
         verifyToken = crypto::rsaDecrypt(buff, len, &verifyTokenLength);
     }
 }
+
+void EncryptionResponse::read(PacketView &packet)
+{
+    std::span<const std::byte> secret = packet.readByteArray();
+    sharedSecret = crypto::rsaDecrypt(secret.data(), secret.size(), &sharedSecretLength);
+
+    std::span<const std::byte> token = packet.readByteArray();
+    verifyToken = crypto::rsaDecrypt(token.data(), token.size(), &verifyTokenLength);
+}
@@ -120,6 +120,12 @@ public:
      * @param stream the stream to read from
      */
     void read(IMCStream *stream) override;
+    /**
+     * @brief Reads the packet from a received packet
+     *
+     * @param packet the packet to read from
+     */
+    void read(PacketView &packet) override;
 };
 
 #endif // MINESERVER_ENCRYPTIONEXCHANGE_H
\ No newline at end of file
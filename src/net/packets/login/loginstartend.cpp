@@ -13,9 +13,7 @@
 
 void LoginStart::write(IMCStream *stream)
 {
-    (void)stream;
-    // Does nothing
-    throw std::runtime_error("LoginStart write should not be called !");
+    stream->writeString(name);
 }
 
 void LoginStart::read(IMCStream *stream)
@@ -23,6 +21,11 @@ void LoginStart::read(IMCStream *stream)
     name = stream->readString();
 }
 
+void LoginStart::read(PacketView &packet)
+{
+    name = packet.readString();
+}
+
 void LoginStart::loadLua(lua_State *state, const char *baseNamespaceName)
 {
     luabridge::getGlobalNamespace(state)
@@ -42,9 +45,14 @@ void LoginSuccess::write(IMCStream *stream)
 
 void LoginSuccess::read(IMCStream *stream)
 {
-    (void)stream;
-    // Does nothing
-    throw std::runtime_error("LoginStart read should not be called !");
+    uuid = MinecraftUUID::fromHex(stream->readString());
+    username = stream->readString();
+}
+
+void LoginSuccess::read(PacketView &packet)
+{
+    uuid = MinecraftUUID::fromHex(std::string(packet.readString()));
+    username = packet.readString();
 }
 
 void LoginSuccess::loadLua(lua_State *state, const char *baseNamespaceName)
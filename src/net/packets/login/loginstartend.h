@@ -31,8 +31,8 @@ private:
     /**
      * @brief Write Packet Data
      *
+     * Only used by bots logging in (see tools/loadgen.cpp).
      * @param stream the stream to write to
-     * @deprecated should not be used, useless
      */
     void write(IMCStream *stream) override;
 
@@ -57,6 +57,12 @@ public:
      * @param stream the stream to read from
      */
     void read(IMCStream *stream) override;
+    /**
+     * @brief Reads Packet data
+     *
+     * @param packet the packet to read from
+     */
+    void read(PacketView &packet) override;
 
     /**
      * @brief Loads Packet to lua
@@ -110,10 +116,17 @@ public:
     /**
      * @brief Reads Packet Data
      *
+     * Only used by bots logging in (see tools/loadgen.cpp).
      * @param stream the stream to read from
-     * @deprecated should not be used, useless
      */
     void read(IMCStream *stream) override;
+    /**
+     * @brief Reads Packet Data
+     *
+     * Only used by bots logging in (see tools/loadgen.cpp).
+     * @param packet the packet to read from
+     */
+    void read(PacketView &packet) override;
 
     /**
      * @brief Loads Packet to lua state
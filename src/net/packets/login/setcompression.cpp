@@ -18,7 +18,10 @@ void SetCompression::write(IMCStream *stream)
 
 void SetCompression::read(IMCStream *stream)
 {
-    (void)stream;
-    // Does nothing
-    throw std::runtime_error("SetCompression read should not be called !");
+    threshold = stream->readVarInt();
+}
+
+void SetCompression::read(PacketView &packet)
+{
+    threshold = packet.readVarInt();
 }
\ No newline at end of file
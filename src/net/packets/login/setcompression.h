@@ -47,10 +47,17 @@ public:
     /**
      * @brief Reads Packet data
      *
+     * Only used by bots logging in (see tools/loadgen.cpp).
      * @param stream the stream to read from
-     * @deprecated should not be used, useless
      */
     void read(IMCStream *stream) override;
+    /**
+     * @brief Reads Packet data
+     *
+     * Only used by bots logging in (see tools/loadgen.cpp).
+     * @param packet the packet to read from
+     */
+    void read(PacketView &packet) override;
 };
 
 #endif // MINESERVER_SETCOMPRESSION_H
\ No newline at end of file
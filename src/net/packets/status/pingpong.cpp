@@ -21,6 +21,11 @@ void PingPongPacket::read(IMCStream *stream)
     payload = stream->readLong();
 }
 
+void PingPongPacket::read(PacketView &packet)
+{
+    payload = packet.readLong();
+}
+
 void PingPongPacket::loadLua(lua_State *state, const char *baseNamespaceName) {
     luabridge::getGlobalNamespace(state)
             .beginNamespace(baseNamespaceName)
@@ -58,6 +58,13 @@ public:
      * @param stream the stream to read from
      */
     void read(IMCStream *stream) override;
+    /**
+     * @brief Read Packet Data
+     *
+     * Reads the payload from a received packet
+     * @param packet the packet to read from
+     */
+    void read(PacketView &packet) override;
 
     /**
      * @brief Loads this Packet as lua class
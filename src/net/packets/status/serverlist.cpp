@@ -15,6 +15,30 @@
 #include <rapidjson/writer.h>
 #include <utils/config.h>
 #include <utils/logger.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Cache of the serialized Server List packet
+ *
+ * Holds the packet id and data, as well as what
+ * it was built from.
+ */
+struct ServerListCache
+{
+    std::mutex lock;
+    std::shared_ptr<const SharedPacket> packet;
+    unsigned int motdVersion;
+    unsigned int iconVersion;
+    int maxPlayers;
+    int onlinePlayers;
+};
+
+static ServerListCache serverListCache;
+static std::atomic<std::uint64_t> serverListHits = 0;
+static std::atomic<std::uint64_t> serverListMisses = 0;
 
 void ServerListPacket::write(IMCStream *stream)
 {
@@ -59,6 +83,8 @@ ServerListPacket::ServerListPacket() : IPacket(0x00)
 
     // TODO Display actual number of connected players with sample
     onlinePlayers = 0;
+    // A change while copying only causes a rebuild, never a stale cached motd
+    motdVersion = Config::inst()->MOTD.getVersion();
     motd = Config::inst()->MOTD.getValue();
 }
 
@@ -68,6 +94,64 @@ void ServerListPacket::read(IMCStream *stream)
     (void)stream;
 }
 
+void ServerListPacket::sendCached(IMCStream *stream)
+{
+    Config *config = Config::inst();
+
+    // Customized for this request only, no need to keep it
+    if (!(motd == config->MOTD.getValue()))
+    {
+        serverListMisses++;
+        send(stream);
+        return;
+    }
+
+    // Versions are read before the values, a concurrent change only causes a rebuild
+    unsigned int iconVersion = config->ICON_FILE.getVersion();
+
+    std::shared_ptr<const SharedPacket> packet;
+    {
+        std::lock_guard<std::mutex> guard(serverListCache.lock);
+        if (serverListCache.packet && serverListCache.motdVersion == motdVersion &&
+            serverListCache.iconVersion == iconVersion && serverListCache.maxPlayers == maxPlayers &&
+            serverListCache.onlinePlayers == onlinePlayers)
+            packet = serverListCache.packet;
+    }
+
+    if (packet)
+    {
+        serverListHits++;
+    }
+    else
+    {
+        serverListMisses++;
+
+        MemoryStream m;
+        m.writeVarInt(id);
+        write(&m);
+        packet = std::make_shared<const SharedPacket>(m.getData());
+
+        std::lock_guard<std::mutex> guard(serverListCache.lock);
+        serverListCache.packet = packet;
+        serverListCache.motdVersion = motdVersion;
+        serverListCache.iconVersion = iconVersion;
+        serverListCache.maxPlayers = maxPlayers;
+        serverListCache.onlinePlayers = onlinePlayers;
+    }
+
+    stream->writeShared(*packet);
+}
+
+std::uint64_t ServerListPacket::getCacheHits()
+{
+    return serverListHits;
+}
+
+std::uint64_t ServerListPacket::getCacheMisses()
+{
+    return serverListMisses;
+}
+
 void ServerListPacket::loadLua(lua_State *state, const char* baseNamespaceName) {
     luabridge::getGlobalNamespace(state)
         .beginNamespace(baseNamespaceName)
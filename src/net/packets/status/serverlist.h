@@ -14,6 +14,7 @@
 
 #include <net/packet.h>
 #include <plugins/luaheaders.h>
+#include <cstdint>
 
 /**
  * @brief Server List packet
@@ -34,6 +35,10 @@ protected:
      */
     void write(IMCStream *stream) override;
 
+private:
+    // Version of the config motd copied, taken before copying it
+    unsigned int motdVersion;
+
 public:
     /**
      * @brief Max players
@@ -77,6 +82,33 @@ public:
      */
     void read(IMCStream *stream) override;
 
+    /**
+     * @brief Sends the packet, reusing the cached one if possible
+     *
+     * The serialized packet is cached, and only built again
+     * when the motd, icon or max players of the config or
+     * the players counts of this packet changed. A motd
+     * customized for this request (eg. by a ClientStatusEvent
+     * listener) is always built again and never cached.
+     * The cached packet is shared by all of the connections,
+     * its frames are built once (see SharedPacket).
+     * @param stream the stream to send to
+     */
+    void sendCached(IMCStream *stream);
+
+    /**
+     * @brief Get the number of packets sent from the cache
+     *
+     * @return std::uint64_t the number of cache hits
+     */
+    static std::uint64_t getCacheHits();
+    /**
+     * @brief Get the number of packets built for sending
+     *
+     * @return std::uint64_t the number of cache misses
+     */
+    static std::uint64_t getCacheMisses();
+
     /**
      * @brief Loads this Packet as a lua class
      *
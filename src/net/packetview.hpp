@@ -0,0 +1,289 @@
+/**
+ * @file packetview.hpp
+ * @author Lygaen
+ * @brief The file containing the received packet reader
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MINESERVER_PACKETVIEW_H
+#define MINESERVER_PACKETVIEW_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <types/uuid.h>
+#include <net/varint.hpp>
+
+/**
+ * @brief Reader over a received packet
+ *
+ * Reads the Minecraft protocol types straight from
+ * a decoded frame, without any virtual call or copy
+ * like the IMCStream reading functions. Every read
+ * is bounds-checked and throws when going past the
+ * end of the packet.
+ *
+ * The view does not own the frame, strings and bytes
+ * read from it point into the frame and are only valid
+ * as long as the frame is (see FrameDecoder::next()).
+ */
+class PacketView
+{
+private:
+    const std::byte *data;
+    std::size_t size;
+    std::size_t index;
+
+    /**
+     * @brief Reads @p len bytes, advancing the view
+     *
+     * @param len the number of bytes to read
+     * @return const std::byte* the start of the read bytes
+     */
+    const std::byte *take(std::size_t len)
+    {
+        if (len > size - index)
+            throw std::runtime_error("Read past the end of the packet");
+
+        const std::byte *start = data + index;
+        index += len;
+        return start;
+    }
+
+    /**
+     * @brief Reads a big-endian integer
+     *
+     * @tparam T the type of the integer
+     * @return T the integer read
+     */
+    template <typename T>
+    T readBigEndian()
+    {
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+
+        if constexpr (std::endian::native == std::endian::little && sizeof(T) > 1)
+        {
+            auto *bytes = reinterpret_cast<std::byte *>(&value);
+            for (std::size_t i = 0; i < sizeof(T) / 2; i++)
+                std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+        }
+
+        return value;
+    }
+
+public:
+    /**
+     * @brief Construct a new empty Packet View object
+     *
+     */
+    PacketView() : data(nullptr), size(0), index(0) {}
+    /**
+     * @brief Construct a new Packet View object
+     *
+     * @param data the packet data (id and fields)
+     * @param size the size of the packet data
+     */
+    PacketView(const std::byte *data, std::size_t size) : data(data), size(size), index(0) {}
+
+    /**
+     * @brief Get the size of the packet
+     *
+     * @return std::size_t the size of the packet
+     */
+    std::size_t getSize() const
+    {
+        return size;
+    }
+    /**
+     * @brief Get the number of bytes left to read
+     *
+     * @return std::size_t the number of bytes left
+     */
+    std::size_t remaining() const
+    {
+        return size - index;
+    }
+
+    /**
+     * @brief Reads a Boolean
+     *
+     * @return true the boolean read is true
+     * @return false the boolean read is false
+     */
+    bool readBoolean()
+    {
+        return *take(1) != std::byte{0};
+    }
+    /**
+     * @brief Reads a Byte
+     *
+     * @return std::int8_t the byte read
+     */
+    std::int8_t readByte()
+    {
+        return readBigEndian<std::int8_t>();
+    }
+    /**
+     * @brief Reads an Unsigned Byte
+     *
+     * @return std::uint8_t the unsigned byte read
+     */
+    std::uint8_t readUnsignedByte()
+    {
+        return readBigEndian<std::uint8_t>();
+    }
+    /**
+     * @brief Reads a Short
+     *
+     * @return std::int16_t the short read
+     */
+    std::int16_t readShort()
+    {
+        return readBigEndian<std::int16_t>();
+    }
+    /**
+     * @brief Reads an Unsigned Short
+     *
+     * @return std::uint16_t the unsigned short read
+     */
+    std::uint16_t readUnsignedShort()
+    {
+        return readBigEndian<std::uint16_t>();
+    }
+    /**
+     * @brief Reads an Int
+     *
+     * @return std::int32_t the int read
+     */
+    std::int32_t readInt()
+    {
+        return readBigEndian<std::int32_t>();
+    }
+    /**
+     * @brief Reads a Long
+     *
+     * @return std::int64_t the long read
+     */
+    std::int64_t readLong()
+    {
+        return readBigEndian<std::int64_t>();
+    }
+    /**
+     * @brief Reads a Float
+     *
+     * @return float the float read
+     */
+    float readFloat()
+    {
+        return std::bit_cast<float>(readInt());
+    }
+    /**
+     * @brief Reads a Double
+     *
+     * @return double the double read
+     */
+    double readDouble()
+    {
+        return std::bit_cast<double>(readLong());
+    }
+
+    /**
+     * @brief Reads a VarInt
+     *
+     * @return std::int32_t the variable integer read
+     */
+    std::int32_t readVarInt()
+    {
+        std::int32_t value;
+        std::size_t read = varint::decode(data + index, size - index, value);
+        if (read == 0)
+            throw std::runtime_error("Read past the end of the packet");
+
+        index += read;
+        return value;
+    }
+    /**
+     * @brief Reads a VarLong
+     *
+     * @return std::int64_t the variable long read
+     */
+    std::int64_t readVarLong()
+    {
+        std::int64_t value;
+        std::size_t read = varint::decode(data + index, size - index, value);
+        if (read == 0)
+            throw std::runtime_error("Read past the end of the packet");
+
+        index += read;
+        return value;
+    }
+    /**
+     * @brief Reads consecutive VarInts
+     *
+     * @param values the variable integers read
+     * @param count the number of variable integers to read
+     */
+    void readVarInts(std::int32_t *values, std::size_t count)
+    {
+        std::size_t read = varint::decodeArray(data + index, size - index, values, count);
+        if (read == 0 && count > 0)
+            throw std::runtime_error("Read past the end of the packet");
+
+        index += read;
+    }
+
+    /**
+     * @brief Reads raw bytes
+     *
+     * @param len the number of bytes to read
+     * @return std::span<const std::byte> the bytes, pointing into the frame
+     */
+    std::span<const std::byte> readBytes(std::size_t len)
+    {
+        return {take(len), len};
+    }
+    /**
+     * @brief Reads a VarInt-prefixed byte array
+     *
+     * @return std::span<const std::byte> the bytes, pointing into the frame
+     */
+    std::span<const std::byte> readByteArray()
+    {
+        std::int32_t len = readVarInt();
+        if (len < 0)
+            throw std::runtime_error("Invalid byte array length");
+
+        return readBytes(static_cast<std::size_t>(len));
+    }
+    /**
+     * @brief Reads a String
+     *
+     * @return std::string_view the string, pointing into the frame
+     */
+    std::string_view readString()
+    {
+        std::span<const std::byte> bytes = readByteArray();
+        return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+    }
+    /**
+     * @brief Reads a MinecraftUUID
+     *
+     * @return MinecraftUUID the uuid read
+     */
+    MinecraftUUID readUUID()
+    {
+        return MinecraftUUID::fromBytes(take(16));
+    }
+};
+
+#endif // MINESERVER_PACKETVIEW_H
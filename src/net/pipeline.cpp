@@ -0,0 +1,277 @@
+/**
+ * @file pipeline.cpp
+ * @author Lygaen
+ * @brief The file containing the outgoing packets pipeline logic
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "pipeline.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <type_traits>
+
+void pipeline::NoCompression::frame(const std::byte *packet, std::size_t len, std::vector<std::byte> &out)
+{
+    std::byte header[5];
+    std::size_t headerSize = varint::encode(static_cast<std::int32_t>(len), header);
+
+    out.insert(out.end(), header, header + headerSize);
+    out.insert(out.end(), packet, packet + len);
+    OutboundQueue::countCopied(len);
+}
+
+/**
+ * @brief Gets the zlib state of the current thread for a level
+ *
+ * @param level the compression level, from -1 to 9
+ * @return crypto::ZLibCompressor& the compressor
+ */
+static crypto::ZLibCompressor &compressor(int level)
+{
+    thread_local std::unique_ptr<crypto::ZLibCompressor> compressors[11];
+
+    level = std::clamp(level, -1, 9);
+    std::unique_ptr<crypto::ZLibCompressor> &comp = compressors[level + 1];
+    if (!comp)
+        comp = std::make_unique<crypto::ZLibCompressor>(level);
+    return *comp;
+}
+
+pipeline::ZLibCompression::ZLibCompression(int level, int threshold, CompressionPolicy *policy) : level(level),
+                                                                                                  threshold(static_cast<std::size_t>(std::max(0, threshold))),
+                                                                                                  policy(policy),
+                                                                                                  compressed()
+{
+}
+
+void pipeline::ZLibCompression::frame(const std::byte *packet, std::size_t len, std::vector<std::byte> &out)
+{
+    std::byte header[10];
+    std::size_t headerSize;
+
+    std::int32_t id = -1;
+    CompressionPolicy::Decision decision{level, false};
+    if (policy)
+    {
+        if (varint::decode(packet, len, id) == 0)
+            id = -1;
+        if (len >= threshold)
+            decision = policy->decide(id);
+    }
+
+    if (len < threshold || decision.level == CompressionPolicy::NONE)
+    {
+        // No compression, data length = 0
+        headerSize = varint::encode(static_cast<std::int32_t>(len + 1), header);
+        header[headerSize++] = std::byte{0};
+
+        out.insert(out.end(), header, header + headerSize);
+        out.insert(out.end(), packet, packet + len);
+        OutboundQueue::countCopied(len);
+
+        if (policy)
+            policy->record(id, {CompressionPolicy::NONE, false}, len, len, 0);
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    compressed.resize(crypto::ZLibCompressor::compressBound(len));
+    int compressedSize = compressor(decision.level).compress(packet, len, compressed.data(), compressed.size());
+    if (policy)
+        policy->record(id, decision, len, compressedSize,
+                       std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+    std::byte dataLength[5];
+    std::size_t dataLengthSize = varint::encode(static_cast<std::int32_t>(len), dataLength);
+    headerSize = varint::encode(static_cast<std::int32_t>(dataLengthSize + compressedSize), header);
+
+    out.insert(out.end(), header, header + headerSize);
+    out.insert(out.end(), dataLength, dataLength + dataLengthSize);
+    out.insert(out.end(), compressed.data(), compressed.data() + compressedSize);
+    OutboundQueue::countCopied(compressedSize);
+}
+
+PipelineStream::PipelineStream(NetSocketStream *socket)
+    : current(std::in_place_index<0>, pipeline::NoCompression(), pipeline::NoEncryption(), pipeline::SocketSink(socket)),
+      offload(),
+      offloadSize(0),
+      deferred(),
+      deferredSize(0),
+      nextTicket(0)
+{
+}
+
+void PipelineStream::enableEncryption(const std::byte *key)
+{
+    std::visit([this, key](auto &pipeline)
+               {
+        using Current = std::decay_t<decltype(pipeline)>;
+        using Compress = decltype(Current::compress);
+
+        if constexpr (!std::is_same_v<decltype(Current::encrypt), pipeline::AESEncryption>)
+        {
+            // Stages are moved out, emplacing destroys the current pipeline
+            Compress compress = std::move(pipeline.compress);
+            pipeline::SocketSink socket = std::move(pipeline.socket);
+            current.template emplace<Pipeline<Compress, pipeline::AESEncryption, pipeline::SocketSink>>(
+                std::move(compress), pipeline::AESEncryption(key), std::move(socket));
+        }
+        else
+        {
+            throw std::runtime_error("Encryption is already enabled");
+        } }, current);
+}
+
+void PipelineStream::enableCompression(int level, int threshold, CompressionPolicy *policy)
+{
+    std::visit([this, level, threshold, policy](auto &pipeline)
+               {
+        using Current = std::decay_t<decltype(pipeline)>;
+        using Encrypt = decltype(Current::encrypt);
+
+        if constexpr (!std::is_same_v<decltype(Current::compress), pipeline::ZLibCompression>)
+        {
+            // The encryption stage keeps its state, the cipher is a stream
+            Encrypt encrypt = std::move(pipeline.encrypt);
+            pipeline::SocketSink socket = std::move(pipeline.socket);
+            current.template emplace<Pipeline<pipeline::ZLibCompression, Encrypt, pipeline::SocketSink>>(
+                pipeline::ZLibCompression(level, threshold, policy), std::move(encrypt), std::move(socket));
+        }
+        else
+        {
+            throw std::runtime_error("Compression is already enabled");
+        } }, current);
+}
+
+void PipelineStream::enableOffload(std::size_t size, Offload function)
+{
+    offloadSize = size;
+    offload = std::move(function);
+}
+
+void PipelineStream::completeOffload(std::uint64_t ticket, std::vector<std::byte> &frame)
+{
+    if (frame.empty())
+    {
+        // The stream can not be recovered, nothing more is sent
+        deferred.clear();
+        deferredSize = 0;
+        throw std::runtime_error("Could not compress packet");
+    }
+
+    for (Deferred &entry : deferred)
+    {
+        if (entry.ticket != ticket)
+            continue;
+
+        entry.frame.swap(frame);
+        entry.ready = true;
+        break;
+    }
+
+    drain();
+}
+
+void PipelineStream::defer(std::vector<std::byte> &&frame, std::size_t size)
+{
+    deferred.push_back({nextTicket++, std::move(frame), nullptr, size, true});
+    deferredSize += size;
+}
+
+void PipelineStream::drain()
+{
+    while (!deferred.empty() && deferred.front().ready)
+    {
+        Deferred &entry = deferred.front();
+        std::visit([&entry](auto &pipeline)
+                   {
+            if (entry.shared)
+                pipeline.writeSharedFrame(entry.shared);
+            else
+                pipeline.writeFrame(entry.frame.data(), entry.frame.size()); }, current);
+
+        deferredSize -= entry.size;
+        deferred.pop_front();
+    }
+}
+
+void PipelineStream::read(std::byte *buffer, std::size_t offset, std::size_t len)
+{
+    (void)buffer;
+    (void)offset;
+    (void)len;
+    throw std::runtime_error("Pipeline streams can not be read from");
+}
+
+void PipelineStream::write(const std::byte *buffer, std::size_t offset, std::size_t len)
+{
+    if (!deferred.empty())
+    {
+        // Held back behind an offloaded packet, see PipelineStream::finishPacketWrite()
+        defer(std::vector<std::byte>(buffer + offset, buffer + offset + len), len);
+        OutboundQueue::countCopied(len);
+        return;
+    }
+
+    std::visit([buffer, offset, len](auto &pipeline)
+               { pipeline.writeRaw(buffer + offset, len); }, current);
+}
+
+size_t PipelineStream::available()
+{
+    return 0;
+}
+
+void PipelineStream::finishPacketWrite(const std::byte *packetData, size_t len)
+{
+    std::visit([this, packetData, len](auto &pipeline)
+               {
+        using Current = std::decay_t<decltype(pipeline)>;
+
+        if constexpr (std::is_same_v<decltype(Current::compress), pipeline::ZLibCompression>)
+        {
+            if (offload && len >= offloadSize && offload(nextTicket, packetData, len))
+            {
+                deferred.push_back({nextTicket++, {}, nullptr, len, false});
+                deferredSize += len;
+                return;
+            }
+        }
+
+        if (deferred.empty())
+        {
+            pipeline.writePacket(packetData, len);
+            return;
+        }
+
+        // Framed right away but only encrypted once its turn comes, the cipher being a stream
+        std::vector<std::byte> frame;
+        pipeline.compress.frame(packetData, len, frame);
+        defer(std::move(frame), len); }, current);
+}
+
+void PipelineStream::writeShared(const SharedPacket &packet)
+{
+    std::visit([this, &packet](auto &pipeline)
+               {
+        SharedPacket::Buffer frame = pipeline.getSharedFrame(packet);
+        if (deferred.empty())
+        {
+            pipeline.writeSharedFrame(frame);
+            return;
+        }
+
+        // Held back behind an offloaded packet, by reference as well
+        deferred.push_back({nextTicket++, {}, frame, frame->size(), true});
+        deferredSize += frame->size(); }, current);
+}
+
+void PipelineStream::flush()
+{
+    /* Everything is sent right away */
+}
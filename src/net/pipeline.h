@@ -0,0 +1,564 @@
+/**
+ * @file pipeline.h
+ * @author Lygaen
+ * @brief The file containing the outgoing packets pipeline
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MINESERVER_PIPELINE_H
+#define MINESERVER_PIPELINE_H
+
+#include <net/stream.h>
+#include <net/compressionpolicy.h>
+#include <utils/crypto.h>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <variant>
+#include <vector>
+
+/**
+ * @brief Stages of the outgoing packets pipeline
+ *
+ * A pipeline is made of a compression stage, building
+ * the frame from the packet, an encryption stage, working
+ * in place on the whole frame, and a socket stage, sending
+ * the frame. Stages are plain classes, the pipeline being
+ * a template they are all inlined together.
+ */
+namespace pipeline
+{
+    /**
+     * @brief Compression stage, without compression
+     *
+     */
+    class NoCompression
+    {
+    public:
+        /**
+         * @brief Whether the frame is the packet prefixed by its length
+         *
+         */
+        static constexpr bool PASSTHROUGH = true;
+
+        /**
+         * @brief Builds a frame
+         *
+         * @param packet the packet id and data
+         * @param len the length of @p packet
+         * @param out the buffer to append the frame to
+         */
+        void frame(const std::byte *packet, std::size_t len, std::vector<std::byte> &out);
+    };
+
+    /**
+     * @brief Compression stage, with ZLib compression
+     *
+     * Packets smaller than the threshold are sent
+     * uncompressed, following minecraft standard.
+     * With a policy, the level of the other ones
+     * depends on their id. Compressing being one-shot,
+     * the zlib states are shared by all of the stages
+     * of a thread.
+     */
+    class ZLibCompression
+    {
+    private:
+        int level;
+        std::size_t threshold;
+        CompressionPolicy *policy;
+        std::vector<std::byte> compressed;
+
+    public:
+        /**
+         * @brief Whether the frame is the packet prefixed by its length
+         *
+         */
+        static constexpr bool PASSTHROUGH = false;
+
+        /**
+         * @brief Construct a new ZLib Compression stage
+         *
+         * @param level the compression level
+         * @param threshold the size from which packets get compressed
+         * @param policy the policy picking the level of each packet, not owned, nullptr to always use @p level
+         */
+        ZLibCompression(int level, int threshold, CompressionPolicy *policy = nullptr);
+
+        /**
+         * @brief Get the compression level
+         *
+         * @return int the level packets are compressed with without a policy
+         */
+        int getLevel() const
+        {
+            return level;
+        }
+        /**
+         * @brief Get the compression threshold
+         *
+         * @return std::size_t the size from which packets get compressed
+         */
+        std::size_t getThreshold() const
+        {
+            return threshold;
+        }
+
+        /**
+         * @brief Builds a frame
+         *
+         * @param packet the packet id and data
+         * @param len the length of @p packet
+         * @param out the buffer to append the frame to
+         */
+        void frame(const std::byte *packet, std::size_t len, std::vector<std::byte> &out);
+    };
+
+    /**
+     * @brief Encryption stage, without encryption
+     *
+     */
+    class NoEncryption
+    {
+    public:
+        /**
+         * @brief Whether the data is left untouched
+         *
+         */
+        static constexpr bool PASSTHROUGH = true;
+
+        /**
+         * @brief Encrypts data in place
+         *
+         * @param data the data to encrypt
+         * @param len the length of @p data
+         */
+        void apply(std::byte *data, std::size_t len)
+        {
+            (void)data;
+            (void)len;
+        }
+    };
+
+    /**
+     * @brief Encryption stage, with AES/CFB8 encryption
+     *
+     */
+    class AESEncryption
+    {
+    private:
+        std::unique_ptr<crypto::AES128CFB8Cipher> cipher;
+
+    public:
+        /**
+         * @brief Whether the data is left untouched
+         *
+         */
+        static constexpr bool PASSTHROUGH = false;
+
+        /**
+         * @brief Construct a new AES Encryption stage
+         *
+         * @param key the shared secret, used as both key and IV
+         */
+        AESEncryption(const std::byte *key)
+            : cipher(std::make_unique<crypto::AES128CFB8Cipher>(crypto::CipherState::ENCRYPT, key, key)) {}
+
+        /**
+         * @brief Encrypts data in place
+         *
+         * @param data the data to encrypt
+         * @param len the length of @p data
+         */
+        void apply(std::byte *data, std::size_t len)
+        {
+            cipher->update(data, len, data);
+        }
+        /**
+         * @brief Encrypts data to another buffer
+         *
+         * @param data the data to encrypt
+         * @param len the length of @p data
+         * @param out the buffer to write the encrypted data to, at least @p len long
+         */
+        void apply(const std::byte *data, std::size_t len, std::byte *out)
+        {
+            cipher->update(data, len, out);
+        }
+    };
+
+    /**
+     * @brief Socket stage, sending to a NetSocketStream
+     *
+     */
+    class SocketSink
+    {
+    private:
+        NetSocketStream *socket;
+
+    public:
+        /**
+         * @brief Construct a new Socket Sink stage
+         *
+         * @param socket the stream to send to, not owned
+         */
+        SocketSink(NetSocketStream *socket) : socket(socket) {}
+
+        /**
+         * @brief Sends buffers
+         *
+         * @param buffers the buffers to send
+         * @param count the number of buffers
+         */
+        void send(SocketBuffer *buffers, std::size_t count)
+        {
+            socket->send(buffers, count);
+        }
+        /**
+         * @brief Sends a shared buffer, without copying it
+         *
+         * @param buffer the buffer to send
+         */
+        void send(const SharedPacket::Buffer &buffer)
+        {
+            socket->send(buffer);
+        }
+    };
+}
+
+/**
+ * @brief Outgoing packets pipeline
+ *
+ * Frames, compresses, encrypts and sends whole packets
+ * in a single pass, without any virtual call between
+ * the stages.
+ * @tparam Compress the compression stage
+ * @tparam Encrypt the encryption stage
+ * @tparam Socket the socket stage
+ */
+template <typename Compress, typename Encrypt, typename Socket>
+class Pipeline
+{
+private:
+    std::vector<std::byte> frame;
+
+public:
+    /**
+     * @brief Compression stage
+     *
+     */
+    Compress compress;
+    /**
+     * @brief Encryption stage
+     *
+     */
+    Encrypt encrypt;
+    /**
+     * @brief Socket stage
+     *
+     */
+    Socket socket;
+
+    /**
+     * @brief Construct a new Pipeline object
+     *
+     * @param compress the compression stage
+     * @param encrypt the encryption stage
+     * @param socket the socket stage
+     */
+    Pipeline(Compress &&compress, Encrypt &&encrypt, Socket &&socket)
+        : frame(), compress(std::move(compress)), encrypt(std::move(encrypt)), socket(std::move(socket)) {}
+
+    /**
+     * @brief Sends a packet
+     *
+     * @param packet the packet id and data
+     * @param len the length of @p packet
+     */
+    void writePacket(const std::byte *packet, std::size_t len)
+    {
+        if constexpr (Compress::PASSTHROUGH && Encrypt::PASSTHROUGH)
+        {
+            // Nothing to transform, the packet is sent as is
+            std::byte header[5];
+            SocketBuffer buffers[] = {
+                {header, varint::encode(static_cast<std::int32_t>(len), header)},
+                {packet, len}};
+            socket.send(buffers, 2);
+        }
+        else if constexpr (Compress::PASSTHROUGH)
+        {
+            // The cipher writes the frame, the packet is never copied as is
+            std::byte header[5];
+            std::size_t headerSize = varint::encode(static_cast<std::int32_t>(len), header);
+            frame.resize(headerSize + len);
+            encrypt.apply(header, headerSize, frame.data());
+            encrypt.apply(packet, len, frame.data() + headerSize);
+
+            SocketBuffer buffer{frame.data(), frame.size()};
+            socket.send(&buffer, 1);
+        }
+        else
+        {
+            frame.clear();
+            compress.frame(packet, len, frame);
+            encrypt.apply(frame.data(), frame.size());
+
+            SocketBuffer buffer{frame.data(), frame.size()};
+            socket.send(&buffer, 1);
+        }
+    }
+
+    /**
+     * @brief Sends raw data, without framing
+     *
+     * @param data the data to send
+     * @param len the length of @p data
+     */
+    void writeRaw(const std::byte *data, std::size_t len)
+    {
+        if constexpr (Encrypt::PASSTHROUGH)
+        {
+            SocketBuffer buffer{data, len};
+            socket.send(&buffer, 1);
+        }
+        else
+        {
+            frame.resize(len);
+            encrypt.apply(data, len, frame.data());
+
+            SocketBuffer buffer{frame.data(), frame.size()};
+            socket.send(&buffer, 1);
+        }
+    }
+
+    /**
+     * @brief Sends a frame built by the compression stage
+     *
+     * @param data the frame, encrypted in place
+     * @param len the length of @p data
+     */
+    void writeFrame(std::byte *data, std::size_t len)
+    {
+        encrypt.apply(data, len);
+
+        SocketBuffer buffer{data, len};
+        socket.send(&buffer, 1);
+    }
+
+    /**
+     * @brief Gets the frame of a shared packet for this pipeline
+     *
+     * Built by the compression stage the first time
+     * a pipeline with the same compression asks for it.
+     * @param packet the shared packet
+     * @return SharedPacket::Buffer the frame, not encrypted
+     */
+    SharedPacket::Buffer getSharedFrame(const SharedPacket &packet)
+    {
+        auto framer = [this](const std::byte *data, std::size_t len, std::vector<std::byte> &out)
+        { compress.frame(data, len, out); };
+
+        if constexpr (Compress::PASSTHROUGH)
+            return packet.getFrame(SharedPacket::UNCOMPRESSED, 0, framer);
+        else
+            return packet.getFrame(compress.getLevel(), compress.getThreshold(), framer);
+    }
+
+    /**
+     * @brief Sends a shared frame
+     *
+     * Sent by reference when not encrypted, otherwise
+     * the cipher reads it and writes the encrypted
+     * copy of this connection in a single pass.
+     * @param shared the frame built by Pipeline::getSharedFrame()
+     */
+    void writeSharedFrame(const SharedPacket::Buffer &shared)
+    {
+        if constexpr (Encrypt::PASSTHROUGH)
+        {
+            socket.send(shared);
+        }
+        else
+        {
+            frame.resize(shared->size());
+            encrypt.apply(shared->data(), shared->size(), frame.data());
+
+            SocketBuffer buffer{frame.data(), frame.size()};
+            socket.send(&buffer, 1);
+        }
+    }
+};
+
+/**
+ * @brief Stream over a pipeline
+ *
+ * Write-only stream sending packets through the
+ * Pipeline matching the state of the connection.
+ * It is only switched when compression or encryption
+ * get enabled, there is then a single virtual call
+ * per packet (IMCStream::finishPacketWrite()) instead
+ * of a chain of decorators for every written byte.
+ */
+class PipelineStream : public IMCStream
+{
+public:
+    /**
+     * @brief Hands a packet over to be compressed elsewhere
+     *
+     * Called with a ticket and the packet to compress, it
+     * should copy the packet and later give the compressed
+     * frame back to PipelineStream::completeOffload() on the
+     * thread using the stream, never before returning.
+     * Returns false if the packet could not be handed over,
+     * it is then compressed right away.
+     */
+    typedef std::function<bool(std::uint64_t ticket, const std::byte *packet, std::size_t len)> Offload;
+
+private:
+    struct Deferred
+    {
+        std::uint64_t ticket;
+        std::vector<std::byte> frame;
+        SharedPacket::Buffer shared;
+        std::size_t size;
+        bool ready;
+    };
+
+    std::variant<Pipeline<pipeline::NoCompression, pipeline::NoEncryption, pipeline::SocketSink>,
+                 Pipeline<pipeline::NoCompression, pipeline::AESEncryption, pipeline::SocketSink>,
+                 Pipeline<pipeline::ZLibCompression, pipeline::NoEncryption, pipeline::SocketSink>,
+                 Pipeline<pipeline::ZLibCompression, pipeline::AESEncryption, pipeline::SocketSink>>
+        current;
+
+    Offload offload;
+    std::size_t offloadSize;
+    std::deque<Deferred> deferred;
+    std::size_t deferredSize;
+    std::uint64_t nextTicket;
+
+    void defer(std::vector<std::byte> &&frame, std::size_t size);
+    void drain();
+
+public:
+    /**
+     * @brief Construct a new Pipeline Stream object
+     *
+     * @param socket the stream to send to, not owned
+     */
+    PipelineStream(NetSocketStream *socket);
+    /**
+     * @brief Destroy the Pipeline Stream object
+     *
+     */
+    ~PipelineStream() override = default;
+
+    /**
+     * @brief Enables encryption
+     *
+     * Everything sent afterwards is encrypted.
+     * @param key the shared secret, used as both key and IV
+     */
+    void enableEncryption(const std::byte *key);
+    /**
+     * @brief Enables compression
+     *
+     * Every packet sent afterwards is compressed.
+     * @param level the compression level
+     * @param threshold the size from which packets get compressed
+     * @param policy the policy picking the level of each packet, not owned, nullptr to always use @p level
+     */
+    void enableCompression(int level, int threshold, CompressionPolicy *policy = nullptr);
+    /**
+     * @brief Compresses the largest packets elsewhere
+     *
+     * Packets of at least @p size bytes are handed to
+     * @p offload once compression is enabled. Everything
+     * sent after one of them is held back until its frame
+     * is given back, so that the order is kept.
+     * @param size the size from which packets are handed over
+     * @param offload the function handing them over
+     */
+    void enableOffload(std::size_t size, Offload offload);
+    /**
+     * @brief Sends a frame compressed elsewhere
+     *
+     * Also sends whatever was held back behind it and
+     * is not waiting for another frame.
+     * @param ticket the ticket the packet was handed over with
+     * @param frame the compressed frame, empty if it failed
+     */
+    void completeOffload(std::uint64_t ticket, std::vector<std::byte> &frame);
+    /**
+     * @brief Whether packets are still being compressed elsewhere
+     *
+     * @return true some data is held back
+     * @return false everything was sent
+     */
+    bool hasPendingOffloads() const
+    {
+        return !deferred.empty();
+    }
+    /**
+     * @brief Get the size of the data held back
+     *
+     * @return std::size_t the number of bytes held back
+     */
+    std::size_t getDeferredSize() const
+    {
+        return deferredSize;
+    }
+
+    /**
+     * @brief Reading is not supported
+     *
+     * Received data is read using a FrameDecoder.
+     * @param buffer the buffer to write to
+     * @param offset the offset to start writing at
+     * @param len the maximum length to write
+     */
+    void read(std::byte *buffer, std::size_t offset, std::size_t len) override;
+    /**
+     * @brief Sends raw data, encrypting it if needed
+     *
+     * @param buffer the buffer to read from
+     * @param offset the offset to start reading from
+     * @param len the maximum read length
+     */
+    void write(const std::byte *buffer, std::size_t offset, std::size_t len) override;
+    /**
+     * @brief Gets the number of available bytes
+     *
+     * @return size_t always 0, reading is not supported
+     */
+    size_t available() override;
+    /**
+     * @brief Sends a packet through the pipeline
+     *
+     * @param packetData the packet data
+     * @param len the length of the packet data
+     */
+    void finishPacketWrite(const std::byte *packetData, size_t len) override;
+    /**
+     * @brief Sends a shared packet through the pipeline
+     *
+     * Its frame is built once for all of the connections
+     * with the same compression, then sent or queued
+     * without a copy (see Pipeline::writeSharedFrame()).
+     * @param packet the shared packet
+     */
+    void writeShared(const SharedPacket &packet) override;
+    /**
+     * @brief Flushes the stream
+     *
+     * Does nothing, everything is sent right away.
+     */
+    void flush() override;
+};
+
+#endif // MINESERVER_PIPELINE_H
@@ -0,0 +1,467 @@
+/**
+ * @file reactor.cpp
+ * @author Lygaen
+ * @brief The file containing the network event loop logic
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "reactor.h"
+#include <algorithm>
+#include <chrono>
+#include <utils/logger.h>
+#include <utils/metrics.h>
+#include <net/bufferpool.h>
+#include <net/outbound.h>
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+/**
+ * @brief Time spent waiting for readiness before checking for Reactor::stop()
+ *
+ */
+constexpr int POLL_TIMEOUT_MS = 100;
+/**
+ * @brief Max number of readiness events handled per wait
+ *
+ */
+constexpr int MAX_EVENTS = 64;
+/**
+ * @brief Max number of connections accepted per wait
+ *
+ * Keeps a connection storm from starving the clients
+ * already handled by the accepting thread.
+ */
+constexpr int ACCEPT_BATCH = 32;
+
+#if defined(__linux__)
+class Reactor::Poller
+{
+private:
+    int handle;
+    int wakeHandle;
+
+public:
+    Poller() : handle(epoll_create1(EPOLL_CLOEXEC)),
+               wakeHandle(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+    {
+        if (handle < 0 || wakeHandle < 0)
+            throw std::runtime_error("Could not create epoll instance");
+
+        // The poller itself stands for the wake up events
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.ptr = this;
+        if (epoll_ctl(handle, EPOLL_CTL_ADD, wakeHandle, &event) != 0)
+            throw std::runtime_error("Could not create epoll instance");
+    }
+
+    ~Poller()
+    {
+        ::close(wakeHandle);
+        ::close(handle);
+    }
+
+    bool add(socket_t sock, void *data)
+    {
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.ptr = data;
+        return epoll_ctl(handle, EPOLL_CTL_ADD, sock, &event) == 0;
+    }
+
+    void update(socket_t sock, void *data, bool read, bool write)
+    {
+        epoll_event event{};
+        event.events = (read ? (std::uint32_t)(EPOLLIN | EPOLLRDHUP) : 0u) | (write ? (std::uint32_t)EPOLLOUT : 0u);
+        event.data.ptr = data;
+        epoll_ctl(handle, EPOLL_CTL_MOD, sock, &event);
+    }
+
+    void remove(socket_t sock)
+    {
+        epoll_ctl(handle, EPOLL_CTL_DEL, sock, nullptr);
+    }
+
+    void wake()
+    {
+        std::uint64_t one = 1;
+        if (::write(wakeHandle, &one, sizeof(one)) < 0)
+            return; // Already signaled
+    }
+
+    template <typename F>
+    void wait(int timeout, F &&onReady)
+    {
+        epoll_event events[MAX_EVENTS];
+        int count = epoll_wait(handle, events, MAX_EVENTS, timeout);
+        for (int i = 0; i < count; i++)
+        {
+            if (events[i].data.ptr != this)
+            {
+                // Errors and hang ups are found out when reading
+                onReady(events[i].data.ptr,
+                        (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0,
+                        (events[i].events & EPOLLOUT) != 0);
+                continue;
+            }
+
+            std::uint64_t signaled;
+            if (::read(wakeHandle, &signaled, sizeof(signaled)) < 0)
+                continue;
+        }
+    }
+};
+#elif defined(_WIN32)
+class Reactor::Poller
+{
+private:
+    struct Watched
+    {
+        void *data;
+        SHORT events;
+    };
+
+    std::mutex lock;
+    std::unordered_map<socket_t, Watched> sockets;
+
+public:
+    bool add(socket_t sock, void *data)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        sockets[sock] = {data, POLLRDNORM};
+        return true;
+    }
+
+    void update(socket_t sock, void *data, bool read, bool write)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        sockets[sock] = {data, (SHORT)((read ? POLLRDNORM : 0) | (write ? POLLWRNORM : 0))};
+    }
+
+    void remove(socket_t sock)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        sockets.erase(sock);
+    }
+
+    void wake()
+    {
+        // WSAPoll only waits on sockets, tasks run after the current wait
+    }
+
+    template <typename F>
+    void wait(int timeout, F &&onReady)
+    {
+        std::vector<WSAPOLLFD> fds;
+        std::vector<void *> data;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (auto &entry : sockets)
+            {
+                fds.push_back({entry.first, entry.second.events, 0});
+                data.push_back(entry.second.data);
+            }
+        }
+
+        // WSAPoll fails on an empty set instead of waiting
+        if (fds.empty())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+            return;
+        }
+
+        int count = WSAPoll(fds.data(), (ULONG)fds.size(), timeout);
+        for (size_t i = 0; count > 0 && i < fds.size(); i++)
+        {
+            if (fds[i].revents == 0)
+                continue;
+            count--;
+            onReady(data[i], (fds[i].revents & (POLLRDNORM | POLLHUP | POLLERR)) != 0, (fds[i].revents & POLLWRNORM) != 0);
+        }
+    }
+};
+#endif
+
+Reactor::Reactor() : threadsLock(), threads(), running(false), sharded(false), nextThread(0)
+{
+}
+
+Reactor::~Reactor() = default;
+
+void Reactor::run(const std::vector<ServerSocket> &listeners, unsigned int threadsCount)
+{
+    threadsCount = std::max(1u, threadsCount);
+    sharded = listeners.size() > 1 && listeners.size() == threadsCount;
+    running = true;
+
+    for (unsigned int i = 0; i < threadsCount; i++)
+    {
+        auto io = std::make_unique<IOThread>();
+        io->index = i;
+        io->poller = std::make_unique<Poller>();
+        io->listening = sharded || i == 0;
+        if (io->listening)
+            io->listener = listeners[i];
+        io->accepted = 0;
+        io->queueFull = 0;
+        io->acceptRate = 0;
+        io->rateStart = std::chrono::steady_clock::now();
+        io->rateAccepted = 0;
+
+        // The listener gets no data pointer, so that it can be told apart from clients
+        if (io->listening && !io->poller->add(io->listener.getHandle(), nullptr))
+            throw std::runtime_error("Could not listen for incoming connections");
+
+        std::lock_guard<std::mutex> guard(threadsLock);
+        threads.push_back(std::move(io));
+    }
+
+    registerMetrics();
+
+    for (size_t i = 1; i < threads.size(); i++)
+    {
+        IOThread &io = *threads[i];
+        io.thread = std::thread([this, &io]()
+                                { loop(io); });
+    }
+
+    logger::debug("Started %d network threads (%s)", threads.size(), sharded ? "sharded listeners" : "shared listener");
+    loop(*threads[0]);
+
+    for (size_t i = 1; i < threads.size(); i++)
+        threads[i]->thread.join();
+
+    MetricsManager::inst().remove("net.shard");
+    MetricsManager::inst().remove("net.packet_buffers");
+    MetricsManager::inst().remove("net.outbound");
+
+    std::lock_guard<std::mutex> guard(threadsLock);
+    threads.clear();
+}
+
+void Reactor::stop()
+{
+    running = false;
+}
+
+void Reactor::loop(IOThread &io)
+{
+    while (running)
+    {
+        io.poller->wait(POLL_TIMEOUT_MS, [this, &io](void *data, bool readable, bool writable)
+                        {
+            (void)writable;
+            if (!data)
+            {
+                acceptBatch(io);
+                return;
+            }
+
+            // Writable clients only need a flush, always done after an event
+            auto *client = static_cast<Client *>(data);
+            bool wasReading = client->isReading();
+            bool wasWriting = client->hasPendingWrites();
+            if (readable)
+                client->onReadable();
+
+            updateClient(io, client, wasReading, wasWriting); });
+
+        runTasks(io);
+        if (io.listening)
+            updateAcceptRate(io);
+    }
+
+    closeAll(io);
+}
+
+void Reactor::acceptBatch(IOThread &io)
+{
+    // The listener is level-triggered, whatever is left in the queue wakes us up again
+    int count = 0;
+    for (; count < ACCEPT_BATCH && running; count++)
+    {
+        ClientSocket sock = io.listener.accept();
+        if (!sock.isValid())
+            break;
+
+        addClient(sharded ? io : *threads[nextThread++ % threads.size()], sock);
+    }
+    io.accepted += count;
+
+    // A full batch means the queue was not drained, check if it is full. Only an
+    // estimate of the drops : the system counts them, but for every socket at once
+    unsigned int pending, backlog;
+    if (count == ACCEPT_BATCH && io.listener.getAcceptQueue(pending, backlog) && pending >= backlog)
+        io.queueFull++;
+}
+
+void Reactor::updateAcceptRate(IOThread &io)
+{
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - io.rateStart;
+    if (elapsed.count() < 1)
+        return;
+
+    std::uint64_t accepted = io.accepted;
+    io.acceptRate = (double)(accepted - io.rateAccepted) / elapsed.count();
+    io.rateAccepted = accepted;
+    io.rateStart = now;
+}
+
+void Reactor::runTasks(IOThread &io)
+{
+    std::vector<PostedTask> tasks;
+    {
+        std::lock_guard<std::mutex> guard(io.tasksLock);
+        tasks.swap(io.tasks);
+    }
+
+    for (PostedTask &posted : tasks)
+    {
+        // Clients are only removed by their own thread, the pointer stays valid
+        Client *client = nullptr;
+        {
+            std::lock_guard<std::mutex> guard(io.clientsLock);
+            auto it = io.clients.find(posted.handle);
+            if (it != io.clients.end() && it->second->getId() == posted.clientId)
+                client = it->second.get();
+        }
+        if (!client)
+            continue;
+
+        bool wasReading = client->isReading();
+        bool wasWriting = client->hasPendingWrites();
+        posted.task(*client);
+
+        updateClient(io, client, wasReading, wasWriting);
+    }
+}
+
+void Reactor::updateClient(IOThread &io, Client *client, bool wasReading, bool wasWriting)
+{
+    bool writing = !client->flush();
+    if (!client->isRunning() && !client->hasPendingOffloads())
+    {
+        closeClient(io, client);
+        return;
+    }
+
+    bool reading = client->isReading();
+    if (reading != wasReading || writing != wasWriting)
+        io.poller->update(client->getSocket().getHandle(), client, reading, writing);
+}
+
+void Reactor::post(socket_t handle, std::uint64_t clientId, Task task)
+{
+    std::lock_guard<std::mutex> guard(threadsLock);
+    for (auto &thread : threads)
+    {
+        IOThread &io = *thread;
+        {
+            std::lock_guard<std::mutex> clientsGuard(io.clientsLock);
+            auto it = io.clients.find(handle);
+            if (it == io.clients.end() || it->second->getId() != clientId)
+                continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> tasksGuard(io.tasksLock);
+            io.tasks.push_back({handle, clientId, std::move(task)});
+        }
+        io.poller->wake();
+        return;
+    }
+}
+
+void Reactor::addClient(IOThread &io, const ClientSocket &sock)
+{
+    auto client = std::make_unique<Client>(sock, *this);
+    Client *ptr = client.get();
+
+    std::lock_guard<std::mutex> guard(io.clientsLock);
+    io.clients[sock.getHandle()] = std::move(client);
+    if (!io.poller->add(sock.getHandle(), ptr))
+    {
+        logger::error("Could not watch client connection from %s", sock.getAddress().c_str());
+        io.clients.erase(sock.getHandle());
+    }
+}
+
+void Reactor::closeClient(IOThread &io, Client *client)
+{
+    socket_t handle = client->getSocket().getHandle();
+    io.poller->remove(handle);
+
+    std::lock_guard<std::mutex> guard(io.clientsLock);
+    io.clients.erase(handle);
+}
+
+void Reactor::closeAll(IOThread &io)
+{
+    std::lock_guard<std::mutex> guard(io.clientsLock);
+    for (auto &entry : io.clients)
+    {
+        entry.second->close("Server closing");
+        entry.second->flush();
+        io.poller->remove(entry.first);
+    }
+    io.clients.clear();
+}
+
+void Reactor::registerMetrics()
+{
+    MetricsManager &metrics = MetricsManager::inst();
+
+    metrics.add("net.packet_buffers.allocations", []()
+                { return (double)PacketBufferPool::allocations(); });
+    metrics.add("net.outbound.queued_bytes", []()
+                { return (double)OutboundQueue::totalQueued(); });
+    metrics.add("net.outbound.overflows", []()
+                { return (double)OutboundQueue::totalOverflows(); });
+    metrics.add("net.outbound.copied_bytes", []()
+                { return (double)OutboundQueue::totalCopied(); });
+    metrics.add("net.outbound.shared_bytes", []()
+                { return (double)OutboundQueue::totalShared(); });
+    // Over the time since the previous collection
+    metrics.add("net.outbound.copy_rate", [copied = OutboundQueue::totalCopied(), since = std::chrono::steady_clock::now()]() mutable
+                {
+        auto now = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed = now - since;
+        std::uint64_t total = OutboundQueue::totalCopied();
+        double rate = elapsed.count() > 0 ? (double)(total - copied) / elapsed.count() : 0;
+        copied = total;
+        since = now;
+        return rate; });
+
+    for (auto &thread : threads)
+    {
+        IOThread *io = thread.get();
+        std::string prefix = "net.shard" + std::to_string(io->index) + ".";
+
+        metrics.add(prefix + "clients", [io]()
+                    {
+            std::lock_guard<std::mutex> guard(io->clientsLock);
+            return (double)io->clients.size(); });
+
+        if (!io->listening)
+            continue;
+
+        metrics.add(prefix + "accepted", [io]()
+                    { return (double)io->accepted; });
+        metrics.add(prefix + "accept_rate", [io]()
+                    { return (double)io->acceptRate; });
+        metrics.add(prefix + "accept_queue_full", [io]()
+                    { return (double)io->queueFull; });
+        metrics.add(prefix + "queue_pending", [io]()
+                    {
+            unsigned int pending = 0, backlog;
+            io->listener.getAcceptQueue(pending, backlog);
+            return (double)pending; });
+    }
+}
@@ -0,0 +1,154 @@
+/**
+ * @file reactor.h
+ * @author Lygaen
+ * @brief The file containing the network event loop
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MINESERVER_REACTOR_H
+#define MINESERVER_REACTOR_H
+
+#include <utils/network.h>
+#include <client.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Network event loop
+ *
+ * Multiplexes every client connection on a small
+ * fixed set of I/O threads instead of having one
+ * thread per connection. Each thread waits for
+ * readiness on its own clients (using epoll on Linux)
+ * and runs Client::onReadable() when data comes in.
+ * What clients send is flushed once per event, the
+ * rest waiting for the socket to become writable.
+ *
+ * Connections are either accepted by the first thread
+ * from a single listening socket and spread over all
+ * of the threads, or, when sharded, each thread accepts
+ * from its own SO_REUSEPORT listening socket and keeps
+ * the connections it accepted.
+ * Work done outside of the I/O threads is handed back
+ * to the thread of its client with Reactor::post().
+ */
+class Reactor
+{
+public:
+    /**
+     * @brief Work to run on the I/O thread of a client
+     *
+     */
+    typedef std::function<void(Client &)> Task;
+
+private:
+    /**
+     * @brief Poller handle for an I/O thread
+     *
+     * Wraps around epoll on Linux and WSAPoll on Windows.
+     */
+    class Poller;
+
+    struct PostedTask
+    {
+        socket_t handle;
+        std::uint64_t clientId;
+        Task task;
+    };
+
+    struct IOThread
+    {
+        std::size_t index;
+        std::unique_ptr<Poller> poller;
+        std::mutex clientsLock;
+        std::unordered_map<socket_t, std::unique_ptr<Client>> clients;
+        std::mutex tasksLock;
+        std::vector<PostedTask> tasks;
+        std::thread thread;
+
+        bool listening;
+        ServerSocket listener;
+        std::atomic<std::uint64_t> accepted;
+        std::atomic<std::uint64_t> queueFull;
+        std::atomic<double> acceptRate;
+        std::chrono::steady_clock::time_point rateStart;
+        std::uint64_t rateAccepted;
+    };
+
+    std::mutex threadsLock;
+    std::vector<std::unique_ptr<IOThread>> threads;
+    std::atomic<bool> running;
+    bool sharded;
+    std::size_t nextThread;
+
+    void loop(IOThread &io);
+    void acceptBatch(IOThread &io);
+    void updateAcceptRate(IOThread &io);
+    void runTasks(IOThread &io);
+    void updateClient(IOThread &io, Client *client, bool wasReading, bool wasWriting);
+    void addClient(IOThread &io, const ClientSocket &sock);
+    void closeClient(IOThread &io, Client *client);
+    void closeAll(IOThread &io);
+    void registerMetrics();
+
+public:
+    /**
+     * @brief Construct a new Reactor object
+     *
+     */
+    Reactor();
+    /**
+     * @brief Destroy the Reactor object
+     *
+     */
+    ~Reactor();
+
+    /**
+     * @brief Runs the event loop, blocking
+     *
+     * Spawns @p threadsCount - 1 I/O threads, the
+     * calling thread being the first one, and
+     * returns once Reactor::stop() was called
+     * and all of the clients were closed.
+     *
+     * If there are as many @p listeners as threads,
+     * the listeners are sharded, one per thread. Otherwise
+     * the first listener is used by the first thread.
+     * @param listeners the listening sockets to accept from, left open
+     * @param threadsCount the number of I/O threads, at least 1
+     */
+    void run(const std::vector<ServerSocket> &listeners, unsigned int threadsCount);
+    /**
+     * @brief Stops the event loop
+     *
+     * Every I/O thread closes its clients
+     * and exits shortly after.
+     */
+    void stop();
+
+    /**
+     * @brief Runs a task on the I/O thread of a client
+     *
+     * Thread-safe, wakes the thread up right away (only
+     * on Linux, otherwise after at most a poll timeout).
+     * The task is dropped if the client is closed before
+     * it gets to run.
+     * @param handle the handle of the client socket
+     * @param clientId the id of the client (see Client::getId()), as handles get reused
+     * @param task the task to run
+     */
+    void post(socket_t handle, std::uint64_t clientId, Task task);
+};
+
+#endif // MINESERVER_REACTOR_H
@@ -0,0 +1,591 @@
+/**
+ * @file session.cpp
+ * @author Lygaen
+ * @brief The file containing the session server client logic
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "session.h"
+#include <utils/logger.h>
+#include <rapidjson/document.h>
+#include <openssl/err.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#if defined(__linux__)
+#include <arpa/inet.h>
+#endif
+
+/**
+ * @brief Time the resolved address of the session server is kept
+ *
+ */
+constexpr std::chrono::seconds DNS_TTL(300);
+/**
+ * @brief Time after which an unused connection is not trusted anymore
+ *
+ * Servers close idle keep-alive connections on their
+ * own, reusing them would most likely fail.
+ */
+constexpr std::chrono::seconds IDLE_TIMEOUT(15);
+/**
+ * @brief Max size of a response, headers included
+ *
+ */
+constexpr std::size_t MAX_RESPONSE_SIZE = 64 * 1024;
+/**
+ * @brief Max number of queued requests
+ *
+ * Joins are refused past this point instead of
+ * waiting longer than any client would.
+ */
+constexpr std::size_t MAX_QUEUED = 1024;
+
+struct SessionClient::Connection
+{
+    std::unique_ptr<ClientSocket> sock;
+    SSL *ssl = nullptr;
+    std::string buffer;
+    std::chrono::steady_clock::time_point lastUsed;
+
+    void close(bool notify)
+    {
+        if (ssl)
+        {
+            // Only a healthy connection can be shut down properly
+            if (notify)
+                SSL_shutdown(ssl);
+            SSL_free(ssl);
+            ssl = nullptr;
+        }
+        if (sock)
+        {
+            sock->close();
+            sock.reset();
+        }
+        buffer.clear();
+        ERR_clear_error();
+    }
+};
+
+static std::string urlEncode(const std::string &value)
+{
+    static const char *HEX = "0123456789ABCDEF";
+
+    std::string encoded;
+    encoded.reserve(value.size());
+    for (unsigned char c : value)
+    {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~')
+        {
+            encoded += (char)c;
+            continue;
+        }
+        encoded += '%';
+        encoded += HEX[c >> 4];
+        encoded += HEX[c & 0xF];
+    }
+    return encoded;
+}
+
+static std::string lowercase(std::string value)
+{
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c)
+                   { return (char)std::tolower(c); });
+    return value;
+}
+
+static std::string trim(const std::string &value)
+{
+    std::size_t start = value.find_first_not_of(" \t");
+    if (start == std::string::npos)
+        return "";
+    return value.substr(start, value.find_last_not_of(" \t") - start + 1);
+}
+
+SessionClient *SessionClient::instance = nullptr;
+SessionClient::SessionClient() : options(),
+                                 ctx(nullptr),
+                                 running(false),
+                                 queueLock(),
+                                 queueCond(),
+                                 queue(),
+                                 workers(),
+                                 dnsLock(),
+                                 dnsAddress(),
+                                 dnsExpiry(),
+                                 sessionLock(),
+                                 session(nullptr),
+                                 pending(0),
+                                 requests(0),
+                                 failures(0),
+                                 connects(0),
+                                 latency(0)
+{
+    if (instance)
+        throw std::runtime_error("Session client should not be constructed twice");
+
+    instance = this;
+}
+
+SessionClient::~SessionClient()
+{
+    stop();
+
+    if (instance == this)
+        instance = nullptr;
+}
+
+void SessionClient::start(const Options &opts)
+{
+    if (running)
+        throw std::runtime_error("Session client is already started");
+
+    options = opts;
+    options.connections = std::max(1u, options.connections);
+
+    ctx = SSL_CTX_new(TLS_client_method());
+    if (!ctx)
+        throw std::runtime_error("Could not initialize SSL context");
+
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+    int trusted = options.caFile.empty() ? SSL_CTX_set_default_verify_paths(ctx)
+                                         : SSL_CTX_load_verify_locations(ctx, options.caFile.c_str(), nullptr);
+    if (trusted != 1)
+    {
+        SSL_CTX_free(ctx);
+        ctx = nullptr;
+        throw std::runtime_error("Could not load trusted certificates");
+    }
+
+    // A single session is kept for all of the workers, see SessionClient::onNewSession()
+    SSL_CTX_set_app_data(ctx, this);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx, &SessionClient::onNewSession);
+
+    running = true;
+    for (unsigned int i = 0; i < options.connections; i++)
+        workers.emplace_back(&SessionClient::work, this);
+
+    logger::debug("Session client started with %u connections to %s:%d", options.connections, options.host.c_str(), options.port);
+}
+
+void SessionClient::stop()
+{
+    std::deque<Request> dropped;
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        if (!running)
+            return;
+        running = false;
+        dropped.swap(queue);
+    }
+    queueCond.notify_all();
+
+    for (std::thread &worker : workers)
+        worker.join();
+    workers.clear();
+
+    Result result;
+    result.error = "Server closing";
+    for (Request &request : dropped)
+    {
+        pending--;
+        request.callback(result);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(sessionLock);
+        SSL_SESSION_free(session);
+        session = nullptr;
+    }
+    SSL_CTX_free(ctx);
+    ctx = nullptr;
+}
+
+void SessionClient::hasJoined(const std::string &username, const std::string &serverId, const std::string &ip, Callback callback)
+{
+    std::string path = "/session/minecraft/hasJoined?username=" + urlEncode(username) + "&serverId=" + urlEncode(serverId);
+    if (!ip.empty())
+        path += "&ip=" + urlEncode(ip);
+
+    Result result;
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        if (running && queue.size() < MAX_QUEUED)
+        {
+            pending++;
+            queue.push_back({std::move(path), std::move(callback)});
+            queueCond.notify_one();
+            return;
+        }
+        result.error = running ? "Too many players authenticating" : "Session client is not started";
+    }
+
+    failures++;
+    callback(result);
+}
+
+int SessionClient::onNewSession(SSL *ssl, SSL_SESSION *newSession)
+{
+    auto *client = static_cast<SessionClient *>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+
+    std::lock_guard<std::mutex> guard(client->sessionLock);
+    SSL_SESSION_free(client->session);
+    client->session = newSession;
+
+    // Keeps the reference OpenSSL gave us
+    return 1;
+}
+
+void SessionClient::work()
+{
+    Connection conn;
+
+    while (true)
+    {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(queueLock);
+            queueCond.wait(lock, [this]()
+                           { return !running || !queue.empty(); });
+            if (!running)
+                break;
+
+            request = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        Result result = query(conn, request.path);
+        latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        requests++;
+        pending--;
+
+        try
+        {
+            request.callback(result);
+        }
+        catch (const std::exception &err)
+        {
+            logger::error("Session callback failed : %s", err.what());
+        }
+    }
+
+    conn.close(true);
+}
+
+SessionClient::Result SessionClient::query(Connection &conn, const std::string &path)
+{
+    Result result;
+    int status = 0;
+    std::string body;
+
+    if (conn.ssl && std::chrono::steady_clock::now() - conn.lastUsed > IDLE_TIMEOUT)
+        conn.close(true);
+
+    bool answered = false;
+    for (int attempt = 0; attempt < 2 && !answered; attempt++)
+    {
+        bool reused = conn.ssl != nullptr;
+        if (!reused && !connect(conn, result.error))
+            break;
+
+        answered = exchange(conn, path, status, body, result.error);
+        if (answered)
+            continue;
+
+        conn.close(false);
+        // The server may have closed a kept alive connection, a fresh one is given a single try
+        if (!reused)
+            break;
+    }
+
+    if (!answered)
+    {
+        failures++;
+        return result;
+    }
+    conn.lastUsed = std::chrono::steady_clock::now();
+
+    if (status == 204)
+    {
+        // The player did not join the server through the session server
+        result.error = "Failed to verify username";
+        return result;
+    }
+    if (status != 200)
+    {
+        failures++;
+        result.error = "Session server answered with status " + std::to_string(status);
+        return result;
+    }
+
+    rapidjson::Document doc;
+    doc.Parse(body.c_str());
+
+    if (doc.HasParseError() || !doc.IsObject() ||
+        !doc.HasMember("id") || !doc["id"].IsString() ||
+        !doc.HasMember("name") || !doc["name"].IsString())
+    {
+        failures++;
+        result.error = "Could not parse JSON response";
+        return result;
+    }
+
+    try
+    {
+        result.response.name = std::string(doc["name"].GetString(), doc["name"].GetStringLength());
+        result.response.id = MinecraftUUID::fromHex(std::string(doc["id"].GetString(), doc["id"].GetStringLength()));
+    }
+    catch (const std::exception &err)
+    {
+        failures++;
+        result.error = err.what();
+        return result;
+    }
+
+    result.joined = true;
+    result.error.clear();
+    return result;
+}
+
+std::string SessionClient::resolve()
+{
+    // Held while resolving, concurrent connections wait for a single lookup
+    std::lock_guard<std::mutex> guard(dnsLock);
+
+    auto now = std::chrono::steady_clock::now();
+    if (!dnsAddress.empty() && now < dnsExpiry)
+        return dnsAddress;
+
+    struct addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *results = nullptr;
+    if (getaddrinfo(options.host.c_str(), nullptr, &hints, &results) != 0 || !results)
+    {
+        // Better a stale address than none
+        return dnsAddress;
+    }
+
+    char address[INET_ADDRSTRLEN];
+    auto *addr = reinterpret_cast<struct sockaddr_in *>(results->ai_addr);
+    inet_ntop(AF_INET, &addr->sin_addr, address, sizeof(address));
+    freeaddrinfo(results);
+
+    dnsAddress = address;
+    dnsExpiry = now + DNS_TTL;
+    return dnsAddress;
+}
+
+bool SessionClient::connect(Connection &conn, std::string &error)
+{
+    std::string address = resolve();
+    if (address.empty())
+    {
+        error = "Could not resolve " + options.host;
+        return false;
+    }
+
+    conn.sock = std::make_unique<ClientSocket>(SOCK_STREAM);
+    if (!conn.sock->isValid() || !conn.sock->setTimeout(options.timeout) ||
+        !conn.sock->connect(address.c_str(), options.port))
+    {
+        {
+            // The address may have changed, it is resolved again next time
+            std::lock_guard<std::mutex> guard(dnsLock);
+            dnsExpiry = std::chrono::steady_clock::time_point();
+        }
+        conn.close(false);
+        error = "Could not connect to " + options.host;
+        return false;
+    }
+
+    conn.ssl = SSL_new(ctx);
+    if (!conn.ssl)
+    {
+        conn.close(false);
+        error = "Could not initialize SSL";
+        return false;
+    }
+    SSL_set_fd(conn.ssl, (int)conn.sock->getHandle());
+    SSL_set_tlsext_host_name(conn.ssl, options.host.c_str());
+    SSL_set1_host(conn.ssl, options.host.c_str());
+
+    {
+        // Resuming skips most of the handshake
+        std::lock_guard<std::mutex> guard(sessionLock);
+        if (session)
+            SSL_set_session(conn.ssl, session);
+    }
+
+    if (SSL_connect(conn.ssl) != 1)
+    {
+        conn.close(false);
+        error = "Could not establish TLS with " + options.host;
+        return false;
+    }
+
+    connects++;
+    return true;
+}
+
+bool SessionClient::exchange(Connection &conn, const std::string &path, int &status, std::string &body, std::string &error)
+{
+    std::string request = "GET " + path + " HTTP/1.1\r\n" +
+                          "Host: " + options.host + "\r\n" +
+                          "User-Agent: mineserver\r\n"
+                          "Accept: application/json\r\n"
+                          "Connection: keep-alive\r\n\r\n";
+
+    if (SSL_write(conn.ssl, request.data(), (int)request.size()) != (int)request.size())
+    {
+        error = "Could not write to session server";
+        return false;
+    }
+
+    std::string &buffer = conn.buffer;
+    buffer.clear();
+
+    auto receive = [&conn]()
+    {
+        if (conn.buffer.size() >= MAX_RESPONSE_SIZE)
+            return false;
+
+        char data[4096];
+        int len = SSL_read(conn.ssl, data, sizeof(data));
+        if (len <= 0)
+            return false;
+
+        conn.buffer.append(data, len);
+        return true;
+    };
+    auto truncated = [&error]()
+    {
+        error = "Could not read from session server";
+        return false;
+    };
+
+    std::size_t headerEnd;
+    while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos)
+    {
+        if (!receive())
+            return truncated();
+    }
+
+    // Status line, such as HTTP/1.1 200 OK
+    std::size_t lineEnd = buffer.find("\r\n");
+    if (buffer.compare(0, 5, "HTTP/") != 0 || lineEnd < 12)
+    {
+        error = "Invalid response from session server";
+        return false;
+    }
+    status = std::atoi(buffer.c_str() + 9);
+    bool keepAlive = buffer.compare(0, 8, "HTTP/1.1") == 0;
+
+    bool chunked = false;
+    long long contentLength = -1;
+    for (std::size_t pos = lineEnd + 2; pos < headerEnd;)
+    {
+        std::size_t end = buffer.find("\r\n", pos);
+        std::size_t colon = buffer.find(':', pos);
+        if (colon < end)
+        {
+            std::string name = lowercase(buffer.substr(pos, colon - pos));
+            std::string value = lowercase(trim(buffer.substr(colon + 1, end - colon - 1)));
+
+            if (name == "content-length")
+                contentLength = std::strtoll(value.c_str(), nullptr, 10);
+            else if (name == "transfer-encoding")
+                chunked = value.find("chunked") != std::string::npos;
+            else if (name == "connection")
+                keepAlive = value == "close" ? false : (value == "keep-alive" ? true : keepAlive);
+        }
+        pos = end + 2;
+    }
+
+    body.clear();
+    std::size_t offset = headerEnd + 4;
+
+    if (status == 204 || status == 304)
+    {
+        // No body
+    }
+    else if (chunked)
+    {
+        // Chunks are <hex size>\r\n<data>\r\n, until an empty one
+        while (true)
+        {
+            std::size_t end;
+            while ((end = buffer.find("\r\n", offset)) == std::string::npos)
+            {
+                if (!receive())
+                    return truncated();
+            }
+
+            std::size_t size = std::strtoul(buffer.c_str() + offset, nullptr, 16);
+            offset = end + 2;
+            if (size == 0)
+                break;
+            if (size > MAX_RESPONSE_SIZE)
+                return truncated();
+
+            while (buffer.size() < offset + size + 2)
+            {
+                if (!receive())
+                    return truncated();
+            }
+            body.append(buffer, offset, size);
+            offset += size + 2;
+        }
+
+        // Trailers, until an empty line
+        while (true)
+        {
+            std::size_t end;
+            while ((end = buffer.find("\r\n", offset)) == std::string::npos)
+            {
+                if (!receive())
+                    return truncated();
+            }
+
+            bool last = end == offset;
+            offset = end + 2;
+            if (last)
+                break;
+        }
+    }
+    else if (contentLength >= 0)
+    {
+        if ((std::size_t)contentLength > MAX_RESPONSE_SIZE)
+            return truncated();
+
+        while (buffer.size() < offset + (std::size_t)contentLength)
+        {
+            if (!receive())
+                return truncated();
+        }
+        body = buffer.substr(offset, contentLength);
+    }
+    else
+    {
+        // The body ends with the connection
+        while (receive())
+            ;
+        body = buffer.substr(offset);
+        keepAlive = false;
+    }
+
+    if (!keepAlive)
+        conn.close(true);
+    return true;
+}
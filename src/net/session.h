@@ -0,0 +1,271 @@
+/**
+ * @file session.h
+ * @author Lygaen
+ * @brief The file containing the session server client
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MINESERVER_SESSION_H
+#define MINESERVER_SESSION_H
+
+#include <utils/network.h>
+#include <types/uuid.h>
+#include <openssl/ssl.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief The Mojang API holder
+ *
+ */
+namespace mojangapi
+{
+    /**
+     * @brief Reponse for the hasJoined endpoint
+     *
+     */
+    struct HasJoinedResponse
+    {
+        /**
+         * @brief Name of the player
+         *
+         */
+        std::string name;
+        /**
+         * @brief MinecraftUUID of the player
+         *
+         */
+        MinecraftUUID id;
+    };
+}
+
+/**
+ * @brief Session server client
+ *
+ * Verifies joining players against the session server
+ * (Mojang's by default) without blocking the network
+ * threads. Requests are queued and sent by a fixed set
+ * of workers, bounding the number of requests in flight.
+ * Each worker keeps its own TLS connection alive between
+ * requests, resuming the TLS session when it has to
+ * reconnect, and the address of the server is resolved
+ * once for all of them.
+ */
+class SessionClient
+{
+public:
+    /**
+     * @brief Session server endpoint and limits
+     *
+     */
+    struct Options
+    {
+        /**
+         * @brief Host name of the session server
+         *
+         */
+        std::string host = "sessionserver.mojang.com";
+        /**
+         * @brief HTTPS port of the session server
+         *
+         */
+        int port = 443;
+        /**
+         * @brief Max number of requests in flight, one connection each
+         *
+         */
+        unsigned int connections = 4;
+        /**
+         * @brief Timeout of connecting, sending and receiving, in milliseconds
+         *
+         */
+        int timeout = 5000;
+        /**
+         * @brief Certificates to trust, the system ones if empty
+         *
+         */
+        std::string caFile;
+    };
+
+    /**
+     * @brief Result of a verification
+     *
+     */
+    struct Result
+    {
+        /**
+         * @brief Whether the player has joined, the response being set
+         *
+         */
+        bool joined = false;
+        /**
+         * @brief The response of the session server
+         *
+         */
+        mojangapi::HasJoinedResponse response;
+        /**
+         * @brief Why the player could not be verified
+         *
+         */
+        std::string error;
+    };
+
+    /**
+     * @brief Called with the result of a verification
+     *
+     * Runs on one of the workers, it must not block
+     * and should hand the result over to the network
+     * thread of the client (see Reactor::post()).
+     */
+    typedef std::function<void(const Result &)> Callback;
+
+private:
+    struct Request
+    {
+        std::string path;
+        Callback callback;
+    };
+    struct Connection;
+
+    Options options;
+    SSL_CTX *ctx;
+    bool running;
+    std::mutex queueLock;
+    std::condition_variable queueCond;
+    std::deque<Request> queue;
+    std::vector<std::thread> workers;
+
+    std::mutex dnsLock;
+    std::string dnsAddress;
+    std::chrono::steady_clock::time_point dnsExpiry;
+
+    std::mutex sessionLock;
+    SSL_SESSION *session;
+
+    std::atomic<std::uint64_t> pending;
+    std::atomic<std::uint64_t> requests;
+    std::atomic<std::uint64_t> failures;
+    std::atomic<std::uint64_t> connects;
+    std::atomic<double> latency;
+
+    static SessionClient *instance;
+
+    static int onNewSession(SSL *ssl, SSL_SESSION *newSession);
+    void work();
+    Result query(Connection &conn, const std::string &path);
+    bool connect(Connection &conn, std::string &error);
+    bool exchange(Connection &conn, const std::string &path, int &status, std::string &body, std::string &error);
+    std::string resolve();
+
+public:
+    /**
+     * @brief Construct a new Session Client object
+     *
+     * The client is idle until SessionClient::start() is called.
+     */
+    SessionClient();
+    /**
+     * @brief Destroy the Session Client object
+     *
+     */
+    ~SessionClient();
+
+    /**
+     * @brief Starts the workers
+     *
+     * @param options the endpoint and limits to use
+     */
+    void start(const Options &options);
+    /**
+     * @brief Stops the workers
+     *
+     * Waits for the requests in flight, the ones
+     * still queued fail right away.
+     */
+    void stop();
+
+    /**
+     * @brief Checks whether the player has joined the server
+     *
+     * Only used during authentication scheme. Never blocks,
+     * @p callback is called once the session server answered,
+     * failed to or timed out.
+     * @param username the username of the player
+     * @param serverId the hash (aka the server id)
+     * @param ip the ip of the client if needed, empty otherwise
+     * @param callback the callback to call with the result
+     */
+    void hasJoined(const std::string &username, const std::string &serverId, const std::string &ip, Callback callback);
+
+    /**
+     * @brief Get the number of verifications not answered yet
+     *
+     * @return std::uint64_t the number of queued and in flight requests
+     */
+    std::uint64_t getPending() const
+    {
+        return pending;
+    }
+    /**
+     * @brief Get the number of answered verifications
+     *
+     * @return std::uint64_t the number of requests
+     */
+    std::uint64_t getRequests() const
+    {
+        return requests;
+    }
+    /**
+     * @brief Get the number of verifications that failed
+     *
+     * Counts the requests that got no usable answer,
+     * not the players that were not authenticated.
+     * @return std::uint64_t the number of failed requests
+     */
+    std::uint64_t getFailures() const
+    {
+        return failures;
+    }
+    /**
+     * @brief Get the number of opened connections
+     *
+     * @return std::uint64_t the number of connections
+     */
+    std::uint64_t getConnects() const
+    {
+        return connects;
+    }
+    /**
+     * @brief Get the latency of the last request
+     *
+     * @return double the latency in milliseconds
+     */
+    double getLatency() const
+    {
+        return latency;
+    }
+
+    /**
+     * @brief Gets Session Client instance
+     *
+     * @return SessionClient& the instance
+     */
+    static SessionClient &inst()
+    {
+        return *instance;
+    }
+};
+
+#endif // MINESERVER_SESSION_H
@@ -0,0 +1,110 @@
+/**
+ * @file sessioncache.cpp
+ * @author Lygaen
+ * @brief The file containing the verified sessions cache logic
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "sessioncache.h"
+#include <algorithm>
+#include <stdexcept>
+
+SessionCache *SessionCache::instance = nullptr;
+SessionCache::SessionCache() : ttl(std::chrono::steady_clock::duration::zero()),
+                               lock(),
+                               entries(),
+                               hits(0),
+                               misses(0)
+{
+    if (instance)
+        throw std::runtime_error("Session cache should not be constructed twice");
+
+    instance = this;
+}
+
+SessionCache::~SessionCache()
+{
+    if (instance == this)
+        instance = nullptr;
+}
+
+std::string SessionCache::key(const std::string &username, const std::string &address)
+{
+    std::string key = username;
+    key += '\0';
+    key += address;
+    return key;
+}
+
+void SessionCache::purge(std::chrono::steady_clock::time_point now)
+{
+    for (auto it = entries.begin(); it != entries.end();)
+    {
+        if (it->second.expiry <= now)
+            it = entries.erase(it);
+        else
+            ++it;
+    }
+}
+
+void SessionCache::setTTL(std::chrono::steady_clock::duration value)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    ttl = std::max(value, std::chrono::steady_clock::duration::zero());
+    entries.clear();
+}
+
+bool SessionCache::find(const std::string &username, const std::string &address, mojangapi::HasJoinedResponse &response)
+{
+    if (!isEnabled())
+        return false;
+
+    std::string entryKey = key(username, address);
+    std::lock_guard<std::mutex> guard(lock);
+
+    auto it = entries.find(entryKey);
+    if (it == entries.end() || it->second.expiry <= std::chrono::steady_clock::now())
+    {
+        misses++;
+        return false;
+    }
+
+    hits++;
+    response = it->second.response;
+    return true;
+}
+
+void SessionCache::store(const std::string &username, const std::string &address, const mojangapi::HasJoinedResponse &response)
+{
+    if (!isEnabled())
+        return;
+
+    std::string entryKey = key(username, address);
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> guard(lock);
+
+    if (entries.size() >= MAX_ENTRIES && entries.find(entryKey) == entries.end())
+    {
+        purge(now);
+        if (entries.size() >= MAX_ENTRIES)
+            return;
+    }
+
+    entries[entryKey] = {response, now + ttl.load()};
+}
+
+void SessionCache::clear()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    entries.clear();
+}
+
+std::size_t SessionCache::getSize()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return entries.size();
+}
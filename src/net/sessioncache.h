@@ -0,0 +1,162 @@
+/**
+ * @file sessioncache.h
+ * @author Lygaen
+ * @brief The file containing the verified sessions cache
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MINESERVER_SESSIONCACHE_H
+#define MINESERVER_SESSIONCACHE_H
+
+#include <net/session.h>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief Cache of the players verified by the session server
+ *
+ * Remembers for a short time the players the session
+ * server verified, so that players reconnecting all at
+ * once (after a proxy restart for instance) are not all
+ * verified again. Players are only trusted again with the
+ * same name and from the same address. It is disabled until
+ * given a TTL.
+ *
+ * A hit trusts the address of the player for the TTL, so it
+ * must only be used for the players the session server checked
+ * the address of (with prevent proxy connections), and not
+ * for local ones. The TTL should be kept short.
+ */
+class SessionCache
+{
+public:
+    /**
+     * @brief Max number of cached players
+     *
+     */
+    static constexpr std::size_t MAX_ENTRIES = 4096;
+
+private:
+    struct Entry
+    {
+        mojangapi::HasJoinedResponse response;
+        std::chrono::steady_clock::time_point expiry;
+    };
+
+    std::atomic<std::chrono::steady_clock::duration> ttl;
+    std::mutex lock;
+    std::unordered_map<std::string, Entry> entries;
+
+    std::atomic<std::uint64_t> hits;
+    std::atomic<std::uint64_t> misses;
+
+    static SessionCache *instance;
+
+    static std::string key(const std::string &username, const std::string &address);
+    void purge(std::chrono::steady_clock::time_point now);
+
+public:
+    /**
+     * @brief Construct a new Session Cache object
+     *
+     * The cache is disabled until SessionCache::setTTL() is called.
+     */
+    SessionCache();
+    /**
+     * @brief Destroy the Session Cache object
+     *
+     */
+    ~SessionCache();
+
+    /**
+     * @brief Sets the time players stay verified
+     *
+     * Also clears the cache.
+     * @param ttl the time to live, zero or less to disable the cache
+     */
+    void setTTL(std::chrono::steady_clock::duration ttl);
+    /**
+     * @brief Whether the cache is enabled
+     *
+     * @return true players are cached
+     * @return false they are not
+     */
+    bool isEnabled() const
+    {
+        return ttl.load() > std::chrono::steady_clock::duration::zero();
+    }
+
+    /**
+     * @brief Finds a verified player
+     *
+     * @param username the username the player logs in with
+     * @param address the address the player connects from
+     * @param response the response of the session server when it verified the player
+     * @return true the player was verified less than a TTL ago
+     * @return false it was not, it has to be verified
+     */
+    bool find(const std::string &username, const std::string &address, mojangapi::HasJoinedResponse &response);
+    /**
+     * @brief Stores a player the session server verified
+     *
+     * Does nothing when the cache is disabled or full
+     * of players verified less than a TTL ago.
+     * @param username the username the player logged in with
+     * @param address the address the player connected from
+     * @param response the response of the session server
+     */
+    void store(const std::string &username, const std::string &address, const mojangapi::HasJoinedResponse &response);
+    /**
+     * @brief Forgets every player
+     *
+     */
+    void clear();
+
+    /**
+     * @brief Get the number of players found in the cache
+     *
+     * @return std::uint64_t the number of hits
+     */
+    std::uint64_t getHits() const
+    {
+        return hits;
+    }
+    /**
+     * @brief Get the number of players not found in the cache
+     *
+     * Not counted when the cache is disabled.
+     * @return std::uint64_t the number of misses
+     */
+    std::uint64_t getMisses() const
+    {
+        return misses;
+    }
+    /**
+     * @brief Get the number of cached players
+     *
+     * Includes the expired ones not purged yet.
+     * @return std::size_t the number of players
+     */
+    std::size_t getSize();
+
+    /**
+     * @brief Gets Session Cache instance
+     *
+     * @return SessionCache& the instance
+     */
+    static SessionCache &inst()
+    {
+        return *instance;
+    }
+};
+
+#endif // MINESERVER_SESSIONCACHE_H
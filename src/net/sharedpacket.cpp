@@ -0,0 +1,37 @@
+/**
+ * @file sharedpacket.cpp
+ * @author Lygaen
+ * @brief The file containing the packets shared by many connections logic
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "sharedpacket.h"
+
+SharedPacket::SharedPacket(std::vector<std::byte> packet) : packet(std::move(packet)),
+                                                            lock(),
+                                                            frames()
+{
+}
+
+SharedPacket::Buffer SharedPacket::getFrame(int level, std::size_t threshold, const Framer &framer) const
+{
+    if (level == UNCOMPRESSED)
+        threshold = 0;
+
+    // A couple of settings at most, compression being the same for all of the players
+    std::lock_guard<std::mutex> guard(lock);
+    for (const Frame &frame : frames)
+    {
+        if (frame.level == level && frame.threshold == threshold)
+            return frame.buffer;
+    }
+
+    auto buffer = std::make_shared<std::vector<std::byte>>();
+    framer(packet.data(), packet.size(), *buffer);
+    frames.push_back({level, threshold, buffer});
+    return buffer;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file sharedpacket.h
+ * @author Lygaen
+ * @brief The file containing the packets shared by many connections
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MINESERVER_SHAREDPACKET_H
+#define MINESERVER_SHAREDPACKET_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Immutable packet sent as is to many connections
+ *
+ * Holds a packet identical for every player (the status
+ * response for instance) and the frames built from it,
+ * built once per compression setting. Frames are refcounted
+ * immutable buffers, sockets send them without copying and
+ * queue them by reference when they can not take them right
+ * away, so that they outlive the packet if needed. Only the
+ * encryption, specific to each connection, is done again.
+ */
+class SharedPacket
+{
+public:
+    /**
+     * @brief Refcounted immutable buffer
+     *
+     */
+    typedef std::shared_ptr<const std::vector<std::byte>> Buffer;
+    /**
+     * @brief Builds a frame from the packet
+     *
+     * Called with the packet id and data, its length
+     * and the buffer to append the frame to.
+     */
+    typedef std::function<void(const std::byte *packet, std::size_t len, std::vector<std::byte> &out)> Framer;
+
+    /**
+     * @brief Level of the frames of uncompressed connections
+     *
+     * Connections that did not enable compression, unlike
+     * the level 0 ones that still send the data length.
+     */
+    static constexpr int UNCOMPRESSED = -2;
+
+private:
+    struct Frame
+    {
+        int level;
+        std::size_t threshold;
+        Buffer buffer;
+    };
+
+    std::vector<std::byte> packet;
+    mutable std::mutex lock;
+    mutable std::vector<Frame> frames;
+
+public:
+    /**
+     * @brief Construct a new Shared Packet object
+     *
+     * @param packet the packet id and data
+     */
+    explicit SharedPacket(std::vector<std::byte> packet);
+    /**
+     * @brief Destroy the Shared Packet object
+     *
+     */
+    ~SharedPacket() = default;
+
+    /**
+     * @brief Get the packet id and data
+     *
+     * @return const std::vector<std::byte>& the packet
+     */
+    const std::vector<std::byte> &getPacket() const
+    {
+        return packet;
+    }
+
+    /**
+     * @brief Gets the frame of the packet for a compression setting
+     *
+     * Built with @p framer the first time it is asked for,
+     * by any thread, then reused.
+     * @param level the compression level, SharedPacket::UNCOMPRESSED for none
+     * @param threshold the compression threshold, ignored when not compressed
+     * @param framer builds the frame if it is not built yet
+     * @return Buffer the frame, length included
+     */
+    Buffer getFrame(int level, std::size_t threshold, const Framer &framer) const;
+};
+
+#endif // MINESERVER_SHAREDPACKET_H
@@ -292,17 +292,19 @@ std::int32_t IMCStream::readVarInt()
 
 void IMCStream::writeVarInt(std::int32_t i)
 {
-    while (true)
-    {
-        if ((i & ~SEGMENT_BITS) == 0)
-        {
-            writeByte(i);
-            return;
-        }
+    std::byte buffer[varint::MAX_VARINT_SIZE];
+    write(buffer, 0, varint::encode(i, buffer));
+}
 
-        writeByte((i & SEGMENT_BITS) | CONTINUE_BIT);
+void IMCStream::writeVarInts(const std::int32_t *values, std::size_t count)
+{
+    constexpr std::size_t BATCH_SIZE = 64;
+    std::byte buffer[BATCH_SIZE * varint::MAX_VARINT_SIZE];
 
-        i >>= 7;
+    for (std::size_t i = 0; i < count; i += BATCH_SIZE)
+    {
+        std::size_t batch = count - i < BATCH_SIZE ? count - i : BATCH_SIZE;
+        write(buffer, 0, varint::encodeArray(values + i, batch, buffer));
     }
 }
 
@@ -331,18 +333,8 @@ std::int64_t IMCStream::readVarLong()
 
 void IMCStream::writeVarLong(std::int64_t l)
 {
-    while (true)
-    {
-        if ((l & ~((long)SEGMENT_BITS)) == 0)
-        {
-            writeByte(l);
-            return;
-        }
-
-        writeByte((l & SEGMENT_BITS) | CONTINUE_BIT);
-
-        l >>= 7;
-    }
+    std::byte buffer[varint::MAX_VARLONG_SIZE];
+    write(buffer, 0, varint::encode(l, buffer));
 }
 
 void IMCStream::writeUUID(const MinecraftUUID &uuid)
@@ -365,13 +357,17 @@ MinecraftUUID IMCStream::readUUID()
 #undef min
 void MemoryStream::read(std::byte *buffer, std::size_t offset, std::size_t len)
 {
-    std::memcpy(buffer + offset, data.data() + readIndex, std::min(len, data.size()));
-    readIndex += std::min(len, data.size());
+    // Packets received from the network are read from memory, never trust their lengths
+    if (len > available())
+        throw std::runtime_error("Not enough data in memory stream");
+
+    std::memcpy(buffer + offset, data.data() + readIndex, len);
+    readIndex += len;
 }
 
 void MemoryStream::write(const std::byte *buffer, std::size_t offset, std::size_t len)
 {
-    std::copy(buffer + offset, buffer + offset + len, std::back_inserter(data));
+    data.insert(data.end(), buffer + offset, buffer + offset + len);
 }
 
 void MemoryStream::flush()
@@ -396,12 +392,34 @@ void MemoryStream::clear()
     data.clear();
 }
 
+void MemoryStream::reserve(std::size_t capacity)
+{
+    data.reserve(capacity);
+}
+
+std::size_t MemoryStream::capacity() const
+{
+    return data.capacity();
+}
+
 const std::vector<std::byte> &MemoryStream::getData() const
 {
     return data;
 }
 
-NetSocketStream::NetSocketStream(const ClientSocket& socket) : socket(socket)
+/**
+ * @brief Minimum free space for a single socket read
+ *
+ */
+constexpr std::size_t RECEIVE_CHUNK_SIZE = 16384;
+
+NetSocketStream::NetSocketStream(const ClientSocket& socket) : socket(socket),
+                                                               inBuffer(),
+                                                               inStart(0),
+                                                               inEnd(0),
+                                                               outBuffer(),
+                                                               queue(),
+                                                               corked(false)
 {
 }
 
@@ -410,30 +428,165 @@ NetSocketStream::~NetSocketStream()
     socket.close();
 }
 
+void NetSocketStream::reserveReceive(std::size_t len)
+{
+    if (inBuffer.size() - inEnd >= len)
+        return;
+
+    if (inStart > 0)
+    {
+        std::memmove(inBuffer.data(), inBuffer.data() + inStart, inEnd - inStart);
+        inEnd -= inStart;
+        inStart = 0;
+    }
+
+    if (inBuffer.size() - inEnd < len)
+        inBuffer.resize(inEnd + len);
+}
+
 void NetSocketStream::read(std::byte *buffer, std::size_t offset, std::size_t len)
 {
-    socket.read(buffer + offset, len);
+    while (receivedSize() < len)
+    {
+        reserveReceive(std::max(RECEIVE_CHUNK_SIZE, len - receivedSize()));
+        inEnd += socket.read(inBuffer.data() + inEnd, inBuffer.size() - inEnd);
+    }
+
+    std::memcpy(buffer + offset, received(), len);
+    consume(len);
 }
 
 void NetSocketStream::write(const std::byte *buffer, std::size_t offset, std::size_t len)
 {
-    socket.write(buffer + offset, len);
+    OutboundQueue::countCopied(len);
+    outBuffer.insert(outBuffer.end(), buffer + offset, buffer + offset + len);
 }
 
 size_t NetSocketStream::available()
 {
-    return socket.getAvailableBytes();
+    return receivedSize() + socket.getAvailableBytes();
 }
 
 void NetSocketStream::finishPacketWrite(const std::byte *packetData, size_t len)
 {
-    writeVarInt(len);
-    write(packetData, 0, len);
+    std::byte header[5];
+    std::size_t headerSize = varint::encode(static_cast<std::int32_t>(len), header);
+
+    SocketBuffer buffers[] = {
+        {header, headerSize},
+        {packetData, len}};
+    send(buffers, 2);
 }
 
 void NetSocketStream::flush()
 {
-    /* Not implemented */
+    corked = false;
+    send(nullptr, 0);
+}
+
+void NetSocketStream::cork()
+{
+    corked = true;
+}
+
+std::size_t NetSocketStream::fill()
+{
+    std::size_t total = 0;
+
+    while (true)
+    {
+        reserveReceive(RECEIVE_CHUNK_SIZE);
+        std::size_t space = inBuffer.size() - inEnd;
+        auto read = static_cast<std::size_t>(socket.readAvailable(inBuffer.data() + inEnd, space));
+        inEnd += read;
+        total += read;
+
+        // Less than asked means the system has nothing more for now
+        if (read < space)
+            return total;
+    }
+}
+
+void NetSocketStream::consume(std::size_t len)
+{
+    inStart += std::min(len, receivedSize());
+    if (inStart == inEnd)
+        inStart = inEnd = 0;
+}
+
+void NetSocketStream::send(SocketBuffer *buffers, std::size_t count)
+{
+    // Pending written data goes first, in the same call
+    SocketBuffer gathered[ClientSocket::MAX_WRITE_BUFFERS];
+    if (!outBuffer.empty())
+    {
+        if (count + 1 > ClientSocket::MAX_WRITE_BUFFERS)
+            throw std::runtime_error("Too many buffers to send");
+
+        gathered[0] = {outBuffer.data(), outBuffer.size()};
+        std::copy(buffers, buffers + count, gathered + 1);
+        buffers = gathered;
+        count++;
+    }
+
+    // Queued data must go out before, keeping the order
+    if (!corked && queue.flush(socket))
+        writeAvailable(buffers, count);
+
+    queue.push(buffers, count);
+    outBuffer.clear();
+}
+
+void NetSocketStream::send(const SharedPacket::Buffer &buffer)
+{
+    OutboundQueue::countShared(buffer->size());
+
+    SocketBuffer gathered[2];
+    std::size_t count = 0;
+    if (!outBuffer.empty())
+        gathered[count++] = {outBuffer.data(), outBuffer.size()};
+    gathered[count++] = {buffer->data(), buffer->size()};
+
+    SocketBuffer *buffers = gathered;
+    if (!corked && queue.flush(socket))
+        writeAvailable(buffers, count);
+
+    // Only the pending written data is copied, the rest is referenced
+    if (count == 0)
+    {
+        outBuffer.clear();
+        return;
+    }
+    if (count == 2)
+        queue.push(buffers, 1);
+    queue.push(buffer, buffer->size() - buffers[count - 1].len);
+    outBuffer.clear();
+}
+
+void NetSocketStream::writeAvailable(SocketBuffer *&buffers, std::size_t &count)
+{
+    while (count > 0)
+    {
+        ssize_t written = socket.writeAvailable(buffers, count);
+        if (written < 0)
+            throw std::runtime_error("Invalid socket write !");
+        if (written == 0)
+            break;
+
+        // Short write, skips what was already sent
+        auto left = static_cast<std::size_t>(written);
+        while (count > 0 && left >= buffers->len)
+        {
+            left -= buffers->len;
+            buffers++;
+            count--;
+        }
+        if (count > 0)
+        {
+            buffers->data += left;
+            buffers->len -= left;
+        }
+    }
 }
 
 CipherStream::CipherStream(IMCStream *baseStream, std::byte *key, std::byte *iv) : baseStream(baseStream),
@@ -450,24 +603,16 @@ CipherStream::~CipherStream()
 
 void CipherStream::read(std::byte *buffer, std::size_t offset, std::size_t len)
 {
-    auto *buf = new std::byte[len];
-    baseStream->read(buf, 0, len);
-
-    auto *outBuf = new std::byte[decipher.calculateBufferSize(len)];
-    int outLen = decipher.update(buf, len, outBuf);
-    delete[] buf;
-
-    std::memcpy(buffer + offset, outBuf, outLen);
-    delete[] outBuf;
+    baseStream->read(buffer, offset, len);
+    decipher.update(buffer + offset, len);
 }
 
 void CipherStream::write(const std::byte *buffer, std::size_t offset, std::size_t len)
 {
-    auto *outBuf = new std::byte[encipher.calculateBufferSize(len)];
-    int outLen = encipher.update(buffer + offset, len, outBuf);
+    scratch.assign(buffer + offset, buffer + offset + len);
+    encipher.update(scratch.data(), len);
 
-    baseStream->write(outBuf, 0, outLen);
-    delete[] outBuf;
+    baseStream->write(scratch.data(), 0, len);
 }
 
 size_t CipherStream::available()
@@ -477,8 +622,16 @@ size_t CipherStream::available()
 
 void CipherStream::finishPacketWrite(const std::byte *packetData, size_t len)
 {
-    writeVarInt(len);
-    write(packetData, 0, len);
+    std::byte header[varint::MAX_VARINT_SIZE];
+    std::size_t headerLen = varint::encode(static_cast<std::int32_t>(len), header);
+
+    scratch.resize(headerLen + len);
+    std::memcpy(scratch.data(), header, headerLen);
+    std::memcpy(scratch.data() + headerLen, packetData, len);
+    encipher.update(scratch.data(), scratch.size());
+
+    baseStream->write(scratch.data(), 0, scratch.size());
+    baseStream->flush();
 }
 
 void CipherStream::flush()
@@ -511,19 +664,6 @@ size_t ZLibStream::available()
     return baseStream->available();
 }
 
-/**
- * @brief Calculates the size of an int in VarInt format
- *
- * @param i the int to calculates its size
- * @return size_t the size of @p i in VarInt format
- */
-size_t calculateVarIntSize(int i)
-{
-    MemoryStream m;
-    m.writeVarInt(i);
-    return m.getData().size();
-}
-
 #include <utils/logger.h>
 
 void ZLibStream::finishPacketWrite(const std::byte *packetData, size_t len)
@@ -531,18 +671,20 @@ void ZLibStream::finishPacketWrite(const std::byte *packetData, size_t len)
     if (len < threshold)
     {
         // No compression, data length = 0
-        baseStream->writeVarInt(len + calculateVarIntSize(0));
+        baseStream->writeVarInt(len + varint::size(0));
         baseStream->writeVarInt(0);
         baseStream->write(packetData, 0, len);
+        baseStream->flush();
         return;
     }
 
-    std::byte *compBytes = new std::byte[2 * len];
-    int packetLength = comp.compress(packetData, len, compBytes, 2 * len);
+    compressed.resize(comp.compressBound(len));
+    int packetLength = comp.compress(packetData, len, compressed.data(), compressed.size());
 
-    baseStream->writeVarInt(packetLength + calculateVarIntSize(len));
+    baseStream->writeVarInt(packetLength + varint::size(static_cast<std::int32_t>(len)));
     baseStream->writeVarInt(len);
-    baseStream->write(compBytes, 0, packetLength);
+    baseStream->write(compressed.data(), 0, packetLength);
+    baseStream->flush();
 }
 
 void ZLibStream::flush()
@@ -553,37 +695,51 @@ void ZLibStream::flush()
     inIndex = 0;
 
     int packetLength = baseStream->readVarInt();
-    int dataLength = baseStream->readVarInt();
+    std::vector<std::byte> frame(packetLength);
+    baseStream->read(frame.data(), 0, packetLength);
+
+    std::vector<std::byte> scratch;
+    std::span<const std::byte> packet = decodeCompressedFrame(comp, threshold, frame.data(), frame.size(), scratch);
+
+    // We write back the length to the stream
+    MemoryStream m;
+    m.writeVarInt(packet.size());
+    std::ranges::copy(m.getData(), std::back_inserter(inBuffer));
+    std::ranges::copy(packet, std::back_inserter(inBuffer));
+}
+
+/**
+ * @brief Max uncompressed length of a received packet
+ *
+ * Same limit as notchian servers, prevents
+ * small frames from inflating to huge buffers.
+ */
+constexpr std::int32_t MAX_UNCOMPRESSED_LENGTH = 8388608;
+
+std::span<const std::byte> decodeCompressedFrame(crypto::ZLibCompressor &comp, int threshold,
+                                                 const std::byte *frame, std::size_t len,
+                                                 std::vector<std::byte> &scratch)
+{
+    std::int32_t dataLength;
+    std::size_t headerSize = varint::decode(frame, len, dataLength);
+    if (headerSize == 0 || dataLength < 0 || dataLength > MAX_UNCOMPRESSED_LENGTH)
+        throw std::runtime_error("Invalid received data length");
+
+    frame += headerSize;
+    len -= headerSize;
 
     if (dataLength == 0)
     {
-        int len = packetLength - calculateVarIntSize(0);
-
-        if (len >= threshold)
+        if (len >= static_cast<std::size_t>(threshold))
             throw std::runtime_error("Invalid received compression size");
-        std::byte *bytes = new std::byte[len];
-        baseStream->read(bytes, 0, len);
 
-        // We write back the length to the stream
-        MemoryStream m;
-        m.writeVarInt(dataLength);
-        std::copy(m.getData().begin(), m.getData().end(), std::back_inserter(inBuffer));
-
-        std::copy(bytes, bytes + len, std::back_inserter(inBuffer));
-        return;
+        return {frame, len};
     }
-    int len = packetLength - calculateVarIntSize(dataLength);
-    std::byte *compressed = new std::byte[len];
-    baseStream->read(compressed, 0, len);
 
-    std::byte *final = new std::byte[dataLength];
-    int written = comp.uncompress(compressed, len, final, dataLength);
+    scratch.resize(dataLength);
+    int written = comp.uncompress(frame, len, scratch.data(), dataLength);
     if (written != dataLength)
         throw std::runtime_error("Invalid uncompressed length");
 
-    // We write back the length to the stream
-    MemoryStream m;
-    m.writeVarInt(dataLength);
-    std::ranges::copy(m.getData(), std::back_inserter(inBuffer));
-    inBuffer.insert(inBuffer.end(), final, final + dataLength);
+    return {scratch.data(), scratch.size()};
 }
@@ -14,12 +14,15 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <span>
 #include <string>
 #include <vector>
 #include <utils/network.h>
 #include <types/chatmessage.h>
 #include <types/uuid.h>
 #include <utils/crypto.h>
+#include <net/varint.hpp>
+#include <net/outbound.h>
 
 /**
  * @brief Stream interface
@@ -75,6 +78,17 @@ public:
      * @param len the length of the data
      */
     virtual void finishPacketWrite(const std::byte *packetData, size_t len) = 0;
+    /**
+     * @brief Writes a packet shared by many connections
+     *
+     * Same as IMCStream::finishPacketWrite() with the packet,
+     * streams that can send its frames as is override it.
+     * @param packet the shared packet
+     */
+    virtual void writeShared(const SharedPacket &packet)
+    {
+        finishPacketWrite(packet.getPacket().data(), packet.getPacket().size());
+    }
 
     /**
      * @brief Reads a Boolean
@@ -245,6 +259,15 @@ public:
      * @param i the variable integer to write
      */
     void writeVarInt(std::int32_t i);
+    /**
+     * @brief Writes consecutive Variable Integers
+     *
+     * Same as IMCStream::writeVarInt() for each value,
+     * encoding them in batches.
+     * @param values the variable integers to write
+     * @param count the number of variable integers
+     */
+    void writeVarInts(const std::int32_t *values, std::size_t count);
 
     /**
      * @brief Reads a Variable Long
@@ -279,6 +302,24 @@ public:
     void writeUUID(const MinecraftUUID &uuid);
 };
 
+/**
+ * @brief Decodes a received compressed frame
+ *
+ * Reads a whole received frame, starting right after
+ * the packet length, and gives back the uncompressed
+ * packet id and data. Packets that were sent uncompressed
+ * are not copied and point into @p frame.
+ * @param comp the compressor to uncompress with
+ * @param threshold the compression threshold of the connection
+ * @param frame the frame data, starting at the data length
+ * @param len the length of @p frame
+ * @param scratch the buffer to uncompress into if needed
+ * @return std::span<const std::byte> the packet id and data
+ */
+std::span<const std::byte> decodeCompressedFrame(crypto::ZLibCompressor &comp, int threshold,
+                                                 const std::byte *frame, std::size_t len,
+                                                 std::vector<std::byte> &scratch);
+
 /**
  * @brief A stream from Memory
  *
@@ -350,6 +391,18 @@ public:
      * Cleares the stream of any data.
      */
     void clear();
+    /**
+     * @brief Reserves memory for the stream
+     *
+     * @param capacity the number of bytes to reserve
+     */
+    void reserve(std::size_t capacity);
+    /**
+     * @brief Get the capacity of the stream
+     *
+     * @return std::size_t the number of bytes that can be written without allocating
+     */
+    std::size_t capacity() const;
     /**
      * @brief Get the written data
      *
@@ -362,12 +415,41 @@ public:
 /**
  * @brief Stream from a net client socket
  *
- * Stream for IO on a Network client socket
+ * Stream for IO on a Network client socket.
+ * Received data goes through a receive buffer
+ * filled with large reads, written data is kept
+ * in memory until NetSocketStream::flush() or
+ * the end of a packet, then sent in a single call.
+ * Sending never waits : what the socket can not take
+ * right away goes to an OutboundQueue, sent on the next
+ * NetSocketStream::flush().
  */
 class NetSocketStream : public IMCStream
 {
 private:
     ClientSocket socket;
+    std::vector<std::byte> inBuffer;
+    std::size_t inStart;
+    std::size_t inEnd;
+    std::vector<std::byte> outBuffer;
+    OutboundQueue queue;
+    bool corked;
+
+    /**
+     * @brief Makes room at the end of the receive buffer
+     *
+     * Moves the pending data back to the start of the
+     * buffer, growing it if there is still not enough room.
+     * @param len the minimum free space needed
+     */
+    void reserveReceive(std::size_t len);
+    /**
+     * @brief Writes what the socket takes right away
+     *
+     * @param buffers the buffers to write, advanced past what was written
+     * @param count the number of buffers, decreased by the ones fully written
+     */
+    void writeAvailable(SocketBuffer *&buffers, std::size_t &count);
 
 public:
     /**
@@ -385,8 +467,9 @@ public:
     /**
      * @brief Reads from the network socket
      *
-     * Reads from the network socket, writing it
-     * to @p buffer
+     * Reads from the receive buffer, waiting
+     * for the network socket to fill it if needed
+     * and writing it to @p buffer
      * @param buffer the buffer to write to
      * @param offset the offset to start writing at
      * @param len the maximum length to write
@@ -395,7 +478,8 @@ public:
     /**
      * @brief Writes to the network socket
      *
-     * Writes to the network socket
+     * Writes to the send buffer, only sent
+     * on the next NetSocketStream::flush()
      * @param buffer the buffer to read from
      * @param offset the offset to start reading from
      * @param len the maximum read length
@@ -411,6 +495,8 @@ public:
     /**
      * @brief Finishes to write the packet in a Minecrafty way
      *
+     * Sends the pending data, the packet length and
+     * @p packetData in a single call.
      * @param packetData the packet data
      * @param len the length of the packet data
      */
@@ -418,9 +504,84 @@ public:
 
     /**
      * @brief Flushes the stream
-     * @deprecated Not implemented, useless, should not be used
+     *
+     * Sends the pending written data and the queued
+     * data, as much as the socket takes right away.
+     * Also ends NetSocketStream::cork().
      */
     void flush() override;
+
+    /**
+     * @brief Sends buffers
+     *
+     * Sends the pending written data, then all of
+     * the buffers in as few calls as possible, queuing
+     * what the socket can not take right away.
+     * @param buffers the buffers to send, modified while sending
+     * @param count the number of buffers
+     */
+    void send(SocketBuffer *buffers, std::size_t count);
+    /**
+     * @brief Sends a shared buffer
+     *
+     * Same as NetSocketStream::send(SocketBuffer *, std::size_t)
+     * but what the socket can not take right away is queued
+     * by reference instead of being copied.
+     * @param buffer the buffer to send
+     */
+    void send(const SharedPacket::Buffer &buffer);
+    /**
+     * @brief Holds back sent data until the next flush
+     *
+     * Everything sent until NetSocketStream::flush()
+     * is queued, to be sent with as few calls as possible.
+     */
+    void cork();
+
+    /**
+     * @brief Get the outbound queue
+     *
+     * @return OutboundQueue& the queue
+     */
+    OutboundQueue &getQueue()
+    {
+        return queue;
+    }
+
+    /**
+     * @brief Fills the receive buffer
+     *
+     * Reads everything the system already received,
+     * without waiting for more.
+     * @return std::size_t the number of bytes added to the receive buffer
+     */
+    std::size_t fill();
+    /**
+     * @brief Get the received data that was not read yet
+     *
+     * Pointer is only valid until the next
+     * read or NetSocketStream::fill()
+     * @return std::byte* the received data
+     */
+    std::byte *received()
+    {
+        return inBuffer.data() + inStart;
+    }
+    /**
+     * @brief Get the number of received bytes that were not read yet
+     *
+     * @return std::size_t the number of bytes
+     */
+    std::size_t receivedSize() const
+    {
+        return inEnd - inStart;
+    }
+    /**
+     * @brief Marks received data as read
+     *
+     * @param len the number of bytes to skip
+     */
+    void consume(std::size_t len);
 };
 
 /**
@@ -435,6 +596,7 @@ private:
     IMCStream *baseStream;
     crypto::AES128CFB8Cipher encipher;
     crypto::AES128CFB8Cipher decipher;
+    std::vector<std::byte> scratch;
 
 public:
     /**
@@ -454,6 +616,7 @@ public:
     /**
      * @brief Reads from an encrypted stream
      *
+     * Decrypts in place in @p buffer.
      * @param buffer the buffer to write to
      * @param offset the offset to start writing to
      * @param len the length to read from baseStream and write to @p buffer
@@ -462,6 +625,7 @@ public:
     /**
      * @brief Writes to an encrypted stream
      *
+     * Encrypts in a scratch buffer kept between writes.
      * @param buffer the buffer to read from
      * @param offset the offset to start reading from
      * @param len the length to read from @p buffer
@@ -481,6 +645,8 @@ public:
     /**
      * @brief Finishes to write the packet in a Minecrafty way
      *
+     * The whole frame, length included, is encrypted
+     * at once and written in a single call.
      * @param packetData the packet data
      * @param len the length of the packet data
      */
@@ -510,6 +676,7 @@ private:
     std::uint32_t inIndex{};
 
     std::vector<std::byte> outBuffer{};
+    std::vector<std::byte> compressed{};
     int threshold;
 
 public:
@@ -0,0 +1,378 @@
+/**
+ * @file varint.hpp
+ * @author Lygaen
+ * @brief The file containing the VarInt and VarLong codec
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MINESERVER_VARINT_H
+#define MINESERVER_VARINT_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * @brief VarInt and VarLong codec
+ *
+ * Encodes and decodes the variable length integers
+ * of the Minecraft protocol straight from memory.
+ * When enough bytes are available, values are read
+ * and written with a single 8 bytes load or store,
+ * without looping over every byte.
+ *
+ * Values are encoded as their unsigned two's complement,
+ * negative values always use the maximum size.
+ */
+namespace varint
+{
+    /**
+     * @brief Max size of a VarInt
+     *
+     */
+    constexpr std::size_t MAX_VARINT_SIZE = 5;
+    /**
+     * @brief Max size of a VarLong
+     *
+     */
+    constexpr std::size_t MAX_VARLONG_SIZE = 10;
+
+    /**
+     * @brief Calculates the size of a VarInt
+     *
+     * @param value the value
+     * @return constexpr std::size_t the number of bytes @p value is encoded to
+     */
+    constexpr std::size_t size(std::int32_t value)
+    {
+        // 7 bits per byte, zero still takes one byte
+        return (std::bit_width(static_cast<std::uint32_t>(value) | 1u) + 6) / 7;
+    }
+    /**
+     * @brief Calculates the size of a VarLong
+     *
+     * @param value the value
+     * @return constexpr std::size_t the number of bytes @p value is encoded to
+     */
+    constexpr std::size_t size(std::int64_t value)
+    {
+        return (std::bit_width(static_cast<std::uint64_t>(value) | 1u) + 6) / 7;
+    }
+
+    /**
+     * @brief Reverses the bytes of an integer
+     *
+     * @param word the integer
+     * @return constexpr std::uint64_t the integer with its bytes reversed
+     */
+    constexpr std::uint64_t byteswap(std::uint64_t word)
+    {
+        word = ((word & 0x00FF00FF00FF00FFull) << 8) | ((word >> 8) & 0x00FF00FF00FF00FFull);
+        word = ((word & 0x0000FFFF0000FFFFull) << 16) | ((word >> 16) & 0x0000FFFF0000FFFFull);
+        return (word << 32) | (word >> 32);
+    }
+
+    /**
+     * @brief Loads 8 bytes as a little-endian integer
+     *
+     * @param data the bytes to load
+     * @return std::uint64_t the loaded integer
+     */
+    inline std::uint64_t load64(const std::byte *data)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        if constexpr (std::endian::native == std::endian::big)
+            word = byteswap(word);
+        return word;
+    }
+
+    /**
+     * @brief Spreads 7 bits groups to 8 bits bytes, setting continue bits
+     *
+     * @tparam GROUPS the number of groups to spread, at most 8
+     * @param bits the value
+     * @param len the encoded size of @p bits, at most @p GROUPS
+     * @return std::uint64_t the encoded bytes, in little-endian order
+     */
+    template <int GROUPS>
+    inline std::uint64_t spread(std::uint64_t bits, std::size_t len)
+    {
+        std::uint64_t word = 0;
+        for (int i = 0; i < GROUPS; i++)
+            word |= (bits << i) & (0x7Full << (8 * i));
+
+        // Continue bit on every byte but the last one
+        std::uint64_t continueBits = 0x8080808080808080ull & ((1ull << ((len - 1) * 8)) - 1);
+        return word | continueBits;
+    }
+
+    /**
+     * @brief Gathers 8 bits bytes to 7 bits groups
+     *
+     * @tparam GROUPS the number of groups to gather, at most 8
+     * @param word the encoded bytes, in little-endian order
+     * @return std::uint64_t the value
+     */
+    template <int GROUPS>
+    inline std::uint64_t gather(std::uint64_t word)
+    {
+        std::uint64_t bits = 0;
+        for (int i = 0; i < GROUPS; i++)
+            bits |= (word >> i) & (0x7Full << (7 * i));
+        return bits;
+    }
+
+    /**
+     * @brief Stores a little-endian integer
+     *
+     * @param word the integer to store
+     * @param out the buffer to store to, at least 8 bytes long
+     */
+    inline void store64(std::uint64_t word, std::byte *out)
+    {
+        if constexpr (std::endian::native == std::endian::big)
+            word = byteswap(word);
+        std::memcpy(out, &word, sizeof(word));
+    }
+
+    /**
+     * @brief Encodes a VarInt
+     *
+     * May write up to varint::MAX_VARINT_SIZE bytes,
+     * the bytes past the returned size are garbage.
+     * @param value the value to encode
+     * @param out the buffer to encode to, at least varint::MAX_VARINT_SIZE bytes long
+     * @return std::size_t the number of bytes of the VarInt
+     */
+    inline std::size_t encode(std::int32_t value, std::byte *out)
+    {
+        // Ids and lengths mostly fit in a single byte
+        if ((static_cast<std::uint32_t>(value) & ~0x7Fu) == 0)
+        {
+            out[0] = static_cast<std::byte>(value);
+            return 1;
+        }
+
+        std::size_t len = size(value);
+        std::uint64_t word = spread<MAX_VARINT_SIZE>(static_cast<std::uint32_t>(value), len);
+
+        std::uint32_t low = static_cast<std::uint32_t>(word);
+        if constexpr (std::endian::native == std::endian::big)
+            low = static_cast<std::uint32_t>(byteswap(low) >> 32);
+        std::memcpy(out, &low, sizeof(low));
+        out[4] = static_cast<std::byte>(word >> 32);
+        return len;
+    }
+    /**
+     * @brief Encodes a VarLong
+     *
+     * May write up to varint::MAX_VARLONG_SIZE bytes,
+     * the bytes past the returned size are garbage.
+     * @param value the value to encode
+     * @param out the buffer to encode to, at least varint::MAX_VARLONG_SIZE bytes long
+     * @return std::size_t the number of bytes of the VarLong
+     */
+    inline std::size_t encode(std::int64_t value, std::byte *out)
+    {
+        if ((static_cast<std::uint64_t>(value) & ~0x7Full) == 0)
+        {
+            out[0] = static_cast<std::byte>(value);
+            return 1;
+        }
+
+        auto bits = static_cast<std::uint64_t>(value);
+        std::size_t len = size(value);
+
+        // Last 8 bits don't fit in a single word
+        std::uint64_t continueBit = len > 8 ? 0x8000000000000000ull : 0;
+        store64(spread<8>(bits, len > 8 ? 8 : len) | continueBit, out);
+        out[8] = static_cast<std::byte>(((bits >> 56) & 0x7F) | (len == 10 ? 0x80 : 0));
+        out[9] = static_cast<std::byte>(bits >> 63);
+        return len;
+    }
+
+    /**
+     * @brief Decodes variable length integer, one byte at a time
+     *
+     * @tparam T the unsigned type of the integer
+     * @tparam MAX_SIZE the max size of the integer
+     * @param data the buffer to decode from
+     * @param len the length of @p data
+     * @param value the decoded value
+     * @return std::size_t the number of bytes read, 0 if @p data does not hold a whole integer
+     */
+    template <typename T, std::size_t MAX_SIZE>
+    std::size_t decodeSlow(const std::byte *data, std::size_t len, T &value)
+    {
+        value = 0;
+        for (std::size_t i = 0; i < len; i++)
+        {
+            if (i == MAX_SIZE)
+                throw std::runtime_error("VarInt is too big !");
+
+            auto currentByte = static_cast<std::uint8_t>(data[i]);
+            value |= static_cast<T>(currentByte & 0x7F) << (7 * i);
+
+            if ((currentByte & 0x80) == 0)
+                return i + 1;
+        }
+
+        if (len >= MAX_SIZE)
+            throw std::runtime_error("VarInt is too big !");
+        return 0;
+    }
+
+    /**
+     * @brief Decodes a VarInt
+     *
+     * @param data the buffer to decode from
+     * @param len the length of @p data
+     * @param value the decoded value
+     * @return std::size_t the number of bytes read, 0 if @p data does not hold a whole VarInt
+     */
+    inline std::size_t decode(const std::byte *data, std::size_t len, std::int32_t &value)
+    {
+        // Ids and lengths mostly fit in a single byte
+        if (len > 0 && (static_cast<std::uint8_t>(data[0]) & 0x80) == 0)
+        {
+            value = static_cast<std::int32_t>(data[0]);
+            return 1;
+        }
+
+        if (len < 8)
+        {
+            std::uint32_t bits;
+            std::size_t read = decodeSlow<std::uint32_t, MAX_VARINT_SIZE>(data, len, bits);
+            value = static_cast<std::int32_t>(bits);
+            return read;
+        }
+
+        // The first byte without continue bit ends the VarInt
+        std::uint64_t word = load64(data);
+        std::uint64_t ends = ~word & 0x8080808080808080ull;
+        std::size_t read = (std::countr_zero(ends) >> 3) + 1;
+        if (read > MAX_VARINT_SIZE)
+            throw std::runtime_error("VarInt is too big !");
+
+        value = static_cast<std::int32_t>(static_cast<std::uint32_t>(gather<MAX_VARINT_SIZE>(word)));
+        // Only keep the bytes of this VarInt
+        value &= static_cast<std::int32_t>(read >= MAX_VARINT_SIZE ? ~0u : (1u << (7 * read)) - 1);
+        return read;
+    }
+    /**
+     * @brief Decodes a VarLong
+     *
+     * @param data the buffer to decode from
+     * @param len the length of @p data
+     * @param value the decoded value
+     * @return std::size_t the number of bytes read, 0 if @p data does not hold a whole VarLong
+     */
+    inline std::size_t decode(const std::byte *data, std::size_t len, std::int64_t &value)
+    {
+        if (len > 0 && (static_cast<std::uint8_t>(data[0]) & 0x80) == 0)
+        {
+            value = static_cast<std::int64_t>(data[0]);
+            return 1;
+        }
+
+        std::uint64_t word = len >= 8 ? load64(data) : 0;
+        std::uint64_t ends = ~word & 0x8080808080808080ull;
+        if (len < 8 || ends == 0)
+        {
+            std::uint64_t bits;
+            std::size_t read = decodeSlow<std::uint64_t, MAX_VARLONG_SIZE>(data, len, bits);
+            value = static_cast<std::int64_t>(bits);
+            return read;
+        }
+
+        std::size_t read = (std::countr_zero(ends) >> 3) + 1;
+        std::uint64_t bits = gather<8>(word);
+        if (read < 8)
+            bits &= (1ull << (7 * read)) - 1;
+        value = static_cast<std::int64_t>(bits);
+        return read;
+    }
+
+    /**
+     * @brief Encodes an array of VarInts
+     *
+     * @param values the values to encode
+     * @param count the number of values
+     * @param out the buffer to encode to, at least @p count * varint::MAX_VARINT_SIZE bytes long
+     * @return std::size_t the number of bytes written
+     */
+    inline std::size_t encodeArray(const std::int32_t *values, std::size_t count, std::byte *out)
+    {
+        std::size_t written = 0;
+        for (std::size_t i = 0; i < count; i++)
+            written += encode(values[i], out + written);
+        return written;
+    }
+    /**
+     * @brief Encodes an array of VarLongs
+     *
+     * @param values the values to encode
+     * @param count the number of values
+     * @param out the buffer to encode to, at least @p count * varint::MAX_VARLONG_SIZE bytes long
+     * @return std::size_t the number of bytes written
+     */
+    inline std::size_t encodeArray(const std::int64_t *values, std::size_t count, std::byte *out)
+    {
+        std::size_t written = 0;
+        for (std::size_t i = 0; i < count; i++)
+            written += encode(values[i], out + written);
+        return written;
+    }
+
+    /**
+     * @brief Decodes an array of VarInts
+     *
+     * @param data the buffer to decode from
+     * @param len the length of @p data
+     * @param values the decoded values
+     * @param count the number of values to decode
+     * @return std::size_t the number of bytes read, 0 if @p data does not hold all the VarInts
+     */
+    inline std::size_t decodeArray(const std::byte *data, std::size_t len, std::int32_t *values, std::size_t count)
+    {
+        std::size_t read = 0;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            std::size_t size = decode(data + read, len - read, values[i]);
+            if (size == 0)
+                return 0;
+            read += size;
+        }
+        return read;
+    }
+    /**
+     * @brief Decodes an array of VarLongs
+     *
+     * @param data the buffer to decode from
+     * @param len the length of @p data
+     * @param values the decoded values
+     * @param count the number of values to decode
+     * @return std::size_t the number of bytes read, 0 if @p data does not hold all the VarLongs
+     */
+    inline std::size_t decodeArray(const std::byte *data, std::size_t len, std::int64_t *values, std::size_t count)
+    {
+        std::size_t read = 0;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            std::size_t size = decode(data + read, len - read, values[i]);
+            if (size == 0)
+                return 0;
+            read += size;
+        }
+        return read;
+    }
+}
+
+#endif // MINESERVER_VARINT_H
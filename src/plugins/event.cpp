@@ -10,13 +10,115 @@
  */
 
 #include "event.h"
+#include <algorithm>
 
 EventsManager *EventsManager::INSTANCE;
-EventsManager::EventsManager()
+std::atomic<std::size_t> EventsManager::nextSlot = 0;
+EventsManager::EventsManager() : handlers(),
+                                 lock(),
+                                 async(false),
+                                 asyncThread(),
+                                 queueLock(),
+                                 queueCond(),
+                                 queue(),
+                                 queued(),
+                                 peakDepth(0),
+                                 delivered(0),
+                                 coalesced(0),
+                                 overflows(0)
 {
     INSTANCE = this;
 }
 
+void EventsManager::startAsync()
+{
+    std::lock_guard<std::mutex> guard(queueLock);
+    if (async)
+        return;
+
+    async = true;
+    asyncThread = std::thread(&EventsManager::deliverLoop, this);
+}
+
+void EventsManager::stopAsync()
+{
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        if (!async)
+            return;
+
+        async = false;
+    }
+
+    queueCond.notify_one();
+    asyncThread.join();
+}
+
+bool EventsManager::defer(std::size_t slot, bool merge, std::function<void()> &&deliver)
+{
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        if (!async)
+            return false;
+
+        if (merge && queued[slot])
+        {
+            coalesced++;
+            return true;
+        }
+
+        if (queue.size() >= MAX_DEFERRED)
+        {
+            overflows++;
+            return false;
+        }
+
+        queued[slot] = merge;
+        queue.push_back(std::move(deliver));
+        peakDepth = std::max(peakDepth, queue.size());
+    }
+
+    queueCond.notify_one();
+    return true;
+}
+
+void EventsManager::deliverLoop()
+{
+    std::deque<std::function<void()>> batch;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> guard(queueLock);
+            queueCond.wait(guard, [this]()
+                           { return !queue.empty() || !async; });
+
+            // Stopped, but only once everything was delivered
+            if (queue.empty())
+                return;
+
+            batch.swap(queue);
+            queued.fill(false);
+        }
+
+        for (auto &deliver : batch)
+            deliver();
+        delivered += batch.size();
+        batch.clear();
+    }
+}
+
+std::size_t EventsManager::getQueueDepth()
+{
+    std::lock_guard<std::mutex> guard(queueLock);
+    return queue.size();
+}
+
+std::size_t EventsManager::getPeakDepth()
+{
+    std::lock_guard<std::mutex> guard(queueLock);
+    return peakDepth;
+}
+
 EventsManager *EventsManager::inst()
 {
     return INSTANCE;
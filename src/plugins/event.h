@@ -12,21 +12,57 @@
 #ifndef MINESERVER_EVENT_HPP
 #define MINESERVER_EVENT_HPP
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
 #include <type_traits>
+#include <typeinfo>
+#include <vector>
 #include <plugins/luaheaders.h>
+#include <plugins/executor.h>
 
 /**
  * @brief Event interface
  *
  * All events should implement this event interface.
  * Code will not compile otherwise.
+ *
+ * Plugins handle copies of the events, copied back once
+ * they are done. Events pointing to data of the firer
+ * must copy it when copied, and write it back when
+ * assigned (see ClientStatusEvent).
  * @tparam T the event class, used for automatic lua class loading
  */
 template<class T>
 class IEvent
 {
 public:
+    /**
+     * @brief Whether the event can be delivered later
+     *
+     * Deferrable events are copied and delivered on the
+     * events thread once asynchronous delivery is started,
+     * so the firer never sees changes made by listeners.
+     * Events hide it to opt in, only for notifications.
+     */
+    static constexpr bool DEFERRABLE = false;
+    /**
+     * @brief Whether identical deferred events are merged
+     *
+     * An event fired while another one of its type is still
+     * queued is dropped, for events that carry nothing.
+     */
+    static constexpr bool COALESCED = false;
+
     /**
      * @brief Loads the event to the lua state
      *
@@ -74,14 +110,42 @@ constexpr std::string_view type_name()
     return name;
 }
 
+/**
+ * @brief Type-erased handler of events
+ *
+ * Base of every #EventHandler, so that handlers of
+ * different events can be stored and destroyed together.
+ */
+class IEventHandler
+{
+public:
+    virtual ~IEventHandler() = default;
+
+    /**
+     * @brief Get the Type Info of the handled event
+     *
+     * @return const std::type_info* the type info of the event
+     */
+    virtual const std::type_info *getTypeInfo() const = 0;
+};
+
 /**
  * @brief Handler for a type of event
  *
- * @todo Make it thread-safe
+ * Subscribers are published as immutable snapshots : firing
+ * takes a reference to the current snapshot, while subscribing
+ * and unsubscribing copy it, change the copy and swap it in. A
+ * fire running during an unsubscribe may still call the removed
+ * subscriber one last time.
+ *
+ * Firing is not lock-free : std::atomic<std::shared_ptr> is
+ * guarded by an internal lock (a spinlock in libstdc++), but it
+ * is only held to copy or swap the pointer, never while copying
+ * the subscribers or calling them.
  * @tparam T the event that should extend IEvent
  */
 template <class T>
-class EventHandler
+class EventHandler : public IEventHandler
 {
 public:
     /**
@@ -105,15 +169,18 @@ private:
         callbackType callback;
         subId id;
     };
+    // Subscriptions are shared between snapshots, callbacks are never copied
+    typedef std::vector<std::shared_ptr<const subscription>> snapshot;
 
-    std::vector<subscription> subs;
+    std::atomic<std::shared_ptr<const snapshot>> subs;
+    std::mutex writeLock;
     subId nextId = 0;
-    const std::type_info *typeInfo;
 
     /**
      * @brief Get the next Id
      *
-     * Utility for generating ids for subscription system
+     * Utility for generating ids for subscription system,
+     * called with the write lock held
      * @return subId the unique id
      */
     subId getNextId()
@@ -121,6 +188,26 @@ private:
         return ++nextId;
     }
 
+    /**
+     * @brief Publishes a new subscriber
+     *
+     * @param callback the function that will listen to events
+     * @return subId the id to use for #unsubscribe
+     */
+    subId add(callbackType &&callback)
+    {
+        std::lock_guard<std::mutex> guard(writeLock);
+        auto s = std::make_shared<subscription>();
+        s->callback = std::move(callback);
+        s->id = getNextId();
+
+        auto next = std::make_shared<snapshot>(*subs.load(std::memory_order_acquire));
+        next->push_back(std::move(s));
+        subId id = next->back()->id;
+        subs.store(std::move(next), std::memory_order_release);
+        return id;
+    }
+
 public:
     /**
      * @brief Construct a new Event Handler object
@@ -128,26 +215,29 @@ public:
      * It will not compile if you try it with a
      * class that does not derive from #IEvent
      */
-    EventHandler() : subs()
+    EventHandler() : subs(std::make_shared<const snapshot>()),
+                     writeLock()
     {
         static_assert(std::is_base_of_v<IEvent<T>, T>, "Class doesn't derive from IEvent");
-        typeInfo = &typeid(T);
     }
 
-    ~EventHandler() = default;
+    ~EventHandler() override = default;
 
     /**
      * @brief Fire an event
      *
      * Cascade the event to all of the listeners
+     * subscribed when it is fired. Safe to call from
+     * any thread, even while subscribing.
      * @param event the event
      */
     void fire(T &event)
     {
-        for (auto &sub : subs)
+        std::shared_ptr<const snapshot> current = subs.load(std::memory_order_acquire);
+        for (auto &sub : *current)
         {
             try {
-                sub.callback(event);
+                sub->callback(event);
             }
             catch (const std::exception &e)
             {
@@ -165,11 +255,7 @@ public:
      */
     subId subscribe(const callbackType &func)
     {
-        subscription s;
-        s.callback = static_cast<callbackType>(func);
-        s.id = getNextId();
-        subs.push_back(s);
-        return s.id;
+        return add(static_cast<callbackType>(func));
     }
 
     /**
@@ -181,11 +267,7 @@ public:
      */
     subId subscribe(callbackType &&func)
     {
-        subscription s;
-        s.callback = std::move(func);
-        s.id = getNextId();
-        subs.push_back(s);
-        return s.id;
+        return add(std::move(func));
     }
 
     /**
@@ -196,15 +278,21 @@ public:
      */
     void unsubscribe(subId id)
     {
-        subs.erase(
-            std::remove_if(
-                subs.begin(),
-                subs.end(),
-                [id](subscription el) -> bool
-                {
-                    return el.id == id;
-                }),
-            subs.end());
+        std::lock_guard<std::mutex> guard(writeLock);
+        auto next = std::make_shared<snapshot>(*subs.load(std::memory_order_acquire));
+        auto loc = std::remove_if(
+            next->begin(),
+            next->end(),
+            [id](const std::shared_ptr<const subscription> &el) -> bool
+            {
+                return el->id == id;
+            });
+
+        if (loc == next->end())
+            return;
+
+        next->erase(loc, next->end());
+        subs.store(std::move(next), std::memory_order_release);
     }
 
     /**
@@ -213,40 +301,111 @@ public:
      * Returns the type info of T
      * @return const std::type_info* the type info of T
      */
-    const std::type_info *getTypeInfo() const { return typeInfo; }
+    const std::type_info *getTypeInfo() const override { return &typeid(T); }
 };
 
 /**
  * @brief Manager for Events
  *
+ * Each type of event gets a slot the first time it is
+ * used, so that finding its handler is a single load
+ * instead of a search through every type of event.
+ *
+ * Events are delivered on the thread firing them, unless
+ * asynchronous delivery is started : deferrable events are
+ * then queued and delivered in batches on a dedicated thread.
  */
 class EventsManager
 {
+public:
+    /**
+     * @brief Max number of types of events
+     *
+     */
+    static constexpr std::size_t MAX_EVENTS = 64;
+    /**
+     * @brief Max number of queued events
+     *
+     * Events fired while the queue is full are
+     * delivered right away by the firing thread.
+     */
+    static constexpr std::size_t MAX_DEFERRED = 65536;
+
 private:
-    std::vector<EventHandler<void *> *> handlers;
+    std::array<std::atomic<IEventHandler *>, MAX_EVENTS> handlers;
+    std::mutex lock;
     static EventsManager *INSTANCE;
+    static std::atomic<std::size_t> nextSlot;
+
+    std::atomic<bool> async;
+    std::thread asyncThread;
+    std::mutex queueLock;
+    std::condition_variable queueCond;
+    std::deque<std::function<void()>> queue;
+    std::array<bool, MAX_EVENTS> queued;
+    std::size_t peakDepth;
+    std::atomic<std::uint64_t> delivered;
+    std::atomic<std::uint64_t> coalesced;
+    std::atomic<std::uint64_t> overflows;
+
+    /**
+     * @brief Queues an event for the events thread
+     *
+     * @param slot the slot of the event
+     * @param merge whether to drop it if one of its type is already queued
+     * @param deliver delivers a copy of the event
+     * @return true the event is delivered or merged by the events thread
+     * @return false it was not queued and must be delivered now
+     */
+    bool defer(std::size_t slot, bool merge, std::function<void()> &&deliver);
+    /**
+     * @brief Delivers queued events until stopped
+     *
+     */
+    void deliverLoop();
 
+    /**
+     * @brief Gets the slot of T
+     *
+     * Slots are shared by all of the managers, assigned
+     * once per type and never reused.
+     * @tparam T the event
+     * @return std::size_t the index of the handler of T
+     */
     template <class T>
-    EventHandler<T> *getOrNull()
+    static std::size_t slotOf()
     {
-        auto loc = std::find_if(handlers.begin(), handlers.end(), [](const EventHandler<void *> *entry)
-                                { return *entry->getTypeInfo() == typeid(T); });
+        static const std::size_t slot = []()
+        {
+            std::size_t assigned = nextSlot++;
+            if (assigned >= MAX_EVENTS)
+                throw std::runtime_error("Too many types of events");
+            return assigned;
+        }();
 
-        if (loc == handlers.end())
-            return nullptr;
+        return slot;
+    }
 
-        return reinterpret_cast<EventHandler<T> *>(*loc);
+    template <class T>
+    EventHandler<T> *getOrNull()
+    {
+        // Only EventHandler<T> is ever stored in the slot of T
+        return static_cast<EventHandler<T> *>(handlers[slotOf<T>()].load(std::memory_order_acquire));
     }
 
     template <class T>
     EventHandler<T> *getOrCreateHandler()
     {
         auto handler = getOrNull<T>();
+        if (handler)
+            return handler;
 
+        std::lock_guard<std::mutex> guard(lock);
+        handler = getOrNull<T>();
         if (!handler)
         {
             handler = new EventHandler<T>();
-            handlers.push_back(reinterpret_cast<EventHandler<void *> *>(handler));
+            handlers[slotOf<T>()].store(handler, std::memory_order_release);
         }
 
         return handler;
@@ -265,12 +424,76 @@ public:
      */
     ~EventsManager()
     {
-        auto loc = handlers.begin();
-        while (loc != handlers.end())
-        {
-            delete *loc;
-            loc = handlers.erase(loc);
-        }
+        if (INSTANCE == this)
+            INSTANCE = nullptr;
+
+        stopAsync();
+        for (auto &handler : handlers)
+            delete handler.exchange(nullptr);
+    }
+
+    /**
+     * @brief Starts delivering deferrable events asynchronously
+     *
+     * Does nothing if already started.
+     */
+    void startAsync();
+    /**
+     * @brief Stops delivering events asynchronously
+     *
+     * Delivers the queued events before returning,
+     * later ones are delivered right away again.
+     */
+    void stopAsync();
+    /**
+     * @brief Whether deferrable events are delivered asynchronously
+     *
+     * @return true they are queued
+     * @return false they are delivered right away
+     */
+    bool isAsync() const
+    {
+        return async.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the number of queued events
+     *
+     * @return std::size_t the queue depth
+     */
+    std::size_t getQueueDepth();
+    /**
+     * @brief Get the max number of events queued at once
+     *
+     * @return std::size_t the peak queue depth
+     */
+    std::size_t getPeakDepth();
+    /**
+     * @brief Get the number of events delivered asynchronously
+     *
+     * @return std::uint64_t the number of events
+     */
+    std::uint64_t getDelivered() const
+    {
+        return delivered;
+    }
+    /**
+     * @brief Get the number of events merged into a queued one
+     *
+     * @return std::uint64_t the number of events
+     */
+    std::uint64_t getCoalesced() const
+    {
+        return coalesced;
+    }
+    /**
+     * @brief Get the number of events delivered right away because the queue was full
+     *
+     * @return std::uint64_t the number of events
+     */
+    std::uint64_t getOverflows() const
+    {
+        return overflows;
     }
 
     /**
@@ -305,6 +528,61 @@ public:
         return handler->subscribe(std::move(callback));
     }
 
+    /**
+     * @brief Subscribe a lua function to T event
+     *
+     * The function is called on the executor of the plugin
+     * owning it, always with a copy of the event. Deferrable
+     * events are posted, the others are waited for up to the
+     * plugin timeout, and only copied back if the plugin was
+     * done in time. It is unsubscribed when the
+     * plugin is unloaded, and only released then, once its
+     * executor is stopped : the snapshots firing threads hold
+     * never own it.
+     * @tparam T the event to subscribe to
+     * @param ref the lua function
+     */
+    template <class T>
+    void subscribeLua(const luabridge::LuaRef &ref)
+    {
+        static_assert(std::is_base_of_v<IEvent<T>, T>, "Class doesn't derive from IEvent");
+        // Only copied by the thread loading the plugin, never by the firing ones
+        auto callback = std::make_shared<luabridge::LuaRef>(ref);
+        std::shared_ptr<PluginExecutor> executor = PluginExecutor::of(ref.state());
+
+        if (!executor)
+        {
+            subscribe<T>([callback](T &event)
+                         { (*callback)(event); });
+            return;
+        }
+
+        // Only used on the executor, which is stopped before the ref is released
+        luabridge::LuaRef *function = callback.get();
+        std::weak_ptr<PluginExecutor> weak = executor;
+        auto id = subscribe<T>([weak, function](T &event)
+                               {
+            auto executor = weak.lock();
+            if (!executor)
+                return;
+
+            if constexpr (T::DEFERRABLE)
+                executor->post([function, event]() mutable
+                               { (*function)(event); });
+            else
+            {
+                // A late plugin is left running, on its own copy
+                auto copy = std::make_shared<T>(event);
+                if (executor->call([function, copy]()
+                                   { (*function)(*copy); }))
+                    event = *copy;
+            } });
+
+        // Holds the ref until the plugin is unloaded
+        executor->onUnload([this, id, callback]()
+                           { unsubscribe<T>(id); });
+    }
+
     /**
      * @brief Unsubscribe to T event
      *
@@ -323,7 +601,9 @@ public:
     /**
      * @brief Fire T event
      *
-     * Fire event for all functions that are subscribed to it
+     * Fire event for all functions that are subscribed to it,
+     * later on the events thread for deferrable events when
+     * asynchronous delivery is started
      * @tparam T the event
      * @param event the event value
      */
@@ -333,10 +613,19 @@ public:
         static_assert(std::is_base_of_v<IEvent<T>, T>, "Class doesn't derive from IEvent");
         EventHandler<T> *handler = getOrNull<T>();
 
-        if (handler)
+        if (!handler)
+            return;
+
+        if constexpr (T::DEFERRABLE)
         {
-            handler->fire(event);
+            static_assert(std::is_copy_constructible_v<T>, "Deferrable events should be copyable");
+            // Handlers live as long as the manager, which drains the queue first
+            if (isAsync() && defer(slotOf<T>(), T::COALESCED, [handler, event]() mutable
+                                   { handler->fire(event); }))
+                return;
         }
+
+        handler->fire(event);
     }
 
     /**
@@ -358,7 +647,7 @@ void IEvent<T>::loadLua(lua_State *state) {
                 if(!ref.isFunction())
                     return;
 
-                EventsManager::inst()->subscribe<T>(const_cast<luabridge::LuaRef&>(ref));
+                EventsManager::inst()->subscribeLua<T>(ref);
             })
             .template beginClass<T>(cleanedEvent.c_str())
             .endClass()
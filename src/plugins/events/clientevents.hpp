@@ -30,6 +30,12 @@
  * @endcode
  */
 class ClientConnectedEvent : public IEvent<ClientConnectedEvent> {
+public:
+    /**
+     * @brief Only notifies of the connection
+     *
+     */
+    static constexpr bool DEFERRABLE = true;
 };
 
 /**
@@ -65,6 +71,30 @@ public:
      * @param packet the pointer to the packet
      */
     ClientHandshakeEvent(HandshakePacket *packet) : packet(packet) {}
+    /**
+     * @brief Copy the event and its packet
+     *
+     * The copy owns its packet, so that a plugin handling
+     * it late never changes the packet of the firer.
+     * @param other the event to copy
+     */
+    ClientHandshakeEvent(const ClientHandshakeEvent &other) : packet(nullptr),
+                                                              owned(std::make_shared<HandshakePacket>(*other.packet))
+    {
+        packet = owned.get();
+    }
+    /**
+     * @brief Copies the packet of another event into this one's
+     *
+     * @param other the event to copy the packet of
+     * @return ClientHandshakeEvent& this event
+     */
+    ClientHandshakeEvent &operator=(const ClientHandshakeEvent &other)
+    {
+        if (this != &other)
+            *packet = *other.packet;
+        return *this;
+    }
 
     /**
      * @brief Loads this event to lua
@@ -80,12 +110,15 @@ public:
                     if(!ref.isFunction())
                         return;
 
-                    EventsManager::inst()->subscribe<ClientHandshakeEvent>(const_cast<luabridge::LuaRef &>(ref)); })
+                    EventsManager::inst()->subscribeLua<ClientHandshakeEvent>(ref); })
             .beginClass<ClientHandshakeEvent>("ClientHandshake")
             .addProperty("packet", &ClientHandshakeEvent::packet)
             .endClass()
             .endNamespace();
     }
+
+private:
+    std::shared_ptr<HandshakePacket> owned;
 };
 
 /**
@@ -122,6 +155,30 @@ public:
      * @param packet the pointer to the packet
      */
     ClientStatusEvent(ServerListPacket *packet) : packet(packet) {}
+    /**
+     * @brief Copy the event and its packet
+     *
+     * The copy owns its packet, so that a plugin handling
+     * it late never changes the packet of the firer.
+     * @param other the event to copy
+     */
+    ClientStatusEvent(const ClientStatusEvent &other) : packet(nullptr),
+                                                        owned(std::make_shared<ServerListPacket>(*other.packet))
+    {
+        packet = owned.get();
+    }
+    /**
+     * @brief Copies the packet of another event into this one's
+     *
+     * @param other the event to copy the packet of
+     * @return ClientStatusEvent& this event
+     */
+    ClientStatusEvent &operator=(const ClientStatusEvent &other)
+    {
+        if (this != &other)
+            *packet = *other.packet;
+        return *this;
+    }
 
     /**
      * @brief Loads this event to lua
@@ -137,12 +194,15 @@ public:
                     if(!ref.isFunction())
                         return;
 
-                    EventsManager::inst()->subscribe<ClientStatusEvent>(const_cast<luabridge::LuaRef&>(ref)); })
+                    EventsManager::inst()->subscribeLua<ClientStatusEvent>(ref); })
             .beginClass<ClientStatusEvent>("ClientStatus")
             .addProperty("packet", &ClientStatusEvent::packet)
             .endClass()
             .endNamespace();
     }
+
+private:
+    std::shared_ptr<ServerListPacket> owned;
 };
 
 #endif // MINESERVER_CLIENTEVENTS_H
\ No newline at end of file
@@ -31,6 +31,12 @@
  */
 class ServerStartEvent : public IEvent<ServerStartEvent>
 {
+public:
+    /**
+     * @brief Only notifies of the start
+     *
+     */
+    static constexpr bool DEFERRABLE = true;
 };
 
 #endif // MINESERVER_SERVEREVENTS_H
\ No newline at end of file
@@ -0,0 +1,405 @@
+/**
+ * @file executor.cpp
+ * @author Lygaen
+ * @brief The file containing the plugins executors logic
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "executor.h"
+#include <utils/logger.h>
+#include <condition_variable>
+#include <exception>
+#include <utility>
+#if defined(__linux__)
+#include <time.h>
+#endif
+
+/**
+ * @brief Gets the CPU time of the current thread
+ *
+ * Falls back to the wall time where it is not available.
+ * @return std::uint64_t the time in nanoseconds
+ */
+static std::uint64_t threadTime()
+{
+#if defined(__linux__)
+    timespec spec;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &spec);
+    return (std::uint64_t)spec.tv_sec * 1000000000 + spec.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+PluginExecutor::PluginExecutor(std::string name, std::chrono::milliseconds timeout) : name(std::move(name)),
+                                                                                      timeout(timeout),
+                                                                                      head(&stub),
+                                                                                      tail(&stub),
+                                                                                      stub(),
+                                                                                      depth(0),
+                                                                                      running(false),
+                                                                                      thread(),
+                                                                                      threadId(),
+                                                                                      unloadLock(),
+                                                                                      unloaders(),
+                                                                                      budget(0),
+                                                                                      slowThreshold(std::chrono::milliseconds::zero()),
+                                                                                      current(),
+                                                                                      handled(0),
+                                                                                      timeouts(0),
+                                                                                      latency(0),
+                                                                                      cpuTime(0),
+                                                                                      slow(0),
+                                                                                      aborted(0)
+{
+    stub.next = nullptr;
+}
+
+PluginExecutor::~PluginExecutor()
+{
+    stop();
+
+    // Nothing is pushed anymore, the in progress pushes are done
+    while (Node *node = pop())
+        delete node;
+}
+
+void PluginExecutor::push(Node *node)
+{
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node *previous = head.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+}
+
+PluginExecutor::Node *PluginExecutor::pop()
+{
+    Node *current = tail;
+    Node *next = current->next.load(std::memory_order_acquire);
+
+    if (current == &stub)
+    {
+        if (!next)
+            return nullptr;
+
+        tail = next;
+        current = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (next)
+    {
+        tail = next;
+        return current;
+    }
+
+    // A producer swapped the head but did not link its node yet
+    if (current != head.load(std::memory_order_acquire))
+        return nullptr;
+
+    push(&stub);
+    next = current->next.load(std::memory_order_acquire);
+    if (next)
+    {
+        tail = next;
+        return current;
+    }
+
+    return nullptr;
+}
+
+void PluginExecutor::run()
+{
+    threadId = std::this_thread::get_id();
+
+    while (running)
+    {
+        Node *node = pop();
+        if (!node)
+        {
+            std::int64_t current = depth.load();
+            if (current <= 0)
+                depth.wait(current);
+            else
+                std::this_thread::yield();
+            continue;
+        }
+
+        depth--;
+        if (node->task)
+        {
+            current.start = std::chrono::steady_clock::now();
+            current.deadline = node->deadline;
+            current.instructions = 0;
+            current.trace.clear();
+            current.stopped = nullptr;
+            std::uint64_t cpuStart = threadTime();
+
+            try
+            {
+                node->task();
+            }
+            catch (const std::exception &e)
+            {
+                logger::error("Plugin %s failed : %s", name.c_str(), e.what());
+            }
+
+            cpuTime += threadTime() - cpuStart;
+            auto end = std::chrono::steady_clock::now();
+            handled++;
+            latency = std::chrono::duration<double, std::milli>(end - node->posted).count();
+
+            std::chrono::milliseconds threshold = slowThreshold;
+            if (threshold.count() > 0 && end - current.start >= threshold)
+            {
+                slow++;
+                logger::warn("Plugin %s took %.1f ms to handle an event%s%s", name.c_str(),
+                             std::chrono::duration<double, std::milli>(end - current.start).count(),
+                             current.trace.empty() ? "" : "\n", current.trace.c_str());
+            }
+        }
+        delete node;
+    }
+
+    threadId = std::thread::id();
+}
+
+void PluginExecutor::start()
+{
+    if (running.exchange(true))
+        return;
+
+    thread = std::thread(&PluginExecutor::run, this);
+}
+
+void PluginExecutor::stop()
+{
+    if (!running.exchange(false))
+        return;
+
+    // Wakes the executor up so that it sees it is stopped
+    post(Task());
+    thread.join();
+}
+
+void PluginExecutor::setLimits(std::uint64_t instructions, std::chrono::milliseconds threshold)
+{
+    budget = instructions;
+    slowThreshold = threshold;
+}
+
+void PluginExecutor::enqueue(Task &&task, std::chrono::steady_clock::time_point deadline)
+{
+    Node *node = new Node();
+    node->task = std::move(task);
+    node->posted = std::chrono::steady_clock::now();
+    node->deadline = deadline;
+    push(node);
+
+    if (depth.fetch_add(1) <= 0)
+        depth.notify_one();
+}
+
+void PluginExecutor::post(Task &&task)
+{
+    enqueue(std::move(task), std::chrono::steady_clock::time_point::max());
+}
+
+bool PluginExecutor::call(Task &&task)
+{
+    if (std::this_thread::get_id() == threadId.load())
+    {
+        task();
+        return true;
+    }
+
+    if (!running)
+        return false;
+
+    struct State
+    {
+        std::mutex lock;
+        std::condition_variable cond;
+        bool done = false;
+        bool abandoned = false;
+    };
+    auto state = std::make_shared<State>();
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    enqueue([state, task = std::move(task)]()
+            {
+        {
+            std::lock_guard<std::mutex> guard(state->lock);
+            if (state->abandoned)
+                return;
+        }
+
+        auto finish = [&state]()
+        {
+            {
+                std::lock_guard<std::mutex> guard(state->lock);
+                state->done = true;
+            }
+            state->cond.notify_one();
+        };
+
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            finish();
+            throw;
+        }
+        finish(); },
+            deadline);
+
+    // The task owns its values, it can be left running
+    std::unique_lock<std::mutex> guard(state->lock);
+    if (!state->cond.wait_until(guard, deadline, [&state]()
+                                { return state->done; }))
+    {
+        state->abandoned = true;
+        timeouts++;
+        logger::debug("Plugin %s did not handle a call in %lld ms, skipped", name.c_str(), (long long)timeout.count());
+        return false;
+    }
+
+    return true;
+}
+
+void PluginExecutor::onUnload(std::function<void()> &&unloader)
+{
+    std::lock_guard<std::mutex> guard(unloadLock);
+    unloaders.push_back(std::move(unloader));
+}
+
+void PluginExecutor::unload()
+{
+    std::vector<std::function<void()>> current;
+    {
+        std::lock_guard<std::mutex> guard(unloadLock);
+        current.swap(unloaders);
+    }
+
+    for (auto &unloader : current)
+        unloader();
+}
+
+void PluginExecutor::bind(lua_State *state)
+{
+    // Threads of the state get a copy of its extra space and hook
+    *static_cast<PluginExecutor **>(lua_getextraspace(state)) = this;
+    lua_sethook(state, &PluginExecutor::hook, LUA_MASKCOUNT, HOOK_INTERVAL);
+
+    // Protected calls would catch the stop of a task and go on
+    for (const char *global : {"pcall", "xpcall"})
+    {
+        lua_getglobal(state, global);
+        if (lua_isfunction(state, -1))
+        {
+            lua_pushcclosure(state, &PluginExecutor::guarded, 1);
+            lua_setglobal(state, global);
+        }
+        else
+            lua_pop(state, 1);
+    }
+
+    lua_getglobal(state, "coroutine");
+    if (lua_istable(state, -1))
+    {
+        lua_getfield(state, -1, "resume");
+        if (lua_isfunction(state, -1))
+        {
+            lua_pushcclosure(state, &PluginExecutor::guarded, 1);
+            lua_setfield(state, -2, "resume");
+        }
+        else
+            lua_pop(state, 1);
+    }
+    lua_pop(state, 1);
+}
+
+int PluginExecutor::guarded(lua_State *state)
+{
+    // Calls the wrapped function with the same arguments
+    lua_pushvalue(state, lua_upvalueindex(1));
+    lua_insert(state, 1);
+    lua_callk(state, lua_gettop(state) - 1, LUA_MULTRET, 0, &PluginExecutor::guardedContinue);
+    return guardedContinue(state, LUA_OK, 0);
+}
+
+int PluginExecutor::guardedContinue(lua_State *state, int status, lua_KContext context)
+{
+    (void)status;
+    (void)context;
+    PluginExecutor *executor = *static_cast<PluginExecutor **>(lua_getextraspace(state));
+
+    // Raised again until the task is done
+    if (executor && std::this_thread::get_id() == executor->threadId.load(std::memory_order_relaxed) &&
+        executor->current.stopped)
+        return luaL_error(state, "%s", executor->current.stopped);
+
+    return lua_gettop(state);
+}
+
+void PluginExecutor::hook(lua_State *state, lua_Debug *debug)
+{
+    (void)debug;
+    PluginExecutor *executor = *static_cast<PluginExecutor **>(lua_getextraspace(state));
+
+    // Loading the plugin is not limited
+    if (!executor || std::this_thread::get_id() != executor->threadId.load(std::memory_order_relaxed))
+        return;
+
+    auto &current = executor->current;
+    current.instructions += HOOK_INTERVAL;
+
+    auto now = std::chrono::steady_clock::now();
+    std::uint64_t limit = executor->budget.load(std::memory_order_relaxed);
+    std::chrono::milliseconds threshold = executor->slowThreshold.load(std::memory_order_relaxed);
+    bool exhausted = limit > 0 && current.instructions > limit;
+    bool late = threshold.count() > 0 && now - current.start >= threshold;
+    // The caller gave up on the task, its result is of no use
+    bool expired = now >= current.deadline;
+
+    // Kept once, where the task was when it became slow
+    if (current.trace.empty() && (exhausted || late || expired))
+    {
+        luaL_traceback(state, state, nullptr, 0);
+        const char *trace = lua_tostring(state, -1);
+        current.trace = trace ? trace : "";
+        lua_pop(state, 1);
+    }
+
+    if (!current.stopped && exhausted)
+    {
+        current.stopped = "instructions budget exceeded";
+        executor->aborted++;
+        logger::error("Plugin %s ran out of its %llu instructions, stopped\n%s", executor->name.c_str(),
+                      (unsigned long long)limit, current.trace.c_str());
+    }
+    else if (!current.stopped && expired)
+    {
+        current.stopped = "call timed out";
+        executor->aborted++;
+        logger::warn("Plugin %s did not handle a call in %lld ms, stopped\n%s", executor->name.c_str(),
+                     (long long)executor->timeout.count(), current.trace.c_str());
+    }
+
+    if (current.stopped)
+        luaL_error(state, "%s", current.stopped);
+}
+
+std::shared_ptr<PluginExecutor> PluginExecutor::of(lua_State *state)
+{
+    if (!state)
+        return nullptr;
+
+    PluginExecutor *executor = *static_cast<PluginExecutor **>(lua_getextraspace(state));
+    return executor ? executor->shared_from_this() : nullptr;
+}
@@ -0,0 +1,277 @@
+/**
+ * @file executor.h
+ * @author Lygaen
+ * @brief The file containing the plugins executors
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MINESERVER_EXECUTOR_H
+#define MINESERVER_EXECUTOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <plugins/luaheaders.h>
+
+/**
+ * @brief Thread running everything a plugin does
+ *
+ * A lua state must only be used by one thread at a time,
+ * so every call into a plugin is posted to the mailbox of
+ * its executor and run on its own thread. Posting never
+ * locks : the mailbox is a lock-free queue with many
+ * producers, the network threads, and a single consumer.
+ * A slow plugin only delays its own mailbox, not the
+ * network threads, unless they wait for its result.
+ *
+ * The time spent in each task is accounted to the plugin.
+ * A count hook on its lua state stops tasks running more
+ * instructions than their budget or past the timeout of
+ * their call, and keeps the lua stack of slow ones for the
+ * logs. A stopped task can not catch its stop with pcall.
+ */
+class PluginExecutor : public std::enable_shared_from_this<PluginExecutor>
+{
+public:
+    /**
+     * @brief A call into the plugin
+     *
+     */
+    typedef std::function<void()> Task;
+    /**
+     * @brief Number of lua instructions between two hook calls
+     *
+     */
+    static constexpr int HOOK_INTERVAL = 1000;
+
+private:
+    struct Node
+    {
+        std::atomic<Node *> next;
+        Task task;
+        std::chrono::steady_clock::time_point posted;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    std::string name;
+    std::chrono::milliseconds timeout;
+
+    // Producers swap the head, the executor thread pops from the tail
+    std::atomic<Node *> head;
+    Node *tail;
+    Node stub;
+    std::atomic<std::int64_t> depth;
+
+    std::atomic<bool> running;
+    std::thread thread;
+    std::atomic<std::thread::id> threadId;
+
+    std::mutex unloadLock;
+    std::vector<std::function<void()>> unloaders;
+
+    std::atomic<std::uint64_t> budget;
+    std::atomic<std::chrono::milliseconds> slowThreshold;
+    // Only used by the executor thread
+    struct
+    {
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point deadline;
+        std::uint64_t instructions;
+        std::string trace;
+        const char *stopped;
+    } current;
+
+    std::atomic<std::uint64_t> handled;
+    std::atomic<std::uint64_t> timeouts;
+    std::atomic<double> latency;
+    std::atomic<std::uint64_t> cpuTime;
+    std::atomic<std::uint64_t> slow;
+    std::atomic<std::uint64_t> aborted;
+
+    void push(Node *node);
+    Node *pop();
+    void enqueue(Task &&task, std::chrono::steady_clock::time_point deadline);
+    void run();
+    static void hook(lua_State *state, lua_Debug *debug);
+    static int guarded(lua_State *state);
+    static int guardedContinue(lua_State *state, int status, lua_KContext context);
+
+public:
+    /**
+     * @brief Construct a new Plugin Executor object
+     *
+     * Tasks are queued until PluginExecutor::start() is called.
+     * @param name the name of the plugin, for the logs
+     * @param timeout how long PluginExecutor::call() waits for a task to be done
+     */
+    PluginExecutor(std::string name, std::chrono::milliseconds timeout);
+    /**
+     * @brief Destroy the Plugin Executor object
+     *
+     * Stops it, the tasks still queued are dropped.
+     */
+    ~PluginExecutor();
+
+    /**
+     * @brief Starts running the tasks
+     *
+     */
+    void start();
+    /**
+     * @brief Stops running the tasks
+     *
+     * Waits for the running task, the queued ones are
+     * dropped. Must not be called from the executor.
+     */
+    void stop();
+
+    /**
+     * @brief Sets the limits of the tasks
+     *
+     * @param instructions the max number of lua instructions a task runs, 0 for no limit
+     * @param slowThreshold the time past which a task is logged as slow, 0 to never log
+     */
+    void setLimits(std::uint64_t instructions, std::chrono::milliseconds slowThreshold);
+
+    /**
+     * @brief Posts a task without waiting for it
+     *
+     * @param task the task, it must only use values it owns
+     */
+    void post(Task &&task);
+    /**
+     * @brief Runs a task and waits for it
+     *
+     * Gives up if the task is not done before the timeout,
+     * whatever it runs : it is then skipped if it did not
+     * start, else left to finish on its own and stopped by
+     * the hook. The task must thus only use values it owns,
+     * the caller only reads them back once it returned true.
+     * Runs it right away when called from the executor itself.
+     * @param task the task
+     * @return true the task is done
+     * @return false it timed out or the executor is stopped
+     */
+    bool call(Task &&task);
+
+    /**
+     * @brief Registers a function called when the plugin is unloaded
+     *
+     * Used to unsubscribe the callbacks of the plugin before
+     * its lua state is closed. The function is released once
+     * called, so it may own lua refs of the plugin.
+     * @param unloader the function
+     */
+    void onUnload(std::function<void()> &&unloader);
+    /**
+     * @brief Calls the unload functions
+     *
+     * Must be called once stopped, nothing else uses
+     * the lua state while they are released.
+     */
+    void unload();
+
+    /**
+     * @brief Get the name of the plugin
+     *
+     * @return const std::string& the name
+     */
+    const std::string &getName() const
+    {
+        return name;
+    }
+    /**
+     * @brief Get the number of queued tasks
+     *
+     * @return std::int64_t the queue depth
+     */
+    std::int64_t getQueueDepth() const
+    {
+        return std::max<std::int64_t>(0, depth);
+    }
+    /**
+     * @brief Get the number of tasks run
+     *
+     * @return std::uint64_t the number of tasks
+     */
+    std::uint64_t getHandled() const
+    {
+        return handled;
+    }
+    /**
+     * @brief Get the number of calls that timed out
+     *
+     * @return std::uint64_t the number of calls
+     */
+    std::uint64_t getTimeouts() const
+    {
+        return timeouts;
+    }
+    /**
+     * @brief Get the latency of the last task
+     *
+     * Time from it being posted to it being done.
+     * @return double the latency in milliseconds
+     */
+    double getLatency() const
+    {
+        return latency;
+    }
+    /**
+     * @brief Get the CPU time spent running tasks
+     *
+     * @return double the time in milliseconds
+     */
+    double getCPUTime() const
+    {
+        return cpuTime / 1e6;
+    }
+    /**
+     * @brief Get the number of tasks logged as slow
+     *
+     * @return std::uint64_t the number of tasks
+     */
+    std::uint64_t getSlow() const
+    {
+        return slow;
+    }
+    /**
+     * @brief Get the number of tasks stopped for running out of instructions or time
+     *
+     * @return std::uint64_t the number of tasks
+     */
+    std::uint64_t getAborted() const
+    {
+        return aborted;
+    }
+
+    /**
+     * @brief Binds the executor to the lua state of its plugin
+     *
+     * Also installs the hook enforcing the limits of the tasks,
+     * and wraps pcall, xpcall and coroutine.resume so that they
+     * do not catch it. Must be called once the libraries are opened.
+     * @param state the lua state
+     */
+    void bind(lua_State *state);
+    /**
+     * @brief Gets the executor of the plugin owning a lua state
+     *
+     * @param state the lua state, or one of its threads
+     * @return std::shared_ptr<PluginExecutor> the executor, nullptr if the state is not a plugin's
+     */
+    static std::shared_ptr<PluginExecutor> of(lua_State *state);
+};
+
+#endif // MINESERVER_EXECUTOR_H
@@ -10,8 +10,16 @@
  */
 
 #include "plugins.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <thread>
 #include <utility>
 #include <utils/logger.h>
+#include <utils/config.h>
 #include <plugins/event.h>
 #include <net/luaregnet.hpp>
 #include <utils/luaregutils.hpp>
@@ -19,28 +27,164 @@
 #include <entities/luaregentities.hpp>
 #include <cmd/luaregcmd.hpp>
 
-Plugin::Plugin(std::string path) : path(std::move(path)), state(nullptr)
+Plugin::Plugin(std::string path) : path(std::move(path)), state(nullptr), executor()
 {
 }
 
 Plugin::~Plugin()
 {
+    // Nothing may call into the state once closed, the refs
+    // of the plugin are released once its executor is stopped
+    if (executor)
+    {
+        executor->stop();
+        executor->unload();
+    }
+
     lua_close(state);
 }
 
-bool Plugin::load()
+/**
+ * @brief Hashes the source of a plugin
+ *
+ * FNV-1a, only used to tell sources apart.
+ * @param source the source
+ * @return std::uint64_t the hash
+ */
+static std::uint64_t hashSource(const std::string &source)
 {
-    state = luaL_newstate();
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char c : source)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+/**
+ * @brief Appends dumped bytecode to a string
+ *
+ * @param state the lua state
+ * @param data the bytecode
+ * @param size the size of @p data
+ * @param out the string
+ * @return int 0, as the dump never fails
+ */
+static int writeBytecode(lua_State *state, const void *data, size_t size, void *out)
+{
+    (void)state;
+    static_cast<std::string *>(out)->append(static_cast<const char *>(data), size);
+    return 0;
+}
+
+bool Plugin::loadChunk(bool &cached)
+{
+    cached = false;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return luaL_loadfile(state, path.c_str()) == LUA_OK;
+    std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::string chunkName = "@" + path;
+
+    if (!Config::inst()->PLUGIN_BYTECODE_CACHE.getValue())
+        return luaL_loadbufferx(state, source.data(), source.size(), chunkName.c_str(), "t") == LUA_OK;
+
+    std::error_code err;
+    auto mtime = std::filesystem::last_write_time(path, err).time_since_epoch().count();
+    std::string key = std::string(CACHE_MAGIC) + " " + std::to_string(hashSource(source)) + " " + std::to_string(mtime) + "\n";
+
+    std::filesystem::path cachePath = std::filesystem::path(path).parent_path() / CACHE_DIR / std::filesystem::path(path).stem();
+    cachePath += ".luac";
+
+    std::ifstream cacheFile(cachePath, std::ios::binary);
+    if (cacheFile)
+    {
+        std::string content((std::istreambuf_iterator<char>(cacheFile)), std::istreambuf_iterator<char>());
+        // Bytecode of another lua version is refused by lua itself
+        if (content.compare(0, key.size(), key) == 0 &&
+            luaL_loadbufferx(state, content.data() + key.size(), content.size() - key.size(), chunkName.c_str(), "b") == LUA_OK)
+        {
+            cached = true;
+            return true;
+        }
+
+        lua_settop(state, 0);
+    }
+
+    if (luaL_loadbufferx(state, source.data(), source.size(), chunkName.c_str(), "t") != LUA_OK)
+        return false;
+
+    // Debug information is kept for the stack traces
+    std::string bytecode = key;
+    lua_dump(state, writeBytecode, &bytecode, 0);
+
+    std::filesystem::create_directories(cachePath.parent_path(), err);
+    std::filesystem::path tempPath = cachePath;
+    tempPath += ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out.write(bytecode.data(), (std::streamsize)bytecode.size());
+        if (!out)
+        {
+            logger::debug("Could not cache the bytecode of plugin '%s'", path.c_str());
+            return true;
+        }
+    }
+    std::filesystem::rename(tempPath, cachePath, err);
+
+    return true;
+}
+
+bool Plugin::prepare()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    int timeout = std::max(1, Config::inst()->PLUGIN_TIMEOUT.getValue());
+    executor = std::make_shared<PluginExecutor>(std::filesystem::path(path).stem().string(), std::chrono::milliseconds(timeout));
+
+    executor->setLimits(std::max(0, Config::inst()->PLUGIN_BUDGET.getValue()),
+                        std::chrono::milliseconds(std::max(0, Config::inst()->PLUGIN_SLOW_HANDLER.getValue())));
 
+    state = luaL_newstate();
     defineLibs();
+    // Wraps some of the libraries, once they are opened
+    executor->bind(state);
+    auto bound = std::chrono::steady_clock::now();
+
+    bool cached;
+    if (!loadChunk(cached))
+    {
+        logger::error("Could not load plugin at '%s'", path.c_str());
+        logger::error("%s", lua_tostring(state, -1));
+        return false;
+    }
+    auto loaded = std::chrono::steady_clock::now();
+
+    typedef std::chrono::duration<double, std::milli> millis;
+    logger::debug("Prepared plugin '%s' in %.1f ms (bindings %.1f ms, %s %.1f ms)", path.c_str(),
+                  millis(loaded - start).count(), millis(bound - start).count(),
+                  cached ? "cached" : "compiled", millis(loaded - bound).count());
+    return true;
+}
 
-    if (luaL_dofile(state, path.c_str()) != 0)
+bool Plugin::run()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    if (lua_pcall(state, 0, LUA_MULTRET, 0) != LUA_OK)
     {
         logger::error("Could not load plugin at '%s'", path.c_str());
         logger::error("%s", lua_tostring(state, -1));
         return false;
     }
 
+    logger::debug("Ran plugin '%s' in %.1f ms", path.c_str(),
+                  std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+    // Events fired while loading were queued until now
+    executor->start();
     return true;
 }
 
@@ -86,7 +230,8 @@ PluginsManager::~PluginsManager()
 
 void PluginsManager::load()
 {
-    plugins.clear();
+    auto start = std::chrono::steady_clock::now();
+    unload();
 
     if (!std::filesystem::exists(BASE_PATH) && !std::filesystem::create_directories(BASE_PATH))
     {
@@ -94,17 +239,40 @@ void PluginsManager::load()
         return;
     }
 
+    std::vector<std::shared_ptr<Plugin>> found;
     for (auto &entry : std::filesystem::directory_iterator(BASE_PATH))
     {
         if (entry.path().extension() == ".lua")
-        {
-            auto plugin = std::make_shared<Plugin>(entry.path().string());
-            if (plugin->load())
-            {
-                plugins.push_back(std::move(plugin));
-            }
-        }
+            found.push_back(std::make_shared<Plugin>(entry.path().string()));
     }
 
-    logger::debug("Loaded %d plugins !", plugins.size());
+    // Plugins have their own lua state, they are prepared independently
+    std::vector<char> prepared(found.size(), false);
+    std::atomic<std::size_t> next = 0;
+    std::size_t count = std::min<std::size_t>(found.size(), std::max(1u, std::thread::hardware_concurrency()));
+
+    std::vector<std::thread> loaders;
+    for (std::size_t i = 0; i < count; i++)
+        loaders.emplace_back([&found, &prepared, &next]()
+                             {
+            for (std::size_t j = next++; j < found.size(); j = next++)
+                prepared[j] = found[j]->prepare(); });
+    for (std::thread &loader : loaders)
+        loader.join();
+
+    // Their main chunks use the server (config, events, commands...), one at a time
+    for (std::size_t i = 0; i < found.size(); i++)
+    {
+        if (prepared[i] && found[i]->run())
+            plugins.push_back(std::move(found[i]));
+    }
+
+    logger::debug("Loaded %d plugins in %.1f ms !", plugins.size(),
+                  std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+void PluginsManager::unload()
+{
+    // Each plugin is stopped and unloaded once its last owner is gone
+    plugins.clear();
 }
@@ -14,20 +14,47 @@
 
 #include <string>
 #include <filesystem>
+#include <memory>
 #include <vector>
 #include <plugins/luaheaders.h>
+#include <plugins/executor.h>
 
 /**
  * @brief Plugin class
  *
+ * Everything the plugin does once loaded
+ * runs on its own PluginExecutor.
  */
 class Plugin
 {
 private:
     std::string path;
     lua_State *state;
+    std::shared_ptr<PluginExecutor> executor;
+
+    /**
+     * @brief Directory of the bytecode cache, next to the plugins
+     *
+     */
+    static constexpr std::string_view CACHE_DIR = ".cache";
+    /**
+     * @brief Header of the cached bytecode files
+     *
+     * Followed by the hash and modification time of the source.
+     */
+    static constexpr std::string_view CACHE_MAGIC = "mineserver-luac-1";
 
     void defineLibs();
+    /**
+     * @brief Loads the chunk of the plugin
+     *
+     * From its cached bytecode if the source did not change,
+     * else compiles the source and caches its bytecode.
+     * @param cached whether the bytecode was cached
+     * @return true the chunk is on the top of the stack
+     * @return false it could not be loaded, the error is on the top of the stack
+     */
+    bool loadChunk(bool &cached);
 
 public:
     /**
@@ -54,18 +81,41 @@ public:
     ~Plugin();
 
     /**
-     * @brief Loads the plugin
+     * @brief Prepares the plugin to be run
      *
+     * Creates its lua state and loads its chunk. Only
+     * uses the plugin, plugins can be prepared in parallel.
      * @return true plugin has succeeded in loading
      * @return false plugin has failed in loading
      */
-    bool load();
+    bool prepare();
+    /**
+     * @brief Runs the main chunk of the plugin
+     *
+     * Must be called once prepared. The chunk uses the
+     * server, plugins must be run one at a time.
+     * @return true plugin has succeeded in running
+     * @return false plugin has failed in running
+     */
+    bool run();
+
+    /**
+     * @brief Get the executor of the plugin
+     *
+     * @return const std::shared_ptr<PluginExecutor>& the executor
+     */
+    const std::shared_ptr<PluginExecutor> &getExecutor() const
+    {
+        return executor;
+    }
 };
 
 /**
  * @brief Plugin Manager
  *
- * Pretty transparent huh ?
+ * Pretty transparent huh ? Plugins are
+ * prepared in parallel, each has its own state,
+ * then run one at a time.
  */
 class PluginsManager
 {
@@ -93,6 +143,14 @@ public:
      * Can be used to reload plugins as well
      */
     void load();
+    /**
+     * @brief Unloads all plugins
+     *
+     * Stops them, unsubscribes their callbacks and closes
+     * their states. Must be called while the managers they
+     * use (events, commands...) still exist.
+     */
+    void unload();
 
     /**
      * @brief Get the registered plugins
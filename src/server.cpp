@@ -10,19 +10,26 @@
  */
 
 #include "server.h"
-#include <future>
 #include <utils/logger.h>
 #include <plugins/event.h>
 #include <plugins/events/serverevents.hpp>
-#include <chrono>
+#include <net/packets/status/serverlist.h>
+#include <algorithm>
+#include <thread>
 
 Server *Server::INSTANCE;
-Server::Server() : sock(),
-                   connectedClients(),
-                   pluginsManager(),
+Server::Server() : pluginsManager(),
                    eventsManager(),
                    commandsManager(),
                    consoleManager(),
+                   metricsManager(),
+                   sessionCache(),
+                   sessionClient(),
+                   loginCrypto(),
+                   compressionPolicy(),
+                   compressionPool(),
+                   listeners(),
+                   reactor(),
                    running(false)
 {
     if (INSTANCE)
@@ -35,13 +42,12 @@ Server::Server() : sock(),
         exit(EXIT_FAILURE);
     }
 
-    if (!crypto::init())
+    if (!crypto::init(Config::inst()->KEY_FILE.getValue()))
     {
-        logger::fatal("Could not init cryptography !");
+        logger::fatal("Could not init cryptography ! Check the key file if there is one");
         exit(EXIT_FAILURE);
     }
-
-    sock = ServerSocket(SOCK_STREAM);
+    logger::debug("Cryptography ready in %.1f ms", crypto::getInitTime());
 }
 
 Server::~Server()
@@ -64,21 +70,160 @@ void Server::checks()
     }
 }
 
+void Server::listen(const std::string &address, int port, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; i++)
+    {
+        ServerSocket sock(SOCK_STREAM);
+        if (count > 1 && !sock.setReusePort())
+        {
+            logger::fatal("Could not share port %d between network threads", port);
+            exit(EXIT_FAILURE);
+        }
+
+        if (!sock.bind(address.c_str(), port))
+        {
+            logger::fatal("Could not start server on %s:%d", address.c_str(), port);
+            exit(EXIT_FAILURE);
+        }
+
+        int deferAccept = Config::inst()->DEFER_ACCEPT.getValue();
+        if (deferAccept > 0 && !sock.setDeferAccept(deferAccept))
+            logger::warn("Could not defer accepting connections on %s:%d", address.c_str(), port);
+
+        sock.start(Config::inst()->BACKLOG.getValue());
+        listeners.push_back(sock);
+    }
+}
+
+void Server::startSessionClient()
+{
+    SessionClient::Options options;
+    options.host = Config::inst()->SESSION_HOST.getValue();
+    options.port = Config::inst()->SESSION_PORT.getValue();
+    options.connections = std::max(1, Config::inst()->SESSION_CONNECTIONS.getValue());
+    options.timeout = std::max(1, Config::inst()->SESSION_TIMEOUT.getValue());
+    sessionClient.start(options);
+
+    metricsManager.add("session.pending", [this]()
+                       { return (double)sessionClient.getPending(); });
+    metricsManager.add("session.requests", [this]()
+                       { return (double)sessionClient.getRequests(); });
+    metricsManager.add("session.failures", [this]()
+                       { return (double)sessionClient.getFailures(); });
+    metricsManager.add("session.connects", [this]()
+                       { return (double)sessionClient.getConnects(); });
+    metricsManager.add("session.latency_ms", [this]()
+                       { return sessionClient.getLatency(); });
+
+    sessionCache.setTTL(std::chrono::seconds(Config::inst()->SESSION_CACHE_TTL.getValue()));
+    metricsManager.add("session.cache_hits", [this]()
+                       { return (double)sessionCache.getHits(); });
+    metricsManager.add("session.cache_misses", [this]()
+                       { return (double)sessionCache.getMisses(); });
+    metricsManager.add("session.cache_size", [this]()
+                       { return (double)sessionCache.getSize(); });
+}
+
+void Server::startLoginCrypto()
+{
+    loginCrypto.start(Config::inst()->LOGIN_CRYPTO_WORKERS.getValue());
+
+    metricsManager.add("crypto.pending", [this]()
+                       { return (double)loginCrypto.getPending(); });
+    metricsManager.add("crypto.rejected", [this]()
+                       { return (double)loginCrypto.getRejected(); });
+    metricsManager.add("crypto.latency_ms", [this]()
+                       { return loginCrypto.getLatency(); });
+}
+
+void Server::setupCompressionPolicy()
+{
+    compressionPolicy.setLevel(Config::inst()->COMPRESSION_LVL.getValue());
+    if (!compressionPolicy.pin(Config::inst()->COMPRESSION_POLICIES.getValue()))
+        logger::warn("Invalid compression policies, expected a list like \"0x21:6,0x15:0\"");
+
+    compressionPolicy.exposeMetrics(&metricsManager);
+}
+
+void Server::startCompressionPool()
+{
+    compressionPool.start(Config::inst()->COMPRESSION_WORKERS.getValue(), Config::inst()->COMPRESSION_LVL.getValue(), &compressionPolicy);
+
+    metricsManager.add("compression.pending", [this]()
+                       { return (double)compressionPool.getPending(); });
+    metricsManager.add("compression.jobs", [this]()
+                       { return (double)compressionPool.getJobs(); });
+    metricsManager.add("compression.latency_ms", [this]()
+                       { return compressionPool.getLatency(); });
+}
+
+void Server::startAsyncEvents()
+{
+    eventsManager.startAsync();
+
+    metricsManager.add("events.queue_depth", [this]()
+                       { return (double)eventsManager.getQueueDepth(); });
+    metricsManager.add("events.queue_peak", [this]()
+                       { return (double)eventsManager.getPeakDepth(); });
+    metricsManager.add("events.delivered", [this]()
+                       { return (double)eventsManager.getDelivered(); });
+    metricsManager.add("events.coalesced", [this]()
+                       { return (double)eventsManager.getCoalesced(); });
+    metricsManager.add("events.overflows", [this]()
+                       { return (double)eventsManager.getOverflows(); });
+}
+
+void Server::exposePluginsMetrics()
+{
+    for (const auto &plugin : pluginsManager.getPlugins())
+    {
+        std::shared_ptr<PluginExecutor> executor = plugin->getExecutor();
+        std::string prefix = "plugins." + executor->getName() + ".";
+
+        metricsManager.add(prefix + "queue_depth", [executor]()
+                           { return (double)executor->getQueueDepth(); });
+        metricsManager.add(prefix + "handled", [executor]()
+                           { return (double)executor->getHandled(); });
+        metricsManager.add(prefix + "timeouts", [executor]()
+                           { return (double)executor->getTimeouts(); });
+        metricsManager.add(prefix + "latency_ms", [executor]()
+                           { return executor->getLatency(); });
+        metricsManager.add(prefix + "cpu_ms", [executor]()
+                           { return executor->getCPUTime(); });
+        metricsManager.add(prefix + "slow", [executor]()
+                           { return (double)executor->getSlow(); });
+        metricsManager.add(prefix + "aborted", [executor]()
+                           { return (double)executor->getAborted(); });
+    }
+}
+
 void Server::start()
 {
     std::string addr = Config::inst()->ADDRESS.getValue();
     int port = Config::inst()->PORT.getValue();
 
-    if (!sock.bind(addr.c_str(), port))
+    unsigned int ioThreads = std::max(0, Config::inst()->IO_THREADS.getValue());
+    if (ioThreads == 0)
+        ioThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    bool reusePort = Config::inst()->REUSE_PORT.getValue();
+#if !defined(__linux__)
+    if (reusePort)
     {
-        logger::fatal("Could not start server on %s:%d", addr.c_str(), port);
-        exit(EXIT_FAILURE);
+        logger::warn("Sharded listeners are not supported on this platform, using a single one");
+        reusePort = false;
     }
-    sock.start(Config::inst()->BACKLOG.getValue());
+#endif
+    listen(addr, port, reusePort ? ioThreads : 1);
 
     checks();
 
+    if (Config::inst()->ASYNC_EVENTS.getValue())
+        startAsyncEvents();
+
     pluginsManager.load();
+    exposePluginsMetrics();
     consoleManager.start();
 
     running = true;
@@ -86,24 +231,54 @@ void Server::start()
     ServerStartEvent startEvent;
     eventsManager.fire(startEvent);
 
+    metricsManager.add("status.cache.hits", []()
+                       { return (double)ServerListPacket::getCacheHits(); });
+    metricsManager.add("status.cache.misses", []()
+                       { return (double)ServerListPacket::getCacheMisses(); });
+    metricsManager.add("status.cache.hit_ratio", []()
+                       {
+        double hits = (double)ServerListPacket::getCacheHits();
+        double total = hits + (double)ServerListPacket::getCacheMisses();
+        return total == 0 ? 0 : hits / total; });
+
+    metricsManager.add("crypto.init_ms", []()
+                       { return crypto::getInitTime(); });
+    metricsManager.add("crypto.logins", []()
+                       { return (double)LoginCrypto::getLogins(); });
+    metricsManager.add("crypto.login_ms", []()
+                       {
+        double logins = (double)LoginCrypto::getLogins();
+        return logins == 0 ? 0 : LoginCrypto::getTime() / logins; });
+
+    if (Config::inst()->ONLINE_MODE.getValue())
+        startSessionClient();
+    if (Config::inst()->ONLINE_MODE.getValue() && Config::inst()->LOGIN_CRYPTO_WORKERS.getValue() > 0)
+        startLoginCrypto();
+    if (Config::inst()->COMPRESSION_LVL.getValue() != 0)
+        setupCompressionPolicy();
+    if (Config::inst()->COMPRESSION_LVL.getValue() != 0 && Config::inst()->COMPRESSION_WORKERS.getValue() > 0)
+        startCompressionPool();
+
     logger::info("Server started on %s:%d !", addr.c_str(), port);
-    while (running)
-    {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100)); // So that we don't overload the CPU
-        ClientSocket cs = sock.accept();
-
-        if (!cs.isValid())
-            continue;
-
-        // Join thread afterwards
-        std::thread([&cs, this]()
-                    {
-            Client client(cs);
-            this->connectedClients.push_back(&client);
-            client.start();
-            this->connectedClients.remove(&client); })
-            .detach();
-    }
+    reactor.run(listeners, ioThreads);
+    // Plugins use the other managers, they go first
+    metricsManager.remove("plugins.");
+    pluginsManager.unload();
+    metricsManager.remove("status.");
+    metricsManager.remove("crypto.");
+    metricsManager.remove("session.");
+    loginCrypto.stop();
+    sessionClient.stop();
+    compressionPool.stop();
+    compressionPolicy.exposeMetrics(nullptr);
+    metricsManager.remove("compression.");
+    // Listeners like the console must not be called once destroyed
+    metricsManager.remove("events.");
+    eventsManager.stopAsync();
+
+    for (const ServerSocket &sock : listeners)
+        sock.close();
+    listeners.clear();
 }
 
 void Server::stop()
@@ -111,12 +286,7 @@ void Server::stop()
     logger::info("Stopping server...");
     running = false;
 
-    for (auto client : connectedClients)
-    {
-        client->close("Server closing");
-    }
-
-    sock.close();
+    reactor.stop();
 
     consoleManager.stop();
     logger::debug("Stopped server !");
@@ -18,9 +18,15 @@
 #include <types/chatmessage.h>
 #include <cmd/commands.h>
 #include <cmd/console.h>
-#include <client.h>
+#include <net/reactor.h>
+#include <net/session.h>
+#include <net/sessioncache.h>
+#include <net/logincrypto.h>
+#include <net/compressionpolicy.h>
+#include <net/compressionpool.h>
+#include <utils/metrics.h>
 #include <atomic>
-#include <list>
+#include <vector>
 
 /**
  * @brief Server Class
@@ -33,12 +39,18 @@ class Server
 {
 private:
     static Server *INSTANCE;
-    std::list<Client *> connectedClients;
     PluginsManager pluginsManager;
     EventsManager eventsManager;
     CommandsManager commandsManager;
     ConsoleManager consoleManager;
-    ServerSocket sock;
+    MetricsManager metricsManager;
+    SessionCache sessionCache;
+    SessionClient sessionClient;
+    LoginCrypto loginCrypto;
+    CompressionPolicy compressionPolicy;
+    CompressionPool compressionPool;
+    std::vector<ServerSocket> listeners;
+    Reactor reactor;
     std::atomic<bool> running;
 
     /**
@@ -49,6 +61,60 @@ private:
      * server.
      */
     static void checks();
+    /**
+     * @brief Opens the listening sockets
+     *
+     * Opens either a single listening socket or
+     * one per network thread if they are sharded,
+     * exiting if any of them could not be opened.
+     * @param address the address to bind on
+     * @param port the port to bind on
+     * @param count the number of listening sockets
+     */
+    void listen(const std::string &address, int port, unsigned int count);
+    /**
+     * @brief Starts the session client
+     *
+     * Connects the session client to the configured
+     * session server, enables the cache of verified
+     * players and registers their metrics.
+     */
+    void startSessionClient();
+    /**
+     * @brief Starts the login cryptography workers
+     *
+     * Starts the configured number of workers
+     * and registers their metrics.
+     */
+    void startLoginCrypto();
+    /**
+     * @brief Sets up the compression policy
+     *
+     * Pins the configured levels and
+     * exposes the statistics of the packets.
+     */
+    void setupCompressionPolicy();
+    /**
+     * @brief Starts the compression workers
+     *
+     * Starts the configured number of workers
+     * and registers their metrics.
+     */
+    void startCompressionPool();
+    /**
+     * @brief Starts the asynchronous events delivery
+     *
+     * Starts the events thread and
+     * registers the metrics of its queue.
+     */
+    void startAsyncEvents();
+    /**
+     * @brief Registers the metrics of the plugins
+     *
+     * The queue depth, handlers latency and CPU
+     * time of the executor of each loaded plugin.
+     */
+    void exposePluginsMetrics();
 
 public:
     /**
@@ -72,8 +138,8 @@ public:
     /**
      * @brief Stops the server
      *
-     * Stops the server on the next client loop (eg when a client
-     * connects).
+     * Stops the server on the next network loop, closing
+     * all of the connected clients.
      */
     void stop();
 
@@ -135,10 +135,14 @@ void ChatMessage::save(rapidjson::Value &document, rapidjson::Document::Allocato
 bool operator==(const ChatMessage &lhs, const ChatMessage &rhs)
 {
 #define COMPARE(x) lhs.x == rhs.x &&
-    return COMPARE(text) COMPARE(bold) COMPARE(italic) COMPARE(underlined)
+    bool equal = COMPARE(text) COMPARE(bold) COMPARE(italic) COMPARE(underlined)
         COMPARE(strikethrough) COMPARE(obfuscated)
-            COMPARE(color) COMPARE(insertion) true;
+            COMPARE(color) COMPARE(insertion) COMPARE(clickEvent.action) COMPARE(clickEvent.value) true;
 #undef COMPARE
+
+    if (!equal || lhs.next == nullptr || rhs.next == nullptr)
+        return equal && lhs.next == rhs.next;
+    return *lhs.next == *rhs.next;
 }
 
 void ChatMessage::loadLua(lua_State *state, const char *namespaceName) {
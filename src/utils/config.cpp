@@ -78,6 +78,7 @@ void Field<int>::load(const rapidjson::Document &document)
         return;
 
     value = loc->value.GetInt();
+    version++;
 }
 template <>
 void Field<int>::save(rapidjson::Document &document)
@@ -99,6 +100,7 @@ void Field<ChatMessage>::load(const rapidjson::Document &document)
 
     value = ChatMessage();
     value.load(loc->value);
+    version++;
 }
 template <>
 void Field<ChatMessage>::save(rapidjson::Document &document)
@@ -120,6 +122,7 @@ void Field<std::string>::load(const rapidjson::Document &document)
         return;
 
     value = std::string(loc->value.GetString(), loc->value.GetStringLength());
+    version++;
 }
 template <>
 void Field<std::string>::save(rapidjson::Document &document)
@@ -140,8 +143,11 @@ void Field<PNGFile>::load(const rapidjson::Document &document)
         return;
 
     std::string s = std::string(std::string(loc->value.GetString(), loc->value.GetStringLength()));
-    if (!s.empty())
-        value = PNGFile(s);
+    if (s.empty())
+        return;
+
+    value = PNGFile(s);
+    version++;
 }
 template <>
 void Field<PNGFile>::save(rapidjson::Document &document)
@@ -162,6 +168,7 @@ void Field<bool>::load(const rapidjson::Document &document)
         return;
 
     value = loc->value.GetBool();
+    version++;
 }
 template <>
 void Field<bool>::save(rapidjson::Document &document)
@@ -12,6 +12,7 @@
 #ifndef MINESERVER_CONFIG_H
 #define MINESERVER_CONFIG_H
 
+#include <atomic>
 #include <memory>
 #include <rapidjson/document.h>
 #include <types/chatmessage.h>
@@ -31,6 +32,7 @@ class Field
 {
 private:
     T value;
+    std::atomic<unsigned int> version{};
 
     inline rapidjson::Document::ConstMemberIterator canSafelyRead(const rapidjson::Document &document);
     inline void writeSafely(rapidjson::Document &document, rapidjson::Value &v);
@@ -96,6 +98,20 @@ public:
     void setValue(T v)
     {
         value = v;
+        version++;
+    }
+
+    /**
+     * @brief Get the Version of the field
+     *
+     * The version changes every time the value is
+     * loaded or set, so that values derived from
+     * the field know when to be computed again.
+     * @return unsigned int the version of the field
+     */
+    unsigned int getVersion() const
+    {
+        return version;
     }
 
     /**
@@ -211,6 +227,116 @@ public:
      * not be really any need to crank up that number.
      */
     Field<int> BACKLOG = Field("network", "backlog", 10);
+    /**
+     * @brief The number of network threads
+     *
+     * The number of threads multiplexing all of
+     * the client connections. Use 0 to have one
+     * thread per hardware thread.
+     */
+    Field<int> IO_THREADS = Field("network", "io_threads", 0);
+    /**
+     * @brief Whether to shard the listening socket
+     *
+     * Opens one listening socket per network thread
+     * using SO_REUSEPORT, each with its own accept
+     * queue, instead of a single one shared by all.
+     * Only supported on Linux.
+     */
+    Field<bool> REUSE_PORT = Field("network", "reuse_port", false);
+    /**
+     * @brief Delay before accepting silent connections
+     *
+     * The number of seconds a connection can stay
+     * without sending anything before being
+     * accepted, 0 to accept them right away.
+     * Only supported on Linux (TCP_DEFER_ACCEPT).
+     */
+    Field<int> DEFER_ACCEPT = Field("network", "defer_accept", 0);
+    /**
+     * @brief The send buffer limit of a connection
+     *
+     * The number of bytes that can wait to be sent
+     * to a single client, the client being kicked
+     * if it is too slow to take more.
+     */
+    Field<int> SEND_BUFFER_LIMIT = Field("network", "send_buffer_limit", 4194304);
+    /**
+     * @brief The number of compression workers
+     *
+     * The threads compressing the largest packets
+     * instead of the network threads, 0 to always
+     * compress on the network threads.
+     */
+    Field<int> COMPRESSION_WORKERS = Field("network", "compression_workers", 2);
+    /**
+     * @brief The size from which packets are compressed by the workers
+     *
+     * Packets at least this large are handed to the
+     * compression workers (COMPRESSION_WORKERS), the
+     * smaller ones are compressed right away.
+     */
+    Field<int> COMPRESSION_OFFLOAD_SIZE = Field("network", "compression_offload_size", 16384);
+    /**
+     * @brief The compression levels pinned per packet
+     *
+     * Comma separated list of `id:level`, with the
+     * hexadecimal ids of the packets. Level 0 means
+     * never compressed, the levels of the other
+     * packets are learnt from their statistics.
+     * Defaults to chunks at level 6 and entity
+     * movements never compressed.
+     */
+    Field<std::string> COMPRESSION_POLICIES = Field("network", "compression_policies", std::string("0x21:6,0x26:6,0x15:0,0x16:0,0x17:0,0x18:0"));
+    /**
+     * @brief The host of the session server
+     *
+     * The server asked whether players joined
+     * when in online mode (ONLINE_MODE), can
+     * be pointed at a local server for testing.
+     */
+    Field<std::string> SESSION_HOST = Field("session", "host", std::string("sessionserver.mojang.com"));
+    /**
+     * @brief The port of the session server
+     *
+     * The HTTPS port of the session server.
+     */
+    Field<int> SESSION_PORT = Field("session", "port", 443);
+    /**
+     * @brief The number of connections to the session server
+     *
+     * The number of players verified at the same
+     * time, each one using its own connection
+     * kept alive between verifications.
+     */
+    Field<int> SESSION_CONNECTIONS = Field("session", "connections", 4);
+    /**
+     * @brief The timeout of the session server
+     *
+     * The number of milliseconds to wait for the
+     * session server when connecting, sending or
+     * receiving before failing the login.
+     */
+    Field<int> SESSION_TIMEOUT = Field("session", "timeout", 5000);
+    /**
+     * @brief The time players stay verified, in seconds
+     *
+     * Players reconnecting from the same address
+     * within this time are not verified again by
+     * the session server, 0 disables it. Only used
+     * with prevent proxy connections, for the session
+     * server to have checked that address. Keep it
+     * short, a few seconds are enough for reconnects.
+     */
+    Field<int> SESSION_CACHE_TTL = Field("session", "cache_ttl", 0);
+    /**
+     * @brief The number of login cryptography workers
+     *
+     * Threads decrypting the encryption responses
+     * of the players logging in when in online mode,
+     * 0 to decrypt them on the network threads.
+     */
+    Field<int> LOGIN_CRYPTO_WORKERS = Field("session", "crypto_workers", 2);
     /**
      * @brief The Message of the Day
      *
@@ -225,6 +351,47 @@ public:
      * server.
      */
     Field<int> MAX_PLAYERS = Field("server", "max_players", 100);
+    /**
+     * @brief The Key File
+     *
+     * The PEM file the RSA keypair is loaded from,
+     * saved to it when it does not exist. Empty
+     * to generate a new keypair on every start.
+     */
+    Field<std::string> KEY_FILE = Field("server", "key_file", std::string(""));
+    /**
+     * @brief The Plugin Timeout
+     *
+     * The milliseconds a thread firing an event
+     * that plugins can change waits for each
+     * plugin to handle it, skipping or stopping
+     * its handler after.
+     */
+    Field<int> PLUGIN_TIMEOUT = Field("plugins", "timeout", 100);
+    /**
+     * @brief The Plugin Instructions Budget
+     *
+     * The max number of lua instructions a plugin
+     * runs handling a single event before it is
+     * stopped, 0 for no limit.
+     */
+    Field<int> PLUGIN_BUDGET = Field("plugins", "instruction_budget", 100000000);
+    /**
+     * @brief The Plugin Slow Handler Threshold
+     *
+     * The milliseconds past which a plugin handling
+     * an event is logged with its lua stack, 0 to
+     * never log.
+     */
+    Field<int> PLUGIN_SLOW_HANDLER = Field("plugins", "slow_handler", 50);
+    /**
+     * @brief The Plugin Bytecode Cache
+     *
+     * Whether the compiled plugins are cached
+     * in the .cache folder of the plugins, until
+     * their source changes.
+     */
+    Field<bool> PLUGIN_BYTECODE_CACHE = Field("plugins", "bytecode_cache", true);
     /**
      * @brief The Log Level
      *
@@ -232,6 +399,14 @@ public:
      * should use.
      */
     Field<std::string> LOGLEVEL = Field("other", "loglevel", std::string("ALL"));
+    /**
+     * @brief Asynchronous events
+     *
+     * Whether deferrable events, like the console
+     * prompt reprinted after every log, are queued
+     * and delivered in batches on their own thread.
+     */
+    Field<bool> ASYNC_EVENTS = Field("other", "async_events", false);
     /**
      * @brief The Icon File
      *
@@ -248,7 +423,11 @@ public:
  * on all of the fields by defining the UF(x) macro.
  */
 #define CONFIG_FIELDS UF(PORT) UF(MOTD) UF(LOGLEVEL) UF(COMPRESSION_LVL) UF(ONLINE_MODE) UF(ADDRESS) \
-    UF(BACKLOG) UF(MAX_PLAYERS) UF(ICON_FILE) UF(PREVENT_PROXY_CONNECTIONS) UF(COMPRESSION_THRESHOLD)
+    UF(BACKLOG) UF(MAX_PLAYERS) UF(ICON_FILE) UF(PREVENT_PROXY_CONNECTIONS) UF(COMPRESSION_THRESHOLD) \
+    UF(IO_THREADS) UF(REUSE_PORT) UF(DEFER_ACCEPT) UF(SESSION_HOST) UF(SESSION_PORT) UF(SESSION_CONNECTIONS) \
+    UF(SESSION_TIMEOUT) UF(SEND_BUFFER_LIMIT) UF(COMPRESSION_WORKERS) UF(COMPRESSION_OFFLOAD_SIZE) \
+    UF(COMPRESSION_POLICIES) UF(KEY_FILE) UF(LOGIN_CRYPTO_WORKERS) UF(SESSION_CACHE_TTL) UF(ASYNC_EVENTS) \
+    UF(PLUGIN_TIMEOUT) UF(PLUGIN_BUDGET) UF(PLUGIN_SLOW_HANDLER) UF(PLUGIN_BYTECODE_CACHE)
 
 /**
  * @brief The Version Number
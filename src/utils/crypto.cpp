@@ -12,6 +12,11 @@
 #include "crypto.h"
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <openssl/pem.h>
 #include <openssl/rand.h>
 #include <openssl/x509.h>
 #include <openssl/md5.h>
@@ -23,30 +28,134 @@
  *
  */
 static EVP_PKEY *keypair;
+/**
+ * @brief The public key of the keypair in DER format
+ *
+ */
+static std::vector<std::byte> publicKey;
+/**
+ * @brief The time spent in the last init, in milliseconds
+ *
+ */
+static double initTime = 0;
+/**
+ * @brief Incremented on every init, invalidates the contexts of the threads
+ *
+ */
+static std::atomic<std::uint64_t> keyGeneration(0);
+
+/**
+ * @brief Generates a new RSA keypair
+ *
+ * @return EVP_PKEY* the keypair, nullptr on failure
+ */
+static EVP_PKEY *generateKeypair()
+{
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, nullptr);
+    if (!ctx || EVP_PKEY_keygen_init(ctx) <= 0)
+    {
+        EVP_PKEY_CTX_free(ctx);
+        return nullptr;
+    }
+
+    EVP_PKEY *key = nullptr;
+    EVP_PKEY_CTX_set_rsa_keygen_bits(ctx, crypto::RSA_KEY_LENGTH);
+    if (EVP_PKEY_keygen(ctx, &key) <= 0)
+        key = nullptr;
+
+    EVP_PKEY_CTX_free(ctx);
+    return key;
+}
+
+/**
+ * @brief Loads an RSA keypair from a PEM file
+ *
+ * @param path the path of the file
+ * @return EVP_PKEY* the keypair, nullptr if it is not a valid RSA private key
+ */
+static EVP_PKEY *loadKeypair(const std::string &path)
+{
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return nullptr;
+
+    EVP_PKEY *key = PEM_read_PrivateKey(file, nullptr, nullptr, nullptr);
+    std::fclose(file);
+
+    if (key && EVP_PKEY_base_id(key) != EVP_PKEY_RSA)
+    {
+        EVP_PKEY_free(key);
+        return nullptr;
+    }
+    return key;
+}
+
+/**
+ * @brief Saves an RSA keypair to a PEM file
+ *
+ * The file is only readable by its owner.
+ * @param key the keypair
+ * @param path the path of the file
+ * @return true the keypair was saved
+ * @return false the file could not be written
+ */
+static bool saveKeypair(EVP_PKEY *key, const std::string &path)
+{
+    FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    std::error_code error;
+    std::filesystem::permissions(path, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write, error);
 
-bool crypto::init()
+    bool saved = PEM_write_PrivateKey(file, key, nullptr, nullptr, 0, nullptr, nullptr) == 1;
+    return std::fclose(file) == 0 && saved && !error;
+}
+
+bool crypto::init(const std::string &keyFile)
 {
+    auto start = std::chrono::steady_clock::now();
+
     OpenSSL_add_all_algorithms();
     OpenSSL_add_all_ciphers();
     OpenSSL_add_all_digests();
 
-    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, nullptr);
-    if (!ctx || !EVP_PKEY_keygen_init(ctx))
+    // An invalid key file fails instead of being overwritten
+    if (!keyFile.empty() && std::filesystem::exists(keyFile))
+        keypair = loadKeypair(keyFile);
+    else
     {
-        EVP_PKEY_CTX_free(ctx);
-        return false;
+        keypair = generateKeypair();
+        if (keypair && !keyFile.empty() && !saveKeypair(keypair, keyFile))
+        {
+            cleanup();
+            return false;
+        }
     }
 
-    EVP_PKEY_CTX_set_rsa_keygen_bits(ctx, RSA_KEY_LENGTH);
-    EVP_PKEY_keygen(ctx, &keypair);
+    if (!keypair)
+        return false;
+    keyGeneration++;
 
-    EVP_PKEY_CTX_free(ctx);
+    unsigned char *buff = nullptr;
+    int len = i2d_PUBKEY(keypair, &buff);
+    if (len <= 0)
+    {
+        cleanup();
+        return false;
+    }
+    publicKey.assign((std::byte *)buff, (std::byte *)buff + len);
+    OPENSSL_free(buff);
+
+    initTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
     return true;
 }
 
 void crypto::cleanup()
 {
     EVP_PKEY_free(keypair);
+    keypair = nullptr;
+    publicKey.clear();
 }
 
 std::unique_ptr<std::byte[]> crypto::rsaEncrypt(const std::byte *data, size_t len, size_t *outLen)
@@ -75,43 +184,87 @@ std::unique_ptr<std::byte[]> crypto::rsaEncrypt(const std::byte *data, size_t le
     return std::unique_ptr<std::byte[]>(out);
 }
 
-std::unique_ptr<std::byte[]> crypto::rsaDecrypt(const std::byte *data, size_t len, size_t *outLen)
+/**
+ * @brief Decryption context of the current thread
+ *
+ * Initializing a context costs about as much as
+ * a decryption, so each thread keeps its own
+ * until the keypair changes.
+ */
+struct DecryptContext
 {
-    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new(keypair, nullptr);
-    if (!ctx || !EVP_PKEY_decrypt_init(ctx) || !EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING))
+    /**
+     * @brief The context, nullptr if it could not be initialized
+     *
+     */
+    EVP_PKEY_CTX *ctx = nullptr;
+    /**
+     * @brief The key generation the context was initialized for
+     *
+     */
+    std::uint64_t generation = 0;
+
+    /**
+     * @brief Destroy the Decrypt Context object
+     *
+     */
+    ~DecryptContext()
     {
         EVP_PKEY_CTX_free(ctx);
-        *outLen = 0;
-        return {};
     }
 
-    if (!EVP_PKEY_decrypt(ctx, nullptr, outLen, (const unsigned char *)data, len))
+    /**
+     * @brief Gets the context for the current keypair
+     *
+     * @return EVP_PKEY_CTX* the context, nullptr on failure
+     */
+    EVP_PKEY_CTX *get()
     {
+        std::uint64_t current = keyGeneration;
+        if (ctx && generation == current)
+            return ctx;
+
         EVP_PKEY_CTX_free(ctx);
-        return {};
+        generation = current;
+        ctx = EVP_PKEY_CTX_new(keypair, nullptr);
+        if (ctx && (EVP_PKEY_decrypt_init(ctx) <= 0 || EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING) <= 0))
+        {
+            EVP_PKEY_CTX_free(ctx);
+            ctx = nullptr;
+        }
+        return ctx;
     }
+};
 
-    auto *out = new std::byte[*outLen];
-    if (!EVP_PKEY_decrypt(ctx, (unsigned char *)out, outLen, (const unsigned char *)data, len))
-    {
-        EVP_PKEY_CTX_free(ctx);
+std::unique_ptr<std::byte[]> crypto::rsaDecrypt(const std::byte *data, size_t len, size_t *outLen)
+{
+    thread_local DecryptContext context;
+
+    *outLen = 0;
+    EVP_PKEY_CTX *ctx = context.get();
+    if (!ctx)
         return {};
-    }
 
-    return std::unique_ptr<std::byte[]>(out);
+    size_t size;
+    if (EVP_PKEY_decrypt(ctx, nullptr, &size, (const unsigned char *)data, len) <= 0)
+        return {};
+
+    std::unique_ptr<std::byte[]> out(new std::byte[size]);
+    if (EVP_PKEY_decrypt(ctx, (unsigned char *)out.get(), &size, (const unsigned char *)data, len) <= 0)
+        return {};
+
+    *outLen = size;
+    return out;
 }
 
-std::unique_ptr<std::byte[]> crypto::getPublicRSAKey(int *outLen)
+std::span<const std::byte> crypto::getPublicRSAKey()
 {
-    unsigned char *buff = nullptr;
-    int len = i2d_PUBKEY(keypair, &buff);
-
-    auto *out = new std::byte[len];
-    std::memcpy(out, buff, len);
+    return publicKey;
+}
 
-    *outLen = len;
-    OPENSSL_free(buff);
-    return std::unique_ptr<std::byte[]>(out);
+double crypto::getInitTime()
+{
+    return initTime;
 }
 
 std::unique_ptr<std::byte[]> crypto::randomSecure(size_t len)
@@ -144,7 +297,7 @@ std::string crypto::md5Digest(const std::string &data)
 crypto::MinecraftHash::MinecraftHash()
 {
     ctx = EVP_MD_CTX_new();
-    EVP_DigestInit(ctx, EVP_sha1());
+    EVP_DigestInit_ex(ctx, EVP_sha1(), nullptr);
 }
 
 crypto::MinecraftHash::~MinecraftHash()
@@ -157,47 +310,76 @@ void crypto::MinecraftHash::update(const std::string &s)
     EVP_DigestUpdate(ctx, s.c_str(), s.size());
 }
 
+void crypto::MinecraftHash::update(std::span<const std::byte> data)
+{
+    EVP_DigestUpdate(ctx, data.data(), data.size());
+}
+
 std::string crypto::MinecraftHash::finalize()
 {
     unsigned char data[EVP_MAX_MD_SIZE];
     unsigned int size;
-    if (!EVP_DigestFinal(ctx, data, &size))
+    if (!EVP_DigestFinal_ex(ctx, data, &size))
         return "";
 
-    std::string result;
-    BIGNUM *bn = BN_bin2bn(data, size, nullptr);
+    EVP_DigestInit_ex(ctx, EVP_sha1(), nullptr); // so it is reusable
+    return formatDigest(data, size);
+}
+
+std::string crypto::MinecraftHash::formatDigest(const unsigned char *digest, std::size_t len)
+{
+    static constexpr char HEX[] = "0123456789abcdef";
+
+    // Digest is a big endian two's complement integer
+    unsigned char value[EVP_MAX_MD_SIZE];
+    len = std::min<std::size_t>(len, sizeof(value));
+    std::memcpy(value, digest, len);
 
-    if (BN_is_bit_set(bn, 159))
+    std::string result;
+    result.reserve(len * 2 + 1);
+    if (len > 0 && value[0] & 0x80)
     {
         result += '-';
 
-        auto tmp = std::vector<unsigned char>(BN_num_bytes(bn));
-        BN_bn2bin(bn, tmp.data());
-        std::transform(tmp.begin(), tmp.end(), tmp.begin(), [](unsigned char b)
-                       { return ~b; });
-        BN_bin2bn(tmp.data(), tmp.size(), bn);
-
-        BN_add_word(bn, 1);
+        // Negates it, inverting then adding one from the last byte
+        unsigned int carry = 1;
+        for (std::size_t i = len; i-- > 0;)
+        {
+            unsigned int byte = (unsigned char)~value[i] + carry;
+            value[i] = (unsigned char)byte;
+            carry = byte >> 8;
+        }
     }
 
-    char *hex = BN_bn2hex(bn);
-
-    auto view = std::string_view(hex);
-    while (!view.empty() && view[0] == '0')
-        view = view.substr(1);
-
-    result.append(view.begin(), view.end());
-    OPENSSL_free(hex);
-    BN_free(bn);
-
-    std::transform(result.begin(), result.end(), result.begin(),
-                   [](unsigned char c)
-                   { return std::tolower(c); });
+    std::size_t start = result.size();
+    for (std::size_t i = 0; i < len; i++)
+    {
+        result += HEX[value[i] >> 4];
+        result += HEX[value[i] & 0x0F];
+    }
 
-    EVP_DigestInit(ctx, EVP_sha1()); // so it is reusable
+    // Leading zeros are trimmed, the value itself is kept
+    std::size_t first = result.find_first_not_of('0', start);
+    if (first == std::string::npos)
+        first = result.size() - 1;
+    result.erase(start, first - start);
     return result;
 }
 
+/**
+ * @brief Number of bytes decrypted per bulk AES/ECB call
+ *
+ * Each of them needs a whole block, so 4 KB of
+ * blocks : enough to fill the AES-NI pipeline while
+ * staying in the L1 cache.
+ */
+constexpr size_t DECRYPT_CHUNK = 256;
+/**
+ * @brief Max length given to OpenSSL at once, its lengths being ints
+ *
+ */
+constexpr size_t MAX_UPDATE = 1 << 30;
+
 crypto::AES128CFB8Cipher::AES128CFB8Cipher(CipherState state, const std::byte *key, const std::byte *iv) : state(state)
 {
     ctx = EVP_CIPHER_CTX_new();
@@ -206,7 +388,14 @@ crypto::AES128CFB8Cipher::AES128CFB8Cipher(CipherState state, const std::byte *k
     if (state == crypto::CipherState::ENCRYPT)
         EVP_EncryptInit(ctx, EVP_aes_128_cfb8(), (const unsigned char *)key, (const unsigned char *)iv);
     else if (state == crypto::CipherState::DECRYPT)
-        EVP_DecryptInit(ctx, EVP_aes_128_cfb8(), (const unsigned char *)key, (const unsigned char *)iv);
+    {
+        // CFB8 decryption only ever encrypts blocks, see decrypt()
+        EVP_EncryptInit(ctx, EVP_aes_128_ecb(), (const unsigned char *)key, nullptr);
+        EVP_CIPHER_CTX_set_padding(ctx, 0);
+        std::memcpy(shift, iv, sizeof(shift));
+        blocks.resize(DECRYPT_CHUNK * sizeof(shift));
+        keystream.resize(DECRYPT_CHUNK * sizeof(shift));
+    }
 }
 
 crypto::AES128CFB8Cipher::~AES128CFB8Cipher()
@@ -214,24 +403,73 @@ crypto::AES128CFB8Cipher::~AES128CFB8Cipher()
     EVP_CIPHER_CTX_free(ctx);
 }
 
+void crypto::AES128CFB8Cipher::decrypt(const std::byte *data, size_t len, std::byte *out)
+{
+    // The shift register followed by the ciphertext, byte i
+    // is decrypted with the block starting at i
+    unsigned char window[sizeof(shift) + DECRYPT_CHUNK];
+    std::memcpy(window, shift, sizeof(shift));
+
+    while (len > 0)
+    {
+        size_t chunk = std::min(len, DECRYPT_CHUNK);
+        std::memcpy(window + sizeof(shift), data, chunk);
+
+        for (size_t i = 0; i < chunk; i++)
+            std::memcpy(blocks.data() + i * sizeof(shift), window + i, sizeof(shift));
+
+        int outLen = 0;
+        EVP_EncryptUpdate(ctx, keystream.data(), &outLen, blocks.data(), static_cast<int>(chunk * sizeof(shift)));
+
+        for (size_t i = 0; i < chunk; i++)
+            out[i] = std::byte(window[sizeof(shift) + i] ^ keystream[i * sizeof(shift)]);
+
+        std::memmove(window, window + chunk, sizeof(shift));
+        data += chunk;
+        out += chunk;
+        len -= chunk;
+    }
+
+    std::memcpy(shift, window, sizeof(shift));
+}
+
 int crypto::AES128CFB8Cipher::update(const std::byte *data, size_t len, std::byte *out)
 {
-    int outLen = 0;
-    if (state == crypto::CipherState::ENCRYPT)
-        EVP_EncryptUpdate(ctx, (unsigned char *)out, &outLen, (const unsigned char *)data, len);
-    else if (state == crypto::CipherState::DECRYPT)
-        EVP_DecryptUpdate(ctx, (unsigned char *)out, &outLen, (const unsigned char *)data, len);
+    if (state == crypto::CipherState::DECRYPT)
+    {
+        decrypt(data, len, out);
+        return static_cast<int>(len);
+    }
 
-    return outLen;
+    int written = 0;
+    while (len > 0)
+    {
+        int chunk = static_cast<int>(std::min(len, MAX_UPDATE));
+        int outLen = 0;
+        EVP_EncryptUpdate(ctx, (unsigned char *)out, &outLen, (const unsigned char *)data, chunk);
+
+        data += chunk;
+        out += outLen;
+        written += outLen;
+        len -= chunk;
+    }
+
+    return written;
+}
+
+void crypto::AES128CFB8Cipher::update(std::byte *data, size_t len)
+{
+    update(data, len, data);
 }
 
 int crypto::AES128CFB8Cipher::finalize(std::byte *out)
 {
+    // Nothing is ever held back by CFB8 decryption
+    if (state == crypto::CipherState::DECRYPT)
+        return 0;
+
     int outLen = 0;
-    if (state == crypto::CipherState::ENCRYPT)
-        EVP_EncryptFinal_ex(ctx, (unsigned char *)out, &outLen);
-    else if (state == crypto::CipherState::DECRYPT)
-        EVP_DecryptFinal_ex(ctx, (unsigned char *)out, &outLen);
+    EVP_EncryptFinal_ex(ctx, (unsigned char *)out, &outLen);
     return outLen;
 }
 
@@ -246,78 +484,76 @@ size_t crypto::AES128CFB8Cipher::calculateBufferSize(size_t len)
     return 0;
 }
 
-crypto::ZLibCompressor::ZLibCompressor(int level) : compressionLevel(level)
+void crypto::ZLibCompressor::DeflateDeleter::operator()(z_stream *stream) const
 {
+    deflateEnd(stream);
+    delete stream;
 }
 
-int crypto::ZLibCompressor::compress(const std::byte *data, size_t len, std::byte *out, size_t outLen)
+void crypto::ZLibCompressor::InflateDeleter::operator()(z_stream *stream) const
 {
-    z_stream stream;
-    stream.zalloc = Z_NULL;
-    stream.zfree = Z_NULL;
-    stream.opaque = Z_NULL;
-
-    if (deflateInit(&stream, compressionLevel) != Z_OK)
-        throw std::runtime_error("Failed to initialize ZLib");
+    inflateEnd(stream);
+    delete stream;
+}
 
-    stream.avail_in = len;
-    stream.next_in = (Bytef *)data;
-    stream.avail_out = outLen;
-    stream.next_out = (Bytef *)out;
+crypto::ZLibCompressor::ZLibCompressor(int level) : compressionLevel(level), deflater(), inflater()
+{
+}
 
-    do
-    {
-        int result = deflate(&stream, Z_SYNC_FLUSH);
-        if (result == Z_STREAM_ERROR)
-        {
-            deflateEnd(&stream);
-            throw std::runtime_error("ZLib compress error");
-        }
-    } while (stream.avail_out == 0);
+size_t crypto::ZLibCompressor::compressBound(size_t len)
+{
+    return ::compressBound(len);
+}
 
-    while (true)
+int crypto::ZLibCompressor::compress(const std::byte *data, size_t len, std::byte *out, size_t outLen)
+{
+    if (!deflater)
     {
-        int result = deflate(&stream, Z_FINISH);
-        if (result == Z_STREAM_ERROR)
+        auto *stream = new z_stream();
+        if (deflateInit(stream, compressionLevel) != Z_OK)
         {
-            deflateEnd(&stream);
-            throw std::runtime_error("ZLib compress finish error");
+            delete stream;
+            throw std::runtime_error("Failed to initialize ZLib");
         }
-        if (result == Z_STREAM_END)
-            break;
+        deflater.reset(stream);
     }
+    else if (deflateReset(deflater.get()) != Z_OK)
+        throw std::runtime_error("Failed to reset ZLib");
+
+    deflater->avail_in = len;
+    deflater->next_in = (Bytef *)data;
+    deflater->avail_out = outLen;
+    deflater->next_out = (Bytef *)out;
 
-    (void)deflateEnd(&stream);
+    // Everything is there, a single call compresses it all
+    if (deflate(deflater.get(), Z_FINISH) != Z_STREAM_END)
+        throw std::runtime_error("ZLib compress error");
 
-    return stream.total_out;
+    return deflater->total_out;
 }
 
 int crypto::ZLibCompressor::uncompress(const std::byte *data, size_t len, std::byte *out, size_t outLen)
 {
-    z_stream stream;
-    stream.zalloc = Z_NULL;
-    stream.zfree = Z_NULL;
-    stream.opaque = Z_NULL;
-
-    if (inflateInit(&stream) != Z_OK)
-        throw std::runtime_error("Failed to initialize ZLib");
-
-    stream.avail_in = len;
-    stream.next_in = (Bytef *)data;
-    stream.avail_out = outLen;
-    stream.next_out = (Bytef *)out;
-
-    do
+    if (!inflater)
     {
-        int res = inflate(&stream, Z_NO_FLUSH);
-        if (res == Z_STREAM_ERROR)
+        auto *stream = new z_stream();
+        if (inflateInit(stream) != Z_OK)
         {
-            inflateEnd(&stream);
-            throw std::runtime_error("ZLib uncompress error");
+            delete stream;
+            throw std::runtime_error("Failed to initialize ZLib");
         }
-    } while (stream.avail_in != 0);
+        inflater.reset(stream);
+    }
+    else if (inflateReset(inflater.get()) != Z_OK)
+        throw std::runtime_error("Failed to reset ZLib");
 
-    inflateEnd(&stream);
+    inflater->avail_in = len;
+    inflater->next_in = (Bytef *)data;
+    inflater->avail_out = outLen;
+    inflater->next_out = (Bytef *)out;
 
-    return stream.total_out;
-}
\ No newline at end of file
+    if (inflate(inflater.get(), Z_FINISH) != Z_STREAM_END)
+        throw std::runtime_error("ZLib uncompress error");
+
+    return inflater->total_out;
+}
@@ -15,6 +15,8 @@
 #include <memory>
 #include <string>
 #include <cstddef>
+#include <span>
+#include <vector>
 #include <openssl/rsa.h>
 #include <openssl/evp.h>
 #include <zlib.h>
@@ -39,12 +41,16 @@ namespace crypto
     /**
      * @brief Inits Crypto
      *
-     * Inits OpenSSL and generates an RSA Keypair
-     * to be used in encryption.
+     * Inits OpenSSL and gets an RSA Keypair to be
+     * used in encryption. The keypair is loaded from
+     * @p keyFile if it exists, otherwise it is generated
+     * and saved to it, generating is the slow part of
+     * starting up.
+     * @param keyFile the PEM file of the keypair, empty to always generate a new one
      * @return true Init went correctly
      * @return false Something went wrong
      */
-    bool init();
+    bool init(const std::string &keyFile = "");
     /**
      * @brief Cleanups Crypto
      *
@@ -85,14 +91,21 @@ namespace crypto
     /**
      * @brief Get the Public RSA Public Key
      *
-     * Formats the public key from the startup keypair
-     * into DER format, which is an underlying ASN.1
-     * format defined by x.509
+     * The public key from the startup keypair
+     * in DER format, which is an underlying ASN.1
+     * format defined by x.509. It is formatted once
+     * in crypto::init() and does not change until
+     * crypto::cleanup().
      *
-     *@param outLen a pointer to a variable that will hold the length of the key returned
-     *@return std::byte * The public key formatted
+     *@return std::span<const std::byte> The public key formatted
      */
-    std::unique_ptr<std::byte[]> getPublicRSAKey(int *outLen);
+    std::span<const std::byte> getPublicRSAKey();
+    /**
+     * @brief Get the time spent in crypto::init()
+     *
+     * @return double the time in milliseconds
+     */
+    double getInitTime();
 
     /**
      * @brief Generates randoms bytes securely
@@ -152,6 +165,13 @@ namespace crypto
          * @param s the data to update the buffer with
          */
         void update(const std::string &s);
+        /**
+         * @brief Updates the hash
+         *
+         * Updates the SHA-1 hash with @p data
+         * @param data the data to update the buffer with
+         */
+        void update(std::span<const std::byte> data);
         /**
          * @brief Finalizes the hash
          *
@@ -160,6 +180,18 @@ namespace crypto
          * @return std::string the minecraft hash
          */
         std::string finalize();
+
+        /**
+         * @brief Formats a digest the Minecraft way
+         *
+         * The digest is read as a signed big endian integer
+         * and written in lowercase hexadecimal, with a minus
+         * sign and without leading zeros.
+         * @param digest the digest bytes
+         * @param len the length of @p digest
+         * @return std::string the formatted digest
+         */
+        static std::string formatDigest(const unsigned char *digest, std::size_t len);
     };
 
     /**
@@ -200,12 +232,24 @@ namespace crypto
      * Joking, the name should be changed if someone
      * finds something better. Naming things in
      * programming is too hard.
+     *
+     * Decryption does not go through OpenSSL's CFB8 mode,
+     * which runs one AES block at a time : the inputs of
+     * the block cipher are all known from the ciphertext,
+     * so they are encrypted in bulk with AES/ECB, letting
+     * AES-NI pipeline them. Encryption depends on its own
+     * output and stays sequential.
      */
     class AES128CFB8Cipher
     {
     private:
         EVP_CIPHER_CTX *ctx;
         const CipherState state;
+        unsigned char shift[16];
+        std::vector<unsigned char> blocks;
+        std::vector<unsigned char> keystream;
+
+        void decrypt(const std::byte *data, size_t len, std::byte *out);
 
     public:
         /**
@@ -240,6 +284,17 @@ namespace crypto
          * @return int the length of the buffer
          */
         int update(const std::byte *data, size_t len, std::byte *out);
+        /**
+         * @brief Updates in place, encrypting or decrypting depending on the state
+         *
+         * CFB8 being a stream mode, the output is as long
+         * as the input and no buffer is needed. Prefer
+         * calling it once over whole frames rather than
+         * byte by byte, each call having a fixed cost.
+         * @param data the data to encrypt / decrypt
+         * @param len the length of the data
+         */
+        void update(std::byte *data, size_t len);
         /**
          * @brief Finalizes cipher, encrypting / decrypting the rest of the bytes
          *
@@ -266,11 +321,27 @@ namespace crypto
      * Compressor class that wraps
      * around zlib for compression
      * or decompression.
+     *
+     * The zlib states are a few hundred kilobytes each, so
+     * they are only created on first use then kept, and
+     * reset between calls. A compressor is meant to be
+     * owned by a single connection.
      */
     class ZLibCompressor
     {
     private:
+        struct DeflateDeleter
+        {
+            void operator()(z_stream *stream) const;
+        };
+        struct InflateDeleter
+        {
+            void operator()(z_stream *stream) const;
+        };
+
         int compressionLevel;
+        std::unique_ptr<z_stream, DeflateDeleter> deflater;
+        std::unique_ptr<z_stream, InflateDeleter> inflater;
 
     public:
         /**
@@ -288,6 +359,25 @@ namespace crypto
          *
          */
         ~ZLibCompressor() = default;
+        /**
+         * @brief Move constructor
+         *
+         */
+        ZLibCompressor(ZLibCompressor &&) = default;
+        /**
+         * @brief Move assignment
+         *
+         * @return ZLibCompressor& this
+         */
+        ZLibCompressor &operator=(ZLibCompressor &&) = default;
+
+        /**
+         * @brief Max compressed length of data
+         *
+         * @param len the length of the data to compress
+         * @return size_t the length of the buffer to give to ZLibCompressor::compress()
+         */
+        static size_t compressBound(size_t len);
 
         /**
          * @brief Compresses data (deflate)
@@ -298,7 +388,7 @@ namespace crypto
          * written data.
          * @param data the data to compress
          * @param len the length of @p data
-         * @param out the output buffer, should be of length @p len if you want no risks
+         * @param out the output buffer, at least ZLibCompressor::compressBound() long
          * @param outLen the output buffer length
          * @return int the written length
          */
@@ -313,6 +403,8 @@ namespace crypto
          * written data.
          * The @p out buffer needs to be
          * of the length of the uncompressed data.
+         * Invalid data, or data that does not fit
+         * in @p out, throws a std::runtime_error.
          *
          * @warning Uncompress length need to be known
          *
@@ -50,6 +50,11 @@ void logger::loadConfig()
 #endif // DOXYGEN_IGNORE_THIS
 }
 
+void logger::setLevel(LogLevel level)
+{
+    LOGLEVEL = level;
+}
+
 /**
  * @brief Mappings for loglevel enum
  *
@@ -131,14 +136,17 @@ std::string replaceMinecraftEscapes(const std::string &s)
  * @brief Logs a format and its args at a certain level
  *
  * @param level the level to log to
- * @param format the format of the log
+ * @param rawFormat the format of the log
  * @param args the arguments of the log
  */
-void logAtLevel(LogLevel level, std::string format, va_list args)
+void logAtLevel(LogLevel level, const char *rawFormat, va_list args)
 {
+    // Filtered out logs must stay cheap, nothing is built before this
     if (level < LOGLEVEL)
         return;
 
+    std::string format = rawFormat;
+
     const std::pair<std::string, std::string> &levelInfo = LEVELS.at(level);
     std::string levelString = levelInfo.first;
     std::string color = levelInfo.second;
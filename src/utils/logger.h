@@ -161,6 +161,14 @@ namespace logger
      * was loaded, which is in Config::load().
      */
     void loadConfig();
+    /**
+     * @brief Sets the loglevel
+     *
+     * Sets the loglevel without any config,
+     * for the tools running next to the server.
+     * @param level the minimum level to log
+     */
+    void setLevel(LogLevel level);
 
     /**
      * @brief Logs something at the ::DEBUG level
@@ -247,6 +255,17 @@ namespace logger
      */
     class PostPrintEvent : public IEvent<PostPrintEvent>
     {
+    public:
+        /**
+         * @brief Only reprints the console prompt
+         *
+         */
+        static constexpr bool DEFERRABLE = true;
+        /**
+         * @brief A single reprint after many lines is enough
+         *
+         */
+        static constexpr bool COALESCED = true;
     };
 }
 
@@ -0,0 +1,56 @@
+/**
+ * @file metrics.cpp
+ * @author Lygaen
+ * @brief The file containing the runtime metrics logic
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "metrics.h"
+#include <stdexcept>
+
+MetricsManager *MetricsManager::instance = nullptr;
+MetricsManager::MetricsManager() : sourcesLock(), sources()
+{
+    if (instance)
+        throw std::runtime_error("Metrics manager should not be constructed twice");
+
+    instance = this;
+}
+
+MetricsManager::~MetricsManager()
+{
+    if (instance == this)
+        instance = nullptr;
+}
+
+void MetricsManager::add(const std::string &name, Source source)
+{
+    std::lock_guard<std::mutex> guard(sourcesLock);
+    sources[name] = std::move(source);
+}
+
+void MetricsManager::remove(const std::string &prefix)
+{
+    std::lock_guard<std::mutex> guard(sourcesLock);
+    auto it = sources.lower_bound(prefix);
+    while (it != sources.end() && it->first.compare(0, prefix.size(), prefix) == 0)
+        it = sources.erase(it);
+}
+
+std::map<std::string, double> MetricsManager::collect(const std::string &prefix)
+{
+    std::map<std::string, double> values;
+
+    std::lock_guard<std::mutex> guard(sourcesLock);
+    for (auto it = sources.lower_bound(prefix);
+         it != sources.end() && it->first.compare(0, prefix.size(), prefix) == 0; it++)
+    {
+        values[it->first] = it->second();
+    }
+
+    return values;
+}
@@ -0,0 +1,94 @@
+/**
+ * @file metrics.h
+ * @author Lygaen
+ * @brief The file containing the runtime metrics logic
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef MINESERVER_METRICS_H
+#define MINESERVER_METRICS_H
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief Metrics Manager
+ *
+ * Registry of named runtime metrics (counters,
+ * rates, queue depths...). Metrics are not
+ * stored here, components register a source that
+ * samples their own counters when the metrics
+ * are collected (eg. with the /stats command).
+ * Names are dot-separated, such as `net.shard0.accepted`.
+ */
+class MetricsManager
+{
+public:
+    /**
+     * @brief Source of a metric
+     *
+     * Called on each collection, must be thread-safe.
+     */
+    typedef std::function<double()> Source;
+
+private:
+    std::mutex sourcesLock;
+    std::map<std::string, Source> sources;
+
+    static MetricsManager *instance;
+
+public:
+    /**
+     * @brief Construct a new Metrics Manager object
+     *
+     */
+    MetricsManager();
+    /**
+     * @brief Destroy the Metrics Manager object
+     *
+     */
+    ~MetricsManager();
+
+    /**
+     * @brief Registers a metric
+     *
+     * Replaces the previous source if a metric
+     * was already registered under that @p name.
+     * @param name the name of the metric
+     * @param source the source sampling the metric
+     */
+    void add(const std::string &name, Source source);
+    /**
+     * @brief Unregisters every metric starting with @p prefix
+     *
+     * Must be called by the components before their
+     * counters are destroyed.
+     * @param prefix the prefix of the names to remove
+     */
+    void remove(const std::string &prefix);
+    /**
+     * @brief Samples the metrics
+     *
+     * @param prefix only sample the metrics starting with it
+     * @return std::map<std::string, double> the sampled values, key for metric name
+     */
+    std::map<std::string, double> collect(const std::string &prefix = "");
+
+    /**
+     * @brief Gets Metrics Manager instance
+     *
+     * @return MetricsManager& the instance
+     */
+    static MetricsManager &inst()
+    {
+        return *instance;
+    }
+};
+
+#endif // MINESERVER_METRICS_H
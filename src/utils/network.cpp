@@ -12,9 +12,6 @@
 #include "network.h"
 #include <cstring>
 #include <stdexcept>
-#include <openssl/ssl.h>
-#include <openssl/err.h>
-#include <rapidjson/document.h>
 #ifdef _WIN32
 #include <basetsd.h>
 #include <WinSock2.h>
@@ -25,7 +22,9 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <netinet/ip.h>
+#include <netinet/tcp.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #endif // __linux__
 
 ServerSocket::ServerSocket() = default;
@@ -70,11 +69,55 @@ void ServerSocket::start(unsigned int backlog) const
     listen(sock, backlog);
 }
 
+bool ServerSocket::setReusePort() const
+{
+#if defined(__linux__)
+    int enable = 1;
+    return setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) == 0;
+#elif defined(_WIN32)
+    // SO_REUSEADDR on windows does not balance connections, only lets sockets steal the port
+    return false;
+#endif
+}
+
+bool ServerSocket::setDeferAccept(int seconds) const
+{
+#if defined(__linux__)
+    return setsockopt(sock, IPPROTO_TCP, TCP_DEFER_ACCEPT, &seconds, sizeof(seconds)) == 0;
+#elif defined(_WIN32)
+    (void)seconds;
+    return false;
+#endif
+}
+
+bool ServerSocket::getAcceptQueue(unsigned int &pending, unsigned int &backlog) const
+{
+#if defined(__linux__)
+    struct tcp_info info{};
+    socklen_t len = sizeof(info);
+    if (getsockopt(sock, IPPROTO_TCP, TCP_INFO, &info, &len) != 0)
+        return false;
+
+    // For listening sockets, the kernel reports the accept queue in those fields
+    pending = info.tcpi_unacked;
+    backlog = info.tcpi_sacked;
+    return true;
+#elif defined(_WIN32)
+    (void)pending;
+    (void)backlog;
+    return false;
+#endif
+}
+
 ClientSocket ServerSocket::accept() const
 {
     struct sockaddr_in cli_addr{};
     socklen_t cliLen = sizeof(cli_addr);
+#if defined(__linux__)
+    socket_t rvalue = ::accept4(sock, (struct sockaddr *)&cli_addr, &cliLen, SOCK_CLOEXEC);
+#elif defined(_WIN32)
     socket_t rvalue = ::accept(sock, (struct sockaddr *)&cli_addr, &cliLen);
+#endif
     char addr[46];
     char *tmp = inet_ntoa(cli_addr.sin_addr);
 #if defined(__linux__)
@@ -159,6 +202,7 @@ ClientSocket::ClientSocket(socket_t client, char *addr) : address(addr)
 
 ClientSocket::ClientSocket(int type)
 {
+    sock = socket(AF_INET, type, 0);
     connected = false;
 
 #if defined(__linux__)
@@ -175,18 +219,38 @@ bool ClientSocket::connect(const char *address, int port) const
     if (connected)
         return false;
 
-    struct sockaddr_in serv_addr{};
-    struct hostent *server;
-    server = gethostbyname(address);
-    if (server == nullptr)
-    {
-        return -1;
-    }
-    memset((void *)&serv_addr, '\0', sizeof(serv_addr));
-    serv_addr.sin_family = AF_INET;
-    memmove((char *)&serv_addr.sin_addr.s_addr, (char *)server->h_addr, server->h_length);
-    serv_addr.sin_port = htons(port);
-    return ::connect(sock, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) == 0;
+    // getaddrinfo is thread-safe, unlike gethostbyname
+    struct addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *results = nullptr;
+    if (getaddrinfo(address, std::to_string(port).c_str(), &hints, &results) != 0)
+        return false;
+
+    bool success = false;
+    for (struct addrinfo *result = results; result && !success; result = result->ai_next)
+        success = ::connect(sock, result->ai_addr, (int)result->ai_addrlen) == 0;
+
+    freeaddrinfo(results);
+    return success;
+}
+
+bool ClientSocket::setTimeout(int timeout) const
+{
+#if defined(__linux__)
+    struct timeval value{};
+    value.tv_sec = timeout / 1000;
+    value.tv_usec = (timeout % 1000) * 1000;
+    const void *option = &value;
+    socklen_t optionLen = sizeof(value);
+#elif defined(_WIN32)
+    DWORD value = (DWORD)timeout;
+    const char *option = reinterpret_cast<const char *>(&value);
+    int optionLen = sizeof(value);
+#endif
+    return setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, option, optionLen) == 0 &&
+           setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, option, optionLen) == 0;
 }
 
 ssize_t ClientSocket::read(std::byte *buffer, size_t len) const
@@ -203,6 +267,27 @@ ssize_t ClientSocket::read(std::byte *buffer, size_t len) const
     return retval;
 }
 
+ssize_t ClientSocket::readAvailable(std::byte *buffer, size_t len) const
+{
+#if defined(__linux__)
+    ssize_t retval = recv(sock, buffer, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (retval < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return 0;
+    if (retval <= 0)
+        throw std::runtime_error("Invalid socket read !");
+#elif defined(_WIN32)
+    u_long pending = 0;
+    ioctlsocket(sock, FIONREAD, &pending);
+    // A readable socket with nothing pending was closed by the peer,
+    // asking for at least one byte makes recv report it
+    auto toRead = (int)(pending == 0 ? 1 : (pending < len ? pending : len));
+    auto retval = (ssize_t)(recv(sock, reinterpret_cast<char *>(buffer), toRead, 0));
+    if (retval <= 0)
+        throw std::runtime_error("Invalid socket read (" + std::to_string(WSAGetLastError()) + ")");
+#endif
+    return retval;
+}
+
 ssize_t ClientSocket::write(const std::byte *buffer, size_t len) const
 {
 #if defined(__linux__)
@@ -212,6 +297,64 @@ ssize_t ClientSocket::write(const std::byte *buffer, size_t len) const
 #endif
 }
 
+ssize_t ClientSocket::write(const SocketBuffer *buffers, size_t count) const
+{
+    if (count > MAX_WRITE_BUFFERS)
+        throw std::runtime_error("Too many buffers for a single socket write");
+
+#if defined(__linux__)
+    struct iovec iov[MAX_WRITE_BUFFERS];
+    for (size_t i = 0; i < count; i++)
+    {
+        iov[i].iov_base = const_cast<std::byte *>(buffers[i].data);
+        iov[i].iov_len = buffers[i].len;
+    }
+
+    struct msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    return sendmsg(sock, &msg, MSG_NOSIGNAL);
+#elif defined(_WIN32)
+    WSABUF wsaBuffers[MAX_WRITE_BUFFERS];
+    for (size_t i = 0; i < count; i++)
+    {
+        wsaBuffers[i].buf = reinterpret_cast<char *>(const_cast<std::byte *>(buffers[i].data));
+        wsaBuffers[i].len = (ULONG)buffers[i].len;
+    }
+
+    DWORD sent = 0;
+    if (WSASend(sock, wsaBuffers, (DWORD)count, &sent, 0, nullptr, nullptr) == SOCKET_ERROR)
+        return -1;
+    return sent;
+#endif
+}
+
+ssize_t ClientSocket::writeAvailable(const SocketBuffer *buffers, size_t count) const
+{
+#if defined(__linux__)
+    if (count > MAX_WRITE_BUFFERS)
+        throw std::runtime_error("Too many buffers for a single socket write");
+
+    struct iovec iov[MAX_WRITE_BUFFERS];
+    for (size_t i = 0; i < count; i++)
+    {
+        iov[i].iov_base = const_cast<std::byte *>(buffers[i].data);
+        iov[i].iov_len = buffers[i].len;
+    }
+
+    struct msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    ssize_t retval = sendmsg(sock, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (retval < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return 0;
+    return retval;
+#elif defined(_WIN32)
+    // Sockets are blocking, there is no flag to skip waiting for a single call
+    return write(buffers, count);
+#endif
+}
+
 void ClientSocket::close() const
 {
 #if defined(_WIN32)
@@ -242,59 +385,3 @@ bool ClientSocket::isValid() const {
 #endif
     return isValid;
 }
-
-mojangapi::HasJoinedResponse mojangapi::hasJoined(const std::string &username, const std::string &serverId, const std::string &ip)
-{
-    OpenSSL_add_ssl_algorithms();
-    SSL_CTX *ctx = SSL_CTX_new(TLS_client_method());
-    if (!ctx)
-        throw std::runtime_error("Could not initialize SSL context");
-
-    ClientSocket socket(SOCK_STREAM);
-    if (!socket.connect("sessionserver.mojang.com", 443))
-        throw std::runtime_error("Could not connect to server");
-
-    std::string url = std::string("/session/minecraft/hasJoined") + "?username=" + username + "&serverId=" + serverId + (ip.empty() ? "" : ("&ip=" + ip));
-
-    SSL *ssl = SSL_new(ctx);
-    if (!ssl)
-        throw std::runtime_error("Could not initialize SSL");
-    SSL_set_fd(ssl, socket.getHandle());
-
-    if (SSL_connect(ssl) == -1)
-        throw std::runtime_error("Could not initialize SSL");
-
-    std::string s = "GET " + url + " HTTP/1.1\r\nHost:sessionserver.mojang.com\r\n\r\n";
-
-    if (SSL_write(ssl, s.c_str(), s.size()) == -1)
-        throw std::runtime_error("Could not write to SSL");
-
-    char buff[8192];
-    int len = SSL_read(ssl, buff, sizeof(buff) - 1);
-    if (len == -1)
-        throw std::runtime_error("Could not read to SSL");
-    buff[len] = '\0';
-
-    std::string response(buff);
-    auto loc = response.find("\r\n\r\n");
-    response = response.substr(loc + 4);
-
-    SSL_shutdown(ssl);
-    socket.close();
-    SSL_free(ssl);
-    SSL_CTX_free(ctx);
-
-    HasJoinedResponse r;
-    rapidjson::Document doc;
-    doc.Parse(response.c_str());
-
-    if (doc.HasParseError() || !doc.IsObject() ||
-        !doc.HasMember("id") || !doc["id"].IsString() ||
-        !doc.HasMember("name") || !doc["name"].IsString())
-        throw std::runtime_error("Could not parse JSON response");
-
-    r.name = std::string(doc["name"].GetString(), doc["name"].GetStringLength());
-    r.id = MinecraftUUID::fromHex(std::string(doc["id"].GetString(), doc["id"].GetStringLength()));
-
-    return r;
-}
@@ -33,6 +33,26 @@ typedef SOCKET socket_t;
 typedef SSIZE_T ssize_t;
 #endif
 
+/**
+ * @brief Buffer for vectored socket writes
+ *
+ * Points to data owned by the caller, used
+ * to send multiple buffers in a single call.
+ */
+struct SocketBuffer
+{
+    /**
+     * @brief The data to send
+     *
+     */
+    const std::byte *data;
+    /**
+     * @brief The length of the data
+     *
+     */
+    size_t len;
+};
+
 /**
  * @brief Network POSIX Client
  *
@@ -82,6 +102,17 @@ public:
      * @return false something went wrong
      */
     bool connect(const char *address, int port) const;
+    /**
+     * @brief Sets the timeout of blocking operations
+     *
+     * Applies to reads, writes and, on Linux, to
+     * ClientSocket::connect(), that then fail once
+     * the timeout is reached.
+     * @param timeout the timeout in milliseconds
+     * @return true the timeout was set
+     * @return false something went wrong
+     */
+    bool setTimeout(int timeout) const;
 
     /**
      * @brief Whether the connection is valid
@@ -99,6 +130,17 @@ public:
      * @return ssize_t the data length actually read
      */
     ssize_t read(std::byte *buffer, size_t len) const;
+    /**
+     * @brief Reads pending data from the socket
+     *
+     * Same as ClientSocket::read() but never waits
+     * for data to come in, only returns what was
+     * already received by the system.
+     * @param buffer the buffer to write into
+     * @param len the maximum length to write
+     * @return ssize_t the data length actually read, 0 if nothing was pending
+     */
+    ssize_t readAvailable(std::byte *buffer, size_t len) const;
     /**
      * @brief Writes to the socket
      *
@@ -108,6 +150,32 @@ public:
      * @return ssize_t the data length actually written
      */
     ssize_t write(const std::byte *buffer, size_t len) const;
+    /**
+     * @brief Writes multiple buffers to the socket
+     *
+     * Gathers all of the buffers in a single system
+     * call (sendmsg on Linux, WSASend on Windows).
+     * @param buffers the buffers to read from, in order
+     * @param count the number of buffers, at most ClientSocket::MAX_WRITE_BUFFERS
+     * @return ssize_t the data length actually written
+     */
+    ssize_t write(const SocketBuffer *buffers, size_t count) const;
+    /**
+     * @brief Writes multiple buffers without waiting
+     *
+     * Same as ClientSocket::write(const SocketBuffer *, size_t)
+     * but only writes what the system can take right away.
+     * On Windows, it waits like ClientSocket::write() does.
+     * @param buffers the buffers to read from, in order
+     * @param count the number of buffers, at most ClientSocket::MAX_WRITE_BUFFERS
+     * @return ssize_t the data length actually written, 0 if the system is full, -1 on error
+     */
+    ssize_t writeAvailable(const SocketBuffer *buffers, size_t count) const;
+    /**
+     * @brief Max number of buffers for a vectored write
+     *
+     */
+    static constexpr size_t MAX_WRITE_BUFFERS = 16;
     /**
      * @brief Closes the connection
      *
@@ -206,6 +274,37 @@ public:
      * @param backlog the max incoming connections
      */
     void start(unsigned int backlog) const;
+    /**
+     * @brief Allows other sockets to listen on the same port
+     *
+     * Sets SO_REUSEPORT so that multiple listening
+     * sockets can be bound to the same address and port,
+     * the system then spreads incoming connections over them.
+     * Must be called before ServerSocket::bind().
+     * @return true the option was set
+     * @return false the system does not support it
+     */
+    bool setReusePort() const;
+    /**
+     * @brief Only accept connections that sent data
+     *
+     * Sets TCP_DEFER_ACCEPT so that the server is
+     * not woken up for connections that did not
+     * send anything yet.
+     * @param seconds how long to wait for data before accepting anyway
+     * @return true the option was set
+     * @return false the system does not support it
+     */
+    bool setDeferAccept(int seconds) const;
+    /**
+     * @brief Get the state of the accept queue
+     *
+     * @param pending the number of connections waiting to be accepted
+     * @param backlog the max number of connections the queue holds
+     * @return true the state was retrieved
+     * @return false the system does not support it
+     */
+    bool getAcceptQueue(unsigned int &pending, unsigned int &backlog) const;
     /**
      * @brief Accepts a new client
      *
@@ -224,6 +323,16 @@ public:
      */
     void close() const;
 
+    /**
+     * @brief Get the Handle of the socket
+     *
+     * @return socket_t the handle of the socket
+     */
+    socket_t getHandle() const
+    {
+        return sock;
+    }
+
     /**
      * @brief Inits the POSIX API
      *
@@ -250,40 +359,4 @@ public:
     static bool cleanup();
 };
 
-/**
- * @brief The Mojang API holder
- *
- */
-namespace mojangapi
-{
-    /**
-     * @brief Reponse for ::hasJoined endpoint
-     *
-     */
-    struct HasJoinedResponse
-    {
-        /**
-         * @brief Name of the player
-         *
-         */
-        std::string name;
-        /**
-         * @brief MinecraftUUID of the player
-         *
-         */
-        MinecraftUUID id;
-    };
-
-    /**
-     * @brief Checks whether the player has joined the server
-     *
-     * Only used during authentication scheme.
-     * @param username the username of the player
-     * @param serverId the hash (aka the server id)
-     * @param ip the ip of the client if needed
-     * @return HasJoinedResponse the response from the API
-     */
-    HasJoinedResponse hasJoined(const std::string &username, const std::string &serverId, const std::string &ip = "");
-}
-
 #endif
\ No newline at end of file
@@ -1,5 +1,11 @@
 #include <gtest/gtest.h>
 #include <plugins/event.h>
+#include <plugins/executor.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
 
 class FakeEvent : public IEvent<FakeEvent>
 {
@@ -73,4 +79,207 @@ TEST(Events, FunctionSubs)
 
     events.fire(e);
     ASSERT_EQ(e.amount, 1);
-}
\ No newline at end of file
+}
+
+TEST(Events, ConcurrentSubs)
+{
+    EventsManager events;
+    std::atomic<bool> running = true;
+    std::atomic<int> churned = 0;
+
+    // Always subscribed, must see every fire
+    auto stable = events.subscribe<FakeEvent>(testEvent);
+
+    std::vector<std::thread> firing;
+    for (int i = 0; i < 4; i++)
+        firing.emplace_back([&events]()
+                            {
+            FakeEvent e;
+            for (int j = 0; j < 20000; j++)
+                events.fire(e);
+            ASSERT_GE(e.amount, 20000); });
+
+    std::vector<std::thread> subscribing;
+    for (int i = 0; i < 2; i++)
+        subscribing.emplace_back([&events, &running, &churned]()
+                                 {
+            while (running)
+            {
+                auto subId = events.subscribe<FakeEvent>([&churned](FakeEvent &)
+                                                         { churned++; });
+                events.unsubscribe<FakeEvent>(subId);
+            } });
+
+    for (auto &thread : firing)
+        thread.join();
+    running = false;
+    for (auto &thread : subscribing)
+        thread.join();
+
+    FakeEvent e;
+    int before = churned;
+    events.fire(e);
+    ASSERT_EQ(e.amount, 1);
+    ASSERT_EQ(churned, before);
+    events.unsubscribe<FakeEvent>(stable);
+}
+
+class DeferredEvent : public IEvent<DeferredEvent>
+{
+public:
+    static constexpr bool DEFERRABLE = true;
+};
+
+class MergedEvent : public IEvent<MergedEvent>
+{
+public:
+    static constexpr bool DEFERRABLE = true;
+    static constexpr bool COALESCED = true;
+};
+
+TEST(Events, AsyncDelivery)
+{
+    EventsManager events;
+    std::atomic<int> deferred = 0;
+    std::atomic<int> merged = 0;
+    std::atomic<bool> onFiringThread = false;
+    auto firing = std::this_thread::get_id();
+
+    auto deferredId = events.subscribe<DeferredEvent>([&](DeferredEvent &)
+                                                      {
+        deferred++;
+        if (std::this_thread::get_id() == firing)
+            onFiringThread = true; });
+    auto mergedId = events.subscribe<MergedEvent>([&merged](MergedEvent &)
+                                                  { merged++; });
+
+    events.startAsync();
+    ASSERT_TRUE(events.isAsync());
+
+    // Not deferrable, still delivered right away
+    FakeEvent e;
+    auto fakeId = events.subscribe<FakeEvent>(testEvent);
+    events.fire(e);
+    ASSERT_EQ(e.amount, 1);
+
+    for (int i = 0; i < 1000; i++)
+    {
+        DeferredEvent d;
+        MergedEvent m;
+        events.fire(d);
+        events.fire(m);
+    }
+
+    events.stopAsync();
+    ASSERT_FALSE(events.isAsync());
+    ASSERT_EQ(deferred, 1000);
+    ASSERT_FALSE(onFiringThread);
+    ASSERT_GE(merged, 1);
+    ASSERT_EQ(merged + (int)events.getCoalesced(), 1000);
+    ASSERT_EQ(events.getDelivered(), 1000 + (std::uint64_t)merged);
+    ASSERT_EQ(events.getQueueDepth(), 0);
+
+    // Stopped, delivered right away again
+    DeferredEvent d;
+    events.fire(d);
+    ASSERT_EQ(deferred, 1001);
+    ASSERT_TRUE(onFiringThread);
+
+    events.unsubscribe<DeferredEvent>(deferredId);
+    events.unsubscribe<MergedEvent>(mergedId);
+    events.unsubscribe<FakeEvent>(fakeId);
+}
+
+TEST(Events, PluginExecutor)
+{
+    auto executor = std::make_shared<PluginExecutor>("test", std::chrono::milliseconds(50));
+
+    // Queued until started, then run in order by a single thread
+    std::vector<int> order;
+    for (int i = 0; i < 100; i++)
+        executor->post([&order, i]()
+                       { order.push_back(i); });
+    ASSERT_EQ(executor->getQueueDepth(), 100);
+    executor->start();
+
+    FakeEvent e;
+    ASSERT_TRUE(executor->call([&e, &executor]()
+                               {
+        e.amount++;
+        // Calls from the executor itself run right away
+        executor->call([&e]()
+                       { e.amount++; }); }));
+    ASSERT_EQ(e.amount, 2);
+    ASSERT_EQ(order.size(), 100);
+    for (int i = 0; i < 100; i++)
+        ASSERT_EQ(order[i], i);
+
+    // Many producers
+    std::atomic<int> posted = 0;
+    std::vector<std::thread> producers;
+    for (int i = 0; i < 4; i++)
+        producers.emplace_back([&executor, &posted]()
+                               {
+            for (int j = 0; j < 10000; j++)
+                executor->post([&posted]()
+                               { posted++; }); });
+    for (auto &thread : producers)
+        thread.join();
+    while (executor->getQueueDepth() > 0)
+        std::this_thread::yield();
+    ASSERT_TRUE(executor->call([]() {}));
+    ASSERT_EQ(posted, 40000);
+
+    // A busy plugin makes the calls time out, skipping them
+    std::atomic<bool> busy = true;
+    executor->post([&busy]()
+                   {
+        while (busy)
+            std::this_thread::yield(); });
+    ASSERT_FALSE(executor->call([&e]()
+                                { e.amount++; }));
+    ASSERT_EQ(executor->getTimeouts(), 1);
+    busy = false;
+    ASSERT_TRUE(executor->call([]() {}));
+    ASSERT_EQ(e.amount, 2);
+
+    // A started task that never ends does not hold its caller either
+    busy = true;
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_FALSE(executor->call([&busy]()
+                                {
+        while (busy)
+            std::this_thread::yield(); }));
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+    ASSERT_EQ(executor->getTimeouts(), 2);
+    busy = false;
+    ASSERT_TRUE(executor->call([]() {}));
+
+    executor->stop();
+    ASSERT_FALSE(executor->call([]() {}));
+}
+
+TEST(Events, PluginAccounting)
+{
+    // Margins are wide, for the timings of a loaded machine
+    auto executor = std::make_shared<PluginExecutor>("test", std::chrono::milliseconds(5000));
+    executor->setLimits(0, std::chrono::milliseconds(200));
+    executor->start();
+
+    // Waiting is not running
+    ASSERT_TRUE(executor->call([]()
+                               { std::this_thread::sleep_for(std::chrono::milliseconds(300)); }));
+    ASSERT_TRUE(executor->call([]()
+                               {
+        auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(1);
+        while (std::chrono::steady_clock::now() < end)
+            ; }));
+
+    // Tasks are accounted once done, after their caller is released
+    ASSERT_TRUE(executor->call([]() {}));
+    ASSERT_GE(executor->getSlow(), 1);
+    ASSERT_GE(executor->getHandled(), 2);
+    ASSERT_GT(executor->getCPUTime(), 0);
+    ASSERT_LT(executor->getCPUTime(), 300);
+    ASSERT_EQ(executor->getAborted(), 0);
+}
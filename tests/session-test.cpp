@@ -0,0 +1,383 @@
+#include <gtest/gtest.h>
+#include <net/session.h>
+#include <net/sessioncache.h>
+#include <utils/crypto.h>
+#include <openssl/pem.h>
+#include <openssl/x509v3.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+/**
+ * @brief Local HTTPS session server
+ *
+ * Answers every request with the response built by
+ * the handler, keeping connections alive, and counts
+ * the connections it got.
+ */
+class StubSessionServer
+{
+public:
+    typedef std::function<std::string(const std::string &requestLine)> Handler;
+
+private:
+    Handler handler;
+    SSL_CTX *ctx;
+    int listener;
+    int port;
+    std::string certFile;
+    std::thread acceptor;
+    std::vector<std::thread> connections;
+
+    std::mutex lock;
+    std::vector<std::string> requestLines;
+    int accepted = 0;
+    int active = 0;
+    int maxActive = 0;
+
+    void serve(int sock)
+    {
+        SSL *ssl = SSL_new(ctx);
+        SSL_set_fd(ssl, sock);
+
+        if (SSL_accept(ssl) == 1)
+        {
+            std::string buffer;
+            char data[4096];
+            while (true)
+            {
+                std::size_t end = buffer.find("\r\n\r\n");
+                if (end == std::string::npos)
+                {
+                    int len = SSL_read(ssl, data, sizeof(data));
+                    if (len <= 0)
+                        break;
+                    buffer.append(data, len);
+                    continue;
+                }
+
+                std::string requestLine = buffer.substr(0, buffer.find("\r\n"));
+                buffer.erase(0, end + 4);
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    requestLines.push_back(requestLine);
+                    maxActive = std::max(maxActive, ++active);
+                }
+
+                std::string response = handler(requestLine);
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    active--;
+                }
+                if (response.empty() || SSL_write(ssl, response.data(), (int)response.size()) <= 0)
+                    break;
+            }
+        }
+
+        SSL_free(ssl);
+        ::close(sock);
+    }
+
+public:
+    StubSessionServer(Handler handler) : handler(std::move(handler)), ctx(SSL_CTX_new(TLS_server_method()))
+    {
+        // Self-signed certificate for localhost, trusted by the session client
+        EVP_PKEY *key = nullptr;
+        EVP_PKEY_CTX *keyCtx = EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, nullptr);
+        EVP_PKEY_keygen_init(keyCtx);
+        EVP_PKEY_CTX_set_rsa_keygen_bits(keyCtx, 2048);
+        EVP_PKEY_keygen(keyCtx, &key);
+        EVP_PKEY_CTX_free(keyCtx);
+
+        X509 *cert = X509_new();
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+        X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+        X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+        X509_set_pubkey(cert, key);
+        X509_NAME *name = X509_get_subject_name(cert);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char *)"localhost", -1, -1, 0);
+        X509_set_issuer_name(cert, name);
+        X509_EXTENSION *altName = X509V3_EXT_conf_nid(nullptr, nullptr, NID_subject_alt_name, "DNS:localhost");
+        X509_add_ext(cert, altName, -1);
+        X509_EXTENSION_free(altName);
+        X509_sign(cert, key, EVP_sha256());
+
+        SSL_CTX_use_certificate(ctx, cert);
+        SSL_CTX_use_PrivateKey(ctx, key);
+
+        certFile = testing::TempDir() + "session-test-" + std::to_string(::getpid()) + ".pem";
+        FILE *file = std::fopen(certFile.c_str(), "w");
+        PEM_write_X509(file, cert);
+        std::fclose(file);
+
+        X509_free(cert);
+        EVP_PKEY_free(key);
+
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(listener, (sockaddr *)&addr, sizeof(addr));
+        listen(listener, 16);
+        socklen_t addrLen = sizeof(addr);
+        getsockname(listener, (sockaddr *)&addr, &addrLen);
+        port = ntohs(addr.sin_port);
+
+        acceptor = std::thread([this]()
+                               {
+            while (true)
+            {
+                int sock = accept(listener, nullptr, nullptr);
+                if (sock < 0)
+                    break;
+
+                std::lock_guard<std::mutex> guard(lock);
+                accepted++;
+                connections.emplace_back(&StubSessionServer::serve, this, sock);
+            } });
+    }
+
+    ~StubSessionServer()
+    {
+        shutdown(listener, SHUT_RDWR);
+        ::close(listener);
+        acceptor.join();
+        for (std::thread &connection : connections)
+            connection.join();
+
+        SSL_CTX_free(ctx);
+        std::remove(certFile.c_str());
+    }
+
+    SessionClient::Options options(unsigned int connections = 1, int timeout = 2000) const
+    {
+        SessionClient::Options opts;
+        opts.host = "localhost";
+        opts.port = port;
+        opts.connections = connections;
+        opts.timeout = timeout;
+        opts.caFile = certFile;
+        return opts;
+    }
+
+    int getAccepted()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return accepted;
+    }
+
+    int getMaxActive()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return maxActive;
+    }
+
+    std::vector<std::string> getRequestLines()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return requestLines;
+    }
+};
+
+/**
+ * @brief Collects the results of a session client
+ *
+ */
+class Results
+{
+private:
+    std::mutex lock;
+    std::condition_variable cond;
+    std::vector<SessionClient::Result> results;
+
+public:
+    SessionClient::Callback callback()
+    {
+        return [this](const SessionClient::Result &result)
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            results.push_back(result);
+            cond.notify_all();
+        };
+    }
+
+    std::vector<SessionClient::Result> wait(std::size_t count)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        cond.wait_for(guard, std::chrono::seconds(10), [this, count]()
+                      { return results.size() >= count; });
+        return results;
+    }
+};
+
+static std::string respond(const std::string &status, const std::string &body)
+{
+    return "HTTP/1.1 " + status + "\r\nContent-Type: application/json\r\nContent-Length: " +
+           std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+TEST(SessionClient, HasJoined)
+{
+    StubSessionServer server([](const std::string &)
+                             { return respond("200 OK", "{\"id\":\"069a79f444e94726a5befca90e38aaf5\",\"name\":\"Notch\"}"); });
+    Results results;
+    SessionClient client;
+    client.start(server.options());
+
+    client.hasJoined("Notch", "-4fc3e34b2e1bb5a4e2b0e1d0e3d8c1b7", "1.2.3.4", results.callback());
+    auto answered = results.wait(1);
+
+    ASSERT_EQ(answered.size(), 1);
+    ASSERT_EQ(server.getRequestLines()[0],
+              "GET /session/minecraft/hasJoined?username=Notch&serverId=-4fc3e34b2e1bb5a4e2b0e1d0e3d8c1b7&ip=1.2.3.4 HTTP/1.1");
+    ASSERT_TRUE(answered[0].joined) << answered[0].error;
+    ASSERT_EQ(answered[0].response.name, "Notch");
+    ASSERT_EQ(answered[0].response.id.getTrimmed(), "069a79f444e94726a5befca90e38aaf5");
+}
+
+TEST(SessionClient, NotJoined)
+{
+    StubSessionServer server([](const std::string &)
+                             { return std::string("HTTP/1.1 204 No Content\r\n\r\n"); });
+    Results results;
+    SessionClient client;
+    client.start(server.options());
+
+    client.hasJoined("a b&c", "hash", "", results.callback());
+    auto answered = results.wait(1);
+
+    ASSERT_EQ(answered.size(), 1);
+    ASSERT_FALSE(answered[0].joined);
+    ASSERT_FALSE(answered[0].error.empty());
+    ASSERT_EQ(client.getFailures(), 0);
+    // Usernames can not inject anything in the request
+    ASSERT_EQ(server.getRequestLines()[0], "GET /session/minecraft/hasJoined?username=a%20b%26c&serverId=hash HTTP/1.1");
+}
+
+TEST(SessionClient, KeepAlive)
+{
+    int served = 0;
+    StubSessionServer server([&served](const std::string &)
+                             {
+        // Alternates framings, the connection must stay usable
+        if (served++ % 2 == 0)
+            return std::string("HTTP/1.1 204 No Content\r\n\r\n");
+        return std::string("HTTP/1.1 404 Not Found\r\nTransfer-Encoding: chunked\r\n\r\n"
+                           "4\r\nnope\r\n3\r\n!!!\r\n0\r\n\r\n"); });
+    Results results;
+    SessionClient client;
+    client.start(server.options());
+
+    for (std::size_t i = 0; i < 6; i++)
+    {
+        client.hasJoined("Notch", "hash", "", results.callback());
+        ASSERT_EQ(results.wait(i + 1).size(), i + 1);
+    }
+
+    auto answered = results.wait(6);
+    ASSERT_NE(answered[1].error.find("404"), std::string::npos);
+    ASSERT_EQ(server.getAccepted(), 1);
+    ASSERT_EQ(client.getConnects(), 1);
+    ASSERT_EQ(client.getPending(), 0);
+}
+
+TEST(SessionClient, BoundedConcurrency)
+{
+    StubSessionServer server([](const std::string &)
+                             {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        return std::string("HTTP/1.1 204 No Content\r\n\r\n"); });
+    Results results;
+    SessionClient client;
+    client.start(server.options(2));
+
+    for (int i = 0; i < 8; i++)
+        client.hasJoined("Notch", "hash", "", results.callback());
+
+    ASSERT_EQ(results.wait(8).size(), 8);
+    ASSERT_LE(server.getMaxActive(), 2);
+    ASSERT_LE(server.getAccepted(), 2);
+}
+
+TEST(SessionClient, Timeout)
+{
+    StubSessionServer server([](const std::string &)
+                             {
+        // Never answers in time
+        std::this_thread::sleep_for(std::chrono::milliseconds(600));
+        return std::string(); });
+    Results results;
+    SessionClient client;
+    client.start(server.options(1, 200));
+
+    auto start = std::chrono::steady_clock::now();
+    client.hasJoined("Notch", "hash", "", results.callback());
+    auto answered = results.wait(1);
+
+    ASSERT_EQ(answered.size(), 1);
+    ASSERT_FALSE(answered[0].joined);
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+    ASSERT_EQ(client.getFailures(), 1);
+}
+
+TEST(SessionClient, Untrusted)
+{
+    StubSessionServer server([](const std::string &)
+                             { return std::string("HTTP/1.1 204 No Content\r\n\r\n"); });
+    Results results;
+    SessionClient client;
+    SessionClient::Options options = server.options();
+    // The certificate is only valid for localhost
+    options.host = "127.0.0.1";
+    client.start(options);
+
+    client.hasJoined("Notch", "hash", "", results.callback());
+    auto answered = results.wait(1);
+
+    ASSERT_EQ(answered.size(), 1);
+    ASSERT_FALSE(answered[0].joined);
+    ASSERT_TRUE(server.getRequestLines().empty());
+}
+#endif
+
+TEST(SessionCache, VerifiedPlayers)
+{
+    SessionCache cache;
+    mojangapi::HasJoinedResponse notch{"Notch", MinecraftUUID::fromHex("069a79f444e94726a5befca90e38aaf5")};
+    mojangapi::HasJoinedResponse found;
+
+    // Disabled until given a TTL
+    cache.store("Notch", "1.2.3.4", notch);
+    ASSERT_FALSE(cache.find("Notch", "1.2.3.4", found));
+    ASSERT_EQ(cache.getMisses(), 0);
+
+    cache.setTTL(std::chrono::milliseconds(200));
+    cache.store("Notch", "1.2.3.4", notch);
+    ASSERT_TRUE(cache.find("Notch", "1.2.3.4", found));
+    ASSERT_EQ(found.name, "Notch");
+    ASSERT_EQ(found.id.getTrimmed(), "069a79f444e94726a5befca90e38aaf5");
+
+    // Only the same name from the same address
+    ASSERT_FALSE(cache.find("Notch", "5.6.7.8", found));
+    ASSERT_FALSE(cache.find("jeb_", "1.2.3.4", found));
+    ASSERT_EQ(cache.getHits(), 1);
+    ASSERT_EQ(cache.getMisses(), 2);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    ASSERT_FALSE(cache.find("Notch", "1.2.3.4", found));
+
+    // Expired players make room for new ones
+    for (std::size_t i = 0; i < SessionCache::MAX_ENTRIES; i++)
+        cache.store("bot" + std::to_string(i), "1.2.3.4", notch);
+    ASSERT_EQ(cache.getSize(), SessionCache::MAX_ENTRIES);
+    cache.store("Notch", "1.2.3.4", notch);
+    ASSERT_FALSE(cache.find("Notch", "1.2.3.4", found));
+}
@@ -1,7 +1,21 @@
 #include <gtest/gtest.h>
 #include <net/stream.h>
 #include <net/packet.h>
+#include <net/framedecoder.h>
+#include <net/pipeline.h>
+#include <net/bufferpool.h>
+#include <net/outbound.h>
+#include <net/sharedpacket.h>
+#include <net/compressionpool.h>
+#include <net/compressionpolicy.h>
+#include <net/logincrypto.h>
+#include <net/packets/login/setcompression.h>
 #include <utils/crypto.h>
+#include <filesystem>
+#include <fstream>
+#if defined(__linux__)
+#include <sys/socket.h>
+#endif
 
 /**
  * @brief Test Loops number
@@ -260,6 +274,24 @@ public:
         ASSERT_EQ(stream->readVarInt(), INT_MAX);
         ASSERT_EQ(stream->readVarLong(), LONG_MAX);
     }
+
+    void read(PacketView &packet) override
+    {
+        ASSERT_TRUE(packet.readBoolean());
+        ASSERT_EQ(packet.readByte(), SCHAR_MAX);
+        ASSERT_EQ(packet.readUnsignedByte(), UCHAR_MAX);
+        ASSERT_EQ(packet.readShort(), SHRT_MAX);
+        ASSERT_EQ(packet.readUnsignedShort(), SHRT_MAX);
+        ASSERT_EQ(packet.readInt(), INT_MAX);
+        ASSERT_EQ(packet.readFloat(), FLT_MAX);
+        ASSERT_EQ(packet.readLong(), LONG_MAX);
+        ASSERT_EQ(packet.readDouble(), DBL_MAX);
+
+        ASSERT_EQ(packet.readString(), s);
+        ASSERT_EQ(packet.readVarInt(), INT_MAX);
+        ASSERT_EQ(packet.readVarLong(), LONG_MAX);
+        ASSERT_EQ(packet.remaining(), 0);
+    }
 };
 
 void runStreamTest(IMCStream *reader, IMCStream *writer)
@@ -275,6 +307,107 @@ void runStreamTest(IMCStream *reader, IMCStream *writer)
     p.read(reader);
 }
 
+TEST(Streams, VarIntCodec)
+{
+    std::vector<std::int32_t> ints = {0, 1, 127, 128, 255, 2097151, 2097152, INT_MAX, -1, INT_MIN};
+    std::vector<std::int64_t> longs = {0, 1, 127, 128, INT_MAX, 1LL << 56, LLONG_MAX, -1, LLONG_MIN};
+    std::size_t intSizes[] = {1, 1, 1, 2, 2, 3, 4, 5, 5, 5};
+    std::size_t longSizes[] = {1, 1, 1, 2, 5, 9, 9, 10, 10};
+
+    for (std::size_t i = 0; i < ints.size(); i++)
+    {
+        std::byte buffer[16] = {};
+        ASSERT_EQ(varint::size(ints[i]), intSizes[i]);
+        ASSERT_EQ(varint::encode(ints[i], buffer), intSizes[i]);
+
+        // Same bytes as the streams, both with and without enough bytes for the fast path
+        MemoryStream m;
+        m.write(buffer, 0, intSizes[i]);
+        ASSERT_EQ(m.readVarInt(), ints[i]);
+
+        std::int32_t value;
+        ASSERT_EQ(varint::decode(buffer, sizeof(buffer), value), intSizes[i]);
+        ASSERT_EQ(value, ints[i]);
+        ASSERT_EQ(varint::decode(buffer, intSizes[i], value), intSizes[i]);
+        ASSERT_EQ(value, ints[i]);
+        ASSERT_EQ(varint::decode(buffer, intSizes[i] - 1, value), 0);
+    }
+
+    for (std::size_t i = 0; i < longs.size(); i++)
+    {
+        std::byte buffer[16] = {};
+        ASSERT_EQ(varint::size(longs[i]), longSizes[i]);
+        ASSERT_EQ(varint::encode(longs[i], buffer), longSizes[i]);
+
+        MemoryStream m;
+        m.write(buffer, 0, longSizes[i]);
+        ASSERT_EQ(m.readVarLong(), longs[i]);
+
+        std::int64_t value;
+        ASSERT_EQ(varint::decode(buffer, sizeof(buffer), value), longSizes[i]);
+        ASSERT_EQ(value, longs[i]);
+        ASSERT_EQ(varint::decode(buffer, longSizes[i], value), longSizes[i]);
+        ASSERT_EQ(value, longs[i]);
+        ASSERT_EQ(varint::decode(buffer, longSizes[i] - 1, value), 0);
+    }
+
+    std::byte tooBig[16];
+    std::fill(std::begin(tooBig), std::end(tooBig), std::byte{0xFF});
+    std::int32_t i32;
+    std::int64_t i64;
+    ASSERT_THROW(varint::decode(tooBig, sizeof(tooBig), i32), std::runtime_error);
+    ASSERT_THROW(varint::decode(tooBig, varint::MAX_VARINT_SIZE, i32), std::runtime_error);
+    ASSERT_THROW(varint::decode(tooBig, sizeof(tooBig), i64), std::runtime_error);
+
+    // Batches
+    std::vector<std::byte> encoded(ints.size() * varint::MAX_VARINT_SIZE);
+    std::size_t written = varint::encodeArray(ints.data(), ints.size(), encoded.data());
+    std::vector<std::int32_t> decoded(ints.size());
+    ASSERT_EQ(varint::decodeArray(encoded.data(), written, decoded.data(), decoded.size()), written);
+    ASSERT_EQ(decoded, ints);
+    ASSERT_EQ(varint::decodeArray(encoded.data(), written - 1, decoded.data(), decoded.size()), 0);
+
+    MemoryStream m;
+    m.writeVarInts(ints.data(), ints.size());
+    ASSERT_EQ(m.getData().size(), written);
+    PacketView view(m.getData().data(), m.getData().size());
+    std::fill(decoded.begin(), decoded.end(), 0);
+    view.readVarInts(decoded.data(), decoded.size());
+    ASSERT_EQ(decoded, ints);
+    ASSERT_EQ(view.remaining(), 0);
+}
+
+TEST(Streams, BufferPool)
+{
+    TestPacket p;
+    MemoryStream sink;
+
+    // Warms up the buffers of this thread
+    p.send(&sink);
+    std::uint64_t allocations = PacketBufferPool::allocations();
+
+    for (int i = 0; i < 1000; i++)
+    {
+        sink.clear();
+        p.send(&sink);
+    }
+    ASSERT_EQ(PacketBufferPool::allocations(), allocations);
+
+    sink.readVarInt();
+    ASSERT_EQ(sink.readVarInt(), p.id);
+    p.read(&sink);
+
+    // Borrowed buffers are distinct and given back cleared
+    {
+        PooledBuffer first = PacketBufferPool::acquire();
+        PooledBuffer second = PacketBufferPool::acquire();
+        ASSERT_NE(&first.get(), &second.get());
+        first.get().writeInt(INT_MAX);
+    }
+    PooledBuffer buffer = PacketBufferPool::acquire();
+    ASSERT_EQ(buffer.get().available(), 0);
+}
+
 TEST(Streams, Cipher)
 {
     std::unique_ptr<std::byte[]> key = crypto::randomSecure(16);
@@ -296,6 +429,451 @@ TEST(Streams, ZLib)
     runStreamTest(&stream10k, &stream10k);
 }
 
+#if defined(__linux__)
+/**
+ * @brief Makes a pair of connected sockets
+ *
+ * @return std::pair<ClientSocket, ClientSocket> the reading and the writing sockets
+ */
+std::pair<ClientSocket, ClientSocket> makeSocketPair()
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        throw std::runtime_error("Could not create a socket pair");
+
+    char address[] = "localhost";
+    return {ClientSocket(fds[0], address), ClientSocket(fds[1], address)};
+}
+
+TEST(Streams, NetSocket)
+{
+    auto [readSocket, writeSocket] = makeSocketPair();
+    NetSocketStream reader(readSocket);
+    NetSocketStream writer(writeSocket);
+
+    runStreamTest(&reader, &writer);
+    ASSERT_EQ(reader.available(), 0);
+
+    // Non blocking path, as used by the clients
+    TestPacket p;
+    p.send(&writer);
+    p.send(&writer);
+    ASSERT_GT(reader.fill(), 0);
+
+    std::int32_t len;
+    for (int i = 0; i < 2; i++)
+    {
+        std::size_t headerSize = varint::decode(reader.received(), reader.receivedSize(), len);
+        ASSERT_GT(headerSize, 0);
+        ASSERT_GE(reader.receivedSize(), headerSize + len);
+        reader.consume(headerSize + len);
+    }
+    ASSERT_EQ(reader.receivedSize(), 0);
+}
+
+TEST(Streams, OutboundQueue)
+{
+    auto [readSocket, writeSocket] = makeSocketPair();
+    NetSocketStream reader(readSocket);
+    NetSocketStream writer(writeSocket);
+    OutboundQueue &queue = writer.getQueue();
+    TestPacket p;
+
+    // Held back until flushed, then sent together
+    writer.cork();
+    for (int i = 0; i < 10; i++)
+        p.send(&writer);
+    ASSERT_GT(queue.size(), 0);
+    ASSERT_EQ(reader.fill(), 0);
+    writer.flush();
+    ASSERT_TRUE(queue.empty());
+    MemoryStream single;
+    p.send(&single);
+    ASSERT_EQ(reader.fill(), single.getData().size() * 10);
+    reader.consume(reader.receivedSize());
+
+    // Whatever the socket can not take is queued, in order
+    std::vector<std::byte> data(1024 * 1024);
+    for (std::size_t i = 0; i < data.size(); i++)
+        data[i] = static_cast<std::byte>(i * 7);
+    SocketBuffer buffer{data.data(), data.size()};
+    writer.send(&buffer, 1);
+    ASSERT_FALSE(queue.empty());
+    ASSERT_TRUE(queue.isCongested());
+
+    std::vector<std::byte> received;
+    while (received.size() < data.size())
+    {
+        writer.flush();
+        reader.fill();
+        received.insert(received.end(), reader.received(), reader.received() + reader.receivedSize());
+        reader.consume(reader.receivedSize());
+    }
+    ASSERT_TRUE(queue.empty());
+    ASSERT_FALSE(queue.isCongested());
+    ASSERT_TRUE(std::equal(data.begin(), data.end(), received.begin()));
+
+    // Past the budget, data is dropped and the connection should be closed
+    queue.setBudget(OutboundQueue::HIGH_WATERMARK);
+    buffer = {data.data(), data.size()};
+    writer.send(&buffer, 1);
+    buffer = {data.data(), data.size()};
+    writer.send(&buffer, 1);
+    ASSERT_TRUE(queue.isOverflowed());
+    ASSERT_LE(queue.size(), OutboundQueue::HIGH_WATERMARK);
+}
+#endif
+
+TEST(Streams, PacketView)
+{
+    TestPacket p;
+    MemoryStream m;
+    p.send(&m);
+
+    const std::vector<std::byte> &data = m.getData();
+    std::int32_t len;
+    std::size_t headerSize = varint::decode(data.data(), data.size(), len);
+    ASSERT_EQ(headerSize + len, data.size());
+
+    PacketView view(data.data() + headerSize, len);
+    ASSERT_EQ(view.readVarInt(), p.id);
+    p.read(view);
+
+    // Bounds are checked
+    ASSERT_THROW(view.readByte(), std::runtime_error);
+    PacketView truncated(data.data() + headerSize, 4);
+    truncated.readVarInt();
+    ASSERT_THROW(truncated.readLong(), std::runtime_error);
+}
+
+#if defined(__linux__)
+TEST(Streams, FrameDecoder)
+{
+    auto [readSocket, writeSocket] = makeSocketPair();
+    NetSocketStream reader(readSocket);
+    FrameDecoder frames(&reader);
+    std::unique_ptr<std::byte[]> key = crypto::randomSecure(16);
+
+    auto *writer = new NetSocketStream(writeSocket);
+    auto *cipher = new CipherStream(writer, key.get(), key.get());
+    ZLibStream compress(cipher, 5, 64);
+
+    TestPacket p;
+    PacketView view;
+
+    // Plain, then encrypted, then encrypted and compressed
+    p.send(writer);
+    p.send(cipher);
+    p.send(&compress);
+
+    frames.fill();
+    ASSERT_TRUE(frames.next(view));
+    ASSERT_EQ(view.readVarInt(), p.id);
+    p.read(view);
+
+    frames.enableEncryption(key.get());
+    ASSERT_TRUE(frames.next(view));
+    ASSERT_EQ(view.readVarInt(), p.id);
+    p.read(view);
+
+    frames.enableCompression(64);
+    ASSERT_TRUE(frames.next(view));
+    ASSERT_EQ(view.readVarInt(), p.id);
+    p.read(view);
+
+    ASSERT_FALSE(frames.next(view));
+}
+
+TEST(Streams, Pipeline)
+{
+    auto [readSocket, writeSocket] = makeSocketPair();
+    NetSocketStream reader(readSocket);
+    NetSocketStream writer(writeSocket);
+    PipelineStream pipeline(&writer);
+    std::unique_ptr<std::byte[]> key = crypto::randomSecure(16);
+
+    // Same packets through the decorators chain
+    auto *memory = new MemoryStream();
+    auto *cipher = new CipherStream(memory, key.get(), key.get());
+    ZLibStream compress(cipher, 5, 64);
+
+    TestPacket p;
+    SetCompression small(64);
+
+    // Plain, then encrypted, then encrypted and compressed
+    p.send(&pipeline);
+    p.send(memory);
+    pipeline.enableEncryption(key.get());
+    p.send(&pipeline);
+    p.send(cipher);
+    pipeline.enableCompression(5, 64);
+    p.send(&pipeline);
+    p.send(&compress);
+    small.send(&pipeline);
+    small.send(&compress);
+
+    // Bytes sent must be the exact same
+    const std::vector<std::byte> &expected = memory->getData();
+    while (reader.receivedSize() < expected.size())
+        ASSERT_GT(reader.fill(), 0);
+    ASSERT_EQ(reader.receivedSize(), expected.size());
+    ASSERT_TRUE(std::equal(expected.begin(), expected.end(), reader.received()));
+    reader.consume(reader.receivedSize());
+
+    // Compression without encryption
+    PipelineStream compressed(&writer);
+    compressed.enableCompression(5, 0);
+    p.send(&compressed);
+
+    FrameDecoder frames(&reader);
+    frames.enableCompression(0);
+    frames.fill();
+
+    PacketView view;
+    ASSERT_TRUE(frames.next(view));
+    ASSERT_EQ(view.readVarInt(), p.id);
+    p.read(view);
+    ASSERT_FALSE(frames.next(view));
+}
+
+TEST(Streams, PipelineOffload)
+{
+    auto [readSocket, writeSocket] = makeSocketPair();
+    NetSocketStream reader(readSocket);
+    NetSocketStream writer(writeSocket);
+    PipelineStream pipeline(&writer);
+    std::unique_ptr<std::byte[]> key = crypto::randomSecure(16);
+    pipeline.enableEncryption(key.get());
+    pipeline.enableCompression(5, 64);
+
+    std::vector<std::pair<std::uint64_t, std::vector<std::byte>>> offloaded;
+    pipeline.enableOffload(1000, [&offloaded](std::uint64_t ticket, const std::byte *packet, std::size_t len)
+                           {
+        offloaded.push_back({ticket, std::vector<std::byte>(packet, packet + len)});
+        return true; });
+
+    // Packet ids are their index, large ones are offloaded
+    std::size_t sizes[] = {10, 2000, 100, 5000, 10};
+    for (std::size_t i = 0; i < 5; i++)
+    {
+        std::vector<std::byte> packet(sizes[i], std::byte(i));
+        pipeline.finishPacketWrite(packet.data(), packet.size());
+    }
+    ASSERT_EQ(offloaded.size(), 2);
+    ASSERT_TRUE(pipeline.hasPendingOffloads());
+
+    // Completed out of order, nothing can be sent until the first one is back
+    pipeline::ZLibCompression worker(5, 0);
+    std::vector<std::byte> frame;
+    worker.frame(offloaded[1].second.data(), offloaded[1].second.size(), frame);
+    pipeline.completeOffload(offloaded[1].first, frame);
+    ASSERT_TRUE(pipeline.hasPendingOffloads());
+
+    frame.clear();
+    worker.frame(offloaded[0].second.data(), offloaded[0].second.size(), frame);
+    pipeline.completeOffload(offloaded[0].first, frame);
+    ASSERT_FALSE(pipeline.hasPendingOffloads());
+    ASSERT_EQ(pipeline.getDeferredSize(), 0);
+
+    FrameDecoder frames(&reader);
+    frames.enableEncryption(key.get());
+    frames.enableCompression(64);
+
+    frames.fill();
+
+    PacketView view;
+    for (std::size_t i = 0; i < 5; i++)
+    {
+        ASSERT_TRUE(frames.next(view));
+        ASSERT_EQ(view.getSize(), sizes[i]);
+        ASSERT_EQ(view.readVarInt(), i);
+    }
+
+    // Failing workers can not be recovered from
+    std::vector<std::byte> packet(2000);
+    pipeline.finishPacketWrite(packet.data(), packet.size());
+    std::vector<std::byte> empty;
+    ASSERT_THROW(pipeline.completeOffload(offloaded[2].first, empty), std::runtime_error);
+    ASSERT_FALSE(pipeline.hasPendingOffloads());
+}
+
+TEST(Streams, SharedPacket)
+{
+    auto [readSocket, writeSocket] = makeSocketPair();
+    NetSocketStream reader(readSocket);
+    NetSocketStream writer(writeSocket);
+    PipelineStream pipeline(&writer);
+
+    TestPacket p;
+    MemoryStream expected;
+    p.send(&expected);
+    const std::vector<std::byte> &frame = expected.getData();
+    std::int32_t len;
+    std::size_t headerSize = varint::decode(frame.data(), frame.size(), len);
+    SharedPacket shared(std::vector<std::byte>(frame.begin() + headerSize, frame.end()));
+
+    // Framed once, then sent as is
+    pipeline.writeShared(shared);
+    std::uint64_t copied = OutboundQueue::totalCopied();
+    pipeline.writeShared(shared);
+    ASSERT_EQ(OutboundQueue::totalCopied(), copied);
+
+    // Queued by reference
+    writer.cork();
+    pipeline.writeShared(shared);
+    ASSERT_EQ(writer.getQueue().size(), frame.size());
+    ASSERT_EQ(OutboundQueue::totalCopied(), copied);
+    writer.flush();
+    ASSERT_TRUE(writer.getQueue().empty());
+
+    while (reader.receivedSize() < frame.size() * 3)
+        ASSERT_GT(reader.fill(), 0);
+    ASSERT_EQ(reader.receivedSize(), frame.size() * 3);
+    for (int i = 0; i < 3; i++)
+        ASSERT_TRUE(std::equal(frame.begin(), frame.end(), reader.received() + i * frame.size()));
+    reader.consume(reader.receivedSize());
+
+    // Compressed frames are shared as well, only encryption is done for each connection
+    std::unique_ptr<std::byte[]> key = crypto::randomSecure(16);
+    PipelineStream secure(&writer);
+    secure.enableEncryption(key.get());
+    secure.enableCompression(5, 0);
+    PipelineStream compressed(&writer);
+    compressed.enableCompression(5, 0);
+    compressed.writeShared(shared);
+    SharedPacket::Buffer compressedFrame = shared.getFrame(5, 0, [](const std::byte *, std::size_t, std::vector<std::byte> &)
+                                                          { FAIL() << "Frame should be built already"; });
+    ASSERT_FALSE(compressedFrame->empty());
+    secure.writeShared(shared);
+    secure.writeShared(shared);
+
+    FrameDecoder frames(&reader);
+    frames.enableCompression(0);
+    frames.fill();
+    PacketView view;
+    ASSERT_TRUE(frames.next(view));
+    ASSERT_EQ(view.readVarInt(), p.id);
+    p.read(view);
+
+    frames.enableEncryption(key.get());
+    for (int i = 0; i < 2; i++)
+    {
+        ASSERT_TRUE(frames.next(view));
+        ASSERT_EQ(view.readVarInt(), p.id);
+        p.read(view);
+    }
+    ASSERT_FALSE(frames.next(view));
+}
+
+TEST(Streams, CompressionPool)
+{
+    CompressionPool pool;
+    std::vector<std::byte> packet(20000, std::byte(7));
+    ASSERT_FALSE(pool.submit(packet, [](std::vector<std::byte> &) {}));
+
+    pool.start(2, 5);
+    std::mutex lock;
+    std::condition_variable cond;
+    std::vector<std::vector<std::byte>> frames;
+    for (int i = 0; i < 8; i++)
+        ASSERT_TRUE(pool.submit(packet, [&](std::vector<std::byte> &frame)
+                                {
+            std::lock_guard<std::mutex> guard(lock);
+            frames.push_back(frame);
+            cond.notify_all(); }));
+
+    std::unique_lock<std::mutex> guard(lock);
+    cond.wait_for(guard, std::chrono::seconds(10), [&frames]()
+                  { return frames.size() == 8; });
+    ASSERT_EQ(frames.size(), 8);
+    guard.unlock();
+    pool.stop();
+
+    // Same frames as compressed by the network threads
+    pipeline::ZLibCompression compress(5, 0);
+    std::vector<std::byte> expected;
+    compress.frame(packet.data(), packet.size(), expected);
+    for (const std::vector<std::byte> &frame : frames)
+        ASSERT_EQ(frame, expected);
+    ASSERT_EQ(pool.getJobs(), 8);
+    ASSERT_EQ(pool.getPending(), 0);
+}
+
+TEST(Streams, CompressionPolicy)
+{
+    CompressionPolicy policy(5);
+    ASSERT_TRUE(policy.pin("0x21:6, 0x15:0"));
+    ASSERT_FALSE(policy.pin("0x22:6,oops"));
+    ASSERT_FALSE(policy.pin("0x200:1,0x23:12"));
+    ASSERT_EQ(policy.getLevel(0x21), 6);
+    ASSERT_EQ(policy.getLevel(0x15), CompressionPolicy::NONE);
+    ASSERT_EQ(policy.getLevel(0x22), 6);
+    ASSERT_EQ(policy.getLevel(0x23), 5);
+
+    auto [readSocket, writeSocket] = makeSocketPair();
+    NetSocketStream reader(readSocket);
+    NetSocketStream writer(writeSocket);
+    PipelineStream pipeline(&writer);
+    pipeline.enableCompression(5, 64, &policy);
+
+    // Pinned, random and compressible packets
+    std::vector<std::pair<std::int32_t, std::vector<std::byte>>> packets;
+    for (int i = 0; i < 40; i++)
+    {
+        std::unique_ptr<std::byte[]> random = crypto::randomSecure(300);
+        packets.push_back({0x15, std::vector<std::byte>(200, std::byte(0x15))});
+        packets.push_back({0x30, std::vector<std::byte>(random.get(), random.get() + 300)});
+        packets.push_back({0x31, std::vector<std::byte>(300, std::byte(0x31))});
+    }
+    for (auto &[id, packet] : packets)
+    {
+        packet[0] = std::byte(id);
+        pipeline.finishPacketWrite(packet.data(), packet.size());
+    }
+
+    // Clients take uncompressed packets over the threshold, unlike FrameDecoder
+    crypto::ZLibCompressor comp(-1);
+    std::vector<std::byte> uncompressed;
+    for (const auto &[id, packet] : packets)
+    {
+        std::int32_t frameLength = 0, dataLength;
+        std::size_t headerSize;
+        while ((headerSize = varint::decode(reader.received(), reader.receivedSize(), frameLength)) == 0 ||
+               reader.receivedSize() < headerSize + frameLength)
+            ASSERT_GT(reader.fill(), 0);
+
+        const std::byte *frame = reader.received() + headerSize;
+        std::size_t dataLengthSize = varint::decode(frame, frameLength, dataLength);
+        if (dataLength == 0)
+            uncompressed.assign(frame + dataLengthSize, frame + frameLength);
+        else
+        {
+            uncompressed.resize(dataLength);
+            ASSERT_EQ(comp.uncompress(frame + dataLengthSize, frameLength - dataLengthSize, uncompressed.data(), dataLength), dataLength);
+        }
+        ASSERT_EQ(uncompressed, packet);
+        ASSERT_TRUE(id != 0x15 || dataLength == 0);
+        ASSERT_TRUE(id != 0x31 || dataLength != 0);
+        reader.consume(headerSize + frameLength);
+    }
+
+    CompressionPolicy::Stats pinned = policy.getStats(0x15);
+    ASSERT_EQ(pinned.packets, 40);
+    ASSERT_EQ(pinned.compressed, 0);
+
+    // Random data is not worth compressing once learnt
+    CompressionPolicy::Stats random = policy.getStats(0x30);
+    ASSERT_EQ(random.packets, 40);
+    ASSERT_EQ(random.compressed, CompressionPolicy::LEARN_PACKETS);
+    ASSERT_EQ(policy.getLevel(0x30), CompressionPolicy::NONE);
+
+    CompressionPolicy::Stats compressible = policy.getStats(0x31);
+    ASSERT_EQ(compressible.compressed, 40);
+    ASSERT_LT(compressible.bytesOut, compressible.bytesIn / 10);
+    ASSERT_NE(policy.getLevel(0x31), CompressionPolicy::NONE);
+}
+#endif
+
 TEST(Streams, CryptoRSA)
 {
     std::string data = "This is a test !";
@@ -314,6 +892,38 @@ TEST(Streams, CryptoRSA)
     crypto::cleanup();
 }
 
+TEST(Streams, CryptoKeyFile)
+{
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "mineserver-test.key";
+    std::filesystem::remove(path);
+
+    // Generated then saved, loaded on the next start
+    ASSERT_TRUE(crypto::init(path.string()));
+    ASSERT_TRUE(std::filesystem::exists(path));
+    std::span<const std::byte> key = crypto::getPublicRSAKey();
+    ASSERT_FALSE(key.empty());
+    std::vector<std::byte> generated(key.begin(), key.end());
+    ASSERT_EQ(crypto::getPublicRSAKey().data(), key.data());
+    crypto::cleanup();
+
+    ASSERT_TRUE(crypto::init(path.string()));
+    key = crypto::getPublicRSAKey();
+    ASSERT_TRUE(std::equal(key.begin(), key.end(), generated.begin(), generated.end()));
+
+    std::string data = "Shared secret !";
+    size_t encryptedLen, decryptedLen;
+    std::unique_ptr<std::byte[]> encrypted = crypto::rsaEncrypt((std::byte *)data.c_str(), data.length(), &encryptedLen);
+    std::unique_ptr<std::byte[]> decrypted = crypto::rsaDecrypt(encrypted.get(), encryptedLen, &decryptedLen);
+    ASSERT_EQ(data, std::string((const char *)decrypted.get(), decryptedLen));
+    crypto::cleanup();
+
+    // Invalid files are not overwritten
+    std::ofstream(path) << "not a key";
+    ASSERT_FALSE(crypto::init(path.string()));
+    ASSERT_EQ(std::filesystem::file_size(path), 9);
+    std::filesystem::remove(path);
+}
+
 TEST(Streams, CryptoHash)
 {
     crypto::MinecraftHash minecraftHash;
@@ -329,6 +939,79 @@ TEST(Streams, CryptoHash)
 
     minecraftHash.update("simon");
     ASSERT_EQ(minecraftHash.finalize(), "88e16a1019277b15d58faf0541e11910eb756f6");
+
+    std::string bytes = "jeb_";
+    minecraftHash.update(std::as_bytes(std::span(bytes)));
+    ASSERT_EQ(minecraftHash.finalize(), "-7c9d5b0044c130109a5d7b5fb5c317c02b4e28c1");
+
+    // Edges of the two's complement
+    unsigned char digest[20] = {};
+    ASSERT_EQ(crypto::MinecraftHash::formatDigest(digest, sizeof(digest)), "0");
+    digest[19] = 0x01;
+    ASSERT_EQ(crypto::MinecraftHash::formatDigest(digest, sizeof(digest)), "1");
+    std::fill(std::begin(digest), std::end(digest), 0xFF);
+    ASSERT_EQ(crypto::MinecraftHash::formatDigest(digest, sizeof(digest)), "-1");
+    digest[0] = 0x80;
+    std::fill(std::begin(digest) + 1, std::end(digest), 0x00);
+    ASSERT_EQ(crypto::MinecraftHash::formatDigest(digest, sizeof(digest)), "-8000000000000000000000000000000000000000");
+}
+
+TEST(Streams, LoginCrypto)
+{
+    ASSERT_TRUE(crypto::init());
+    LoginCrypto loginCrypto;
+
+    std::unique_ptr<std::byte[]> secret = crypto::randomSecure(16);
+    std::unique_ptr<std::byte[]> token = crypto::randomSecure(4);
+    size_t secretLen, tokenLen;
+    std::unique_ptr<std::byte[]> encryptedSecret = crypto::rsaEncrypt(secret.get(), 16, &secretLen);
+    std::unique_ptr<std::byte[]> encryptedToken = crypto::rsaEncrypt(token.get(), 4, &tokenLen);
+    LoginCrypto::Request request{std::vector<std::byte>(encryptedSecret.get(), encryptedSecret.get() + secretLen),
+                                 std::vector<std::byte>(encryptedToken.get(), encryptedToken.get() + tokenLen)};
+
+    crypto::MinecraftHash hash;
+    hash.update({secret.get(), 16});
+    hash.update(crypto::getPublicRSAKey());
+    std::string serverId = hash.finalize();
+
+    // Not started, decrypted right away
+    bool called = false;
+    loginCrypto.submit(request, [&](const LoginCrypto::Result &result)
+                       {
+        called = true;
+        ASSERT_TRUE(result.decrypted);
+        ASSERT_TRUE(std::equal(result.sharedSecret.begin(), result.sharedSecret.end(), secret.get(), secret.get() + 16));
+        ASSERT_TRUE(std::equal(result.verifyToken.begin(), result.verifyToken.end(), token.get(), token.get() + 4));
+        ASSERT_EQ(result.serverId, serverId); });
+    ASSERT_TRUE(called);
+
+    LoginCrypto::Result invalid = LoginCrypto::decrypt({request.sharedSecret, std::vector<std::byte>(tokenLen)});
+    ASSERT_FALSE(invalid.decrypted);
+    ASSERT_FALSE(invalid.error.empty());
+
+    loginCrypto.start(2);
+    std::mutex lock;
+    std::condition_variable cond;
+    std::vector<std::string> serverIds;
+    for (int i = 0; i < 16; i++)
+        loginCrypto.submit(request, [&](const LoginCrypto::Result &result)
+                           {
+            std::lock_guard<std::mutex> guard(lock);
+            serverIds.push_back(result.serverId);
+            cond.notify_all(); });
+
+    std::unique_lock<std::mutex> guard(lock);
+    cond.wait_for(guard, std::chrono::seconds(10), [&serverIds]()
+                  { return serverIds.size() == 16; });
+    ASSERT_EQ(serverIds.size(), 16);
+    for (const std::string &id : serverIds)
+        ASSERT_EQ(id, serverId);
+    guard.unlock();
+
+    loginCrypto.stop();
+    ASSERT_EQ(loginCrypto.getPending(), 0);
+    ASSERT_EQ(loginCrypto.getRejected(), 0);
+    crypto::cleanup();
 }
 
 TEST(Streams, CryptoCipher)
@@ -355,6 +1038,63 @@ TEST(Streams, CryptoCipher)
     delete[] deData;
 }
 
+TEST(Streams, CryptoCipherInPlace)
+{
+    std::unique_ptr<std::byte[]> key = crypto::randomSecure(16);
+    std::vector<std::byte> plain(5000);
+    for (std::size_t i = 0; i < plain.size(); i++)
+        plain[i] = std::byte(i * 31);
+
+    // Reference CFB8 encryption, as done by the clients
+    std::vector<std::byte> expected(plain.size());
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    EVP_EncryptInit(ctx, EVP_aes_128_cfb8(), (const unsigned char *)key.get(), (const unsigned char *)key.get());
+    int outLen;
+    EVP_EncryptUpdate(ctx, (unsigned char *)expected.data(), &outLen, (const unsigned char *)plain.data(), plain.size());
+    EVP_CIPHER_CTX_free(ctx);
+
+    crypto::AES128CFB8Cipher encipher(crypto::CipherState::ENCRYPT, key.get(), key.get());
+    crypto::AES128CFB8Cipher decipher(crypto::CipherState::DECRYPT, key.get(), key.get());
+    std::vector<std::byte> data = plain;
+    encipher.update(data.data(), data.size());
+    ASSERT_EQ(data, expected);
+
+    // Splits around the block and chunk sizes must not matter
+    std::size_t splits[] = {1, 15, 16, 17, 255, 256, 257, 1000};
+    std::size_t offset = 0;
+    for (std::size_t split : splits)
+    {
+        decipher.update(data.data() + offset, split);
+        offset += split;
+    }
+    decipher.update(data.data() + offset, data.size() - offset);
+    ASSERT_EQ(data, plain);
+}
+
+TEST(Streams, ZLibCompressor)
+{
+    crypto::ZLibCompressor comp(-1);
+
+    // The contexts are reused, sizes must not leak from one call to another
+    for (std::size_t len : {1000, 70000, 10, 16384})
+    {
+        std::vector<std::byte> data(len);
+        for (std::size_t i = 0; i < len; i++)
+            data[i] = std::byte(i % 64 < 48 ? 0 : (i * 31) & 0xFF);
+
+        std::vector<std::byte> compressed(crypto::ZLibCompressor::compressBound(len));
+        int compressedLen = comp.compress(data.data(), len, compressed.data(), compressed.size());
+
+        std::vector<std::byte> uncompressed(len);
+        ASSERT_EQ(comp.uncompress(compressed.data(), compressedLen, uncompressed.data(), len), len);
+        ASSERT_EQ(uncompressed, data);
+
+        // Does not fit, or is not zlib at all
+        ASSERT_THROW(comp.uncompress(compressed.data(), compressedLen, uncompressed.data(), len - 1), std::runtime_error);
+        ASSERT_THROW(comp.uncompress(data.data(), len, uncompressed.data(), len), std::runtime_error);
+    }
+}
+
 TEST(Streams, MD5)
 {
     std::string s1 = "Et l’unique cordeau des trompettes marines";
@@ -0,0 +1,677 @@
+/**
+ * @file loadgen.cpp
+ * @author Lygaen
+ * @brief The file containing the headless bots load generator
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <net/packets/handshake.h>
+#include <net/packets/login/loginstartend.h>
+#include <net/packets/login/setcompression.h>
+#include <net/packets/status/pingpong.h>
+#include <net/packetview.hpp>
+#include <net/stream.h>
+#include <net/varint.hpp>
+#include <utils/config.h>
+#include <utils/crypto.h>
+#include <utils/logger.h>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * @brief Phase driven by the bots
+ *
+ */
+enum class Phase
+{
+    /**
+     * @brief Server List Ping, status then ping
+     *
+     */
+    STATUS,
+    /**
+     * @brief Offline mode login, until the login success
+     *
+     */
+    LOGIN
+};
+
+/**
+ * @brief Load generator options
+ *
+ */
+struct Options
+{
+    /**
+     * @brief Address of the server
+     *
+     */
+    std::string address = "127.0.0.1";
+    /**
+     * @brief Port of the server
+     *
+     */
+    unsigned short port = 25565;
+    /**
+     * @brief Local address the bots connect from, empty for any
+     *
+     */
+    std::string source;
+    /**
+     * @brief Number of connections per phase
+     *
+     */
+    std::size_t connections = 10000;
+    /**
+     * @brief Number of connections open at the same time
+     *
+     */
+    std::size_t concurrency = 1000;
+    /**
+     * @brief Number of threads running the bots
+     *
+     */
+    unsigned int threads = 1;
+    /**
+     * @brief Milliseconds before a bot gives up
+     *
+     */
+    int timeout = 10000;
+    /**
+     * @brief Phases to run, in order
+     *
+     */
+    std::vector<Phase> phases = {Phase::STATUS, Phase::LOGIN};
+};
+
+/**
+ * @brief Results of a phase, from a thread or merged
+ *
+ */
+struct Results
+{
+    /**
+     * @brief Latencies of the succeeded connections, in milliseconds
+     *
+     */
+    std::vector<double> latencies;
+    /**
+     * @brief Number of failed connections
+     *
+     */
+    std::size_t failures = 0;
+    /**
+     * @brief Number of logins the server compressed
+     *
+     */
+    std::size_t compressed = 0;
+    /**
+     * @brief Reason of the first failure
+     *
+     */
+    std::string error;
+};
+
+/**
+ * @brief A single connection to the server
+ *
+ */
+struct Bot
+{
+    /**
+     * @brief Step of the bot in its phase
+     *
+     */
+    enum Step
+    {
+        CONNECTING,
+        STATUS,
+        PONG,
+        LOGIN,
+    };
+
+    /**
+     * @brief The socket, -1 when the bot is done
+     *
+     */
+    int fd = -1;
+    /**
+     * @brief The current step
+     *
+     */
+    Step step = CONNECTING;
+    /**
+     * @brief Username when logging in
+     *
+     */
+    std::string name;
+    /**
+     * @brief Received bytes not handled yet
+     *
+     */
+    std::vector<std::byte> in;
+    /**
+     * @brief Bytes not sent yet
+     *
+     */
+    MemoryStream out;
+    /**
+     * @brief Offset of the first byte of @ref out not sent yet
+     *
+     */
+    std::size_t sent = 0;
+    /**
+     * @brief Compression threshold, -1 when not compressed
+     *
+     */
+    int threshold = -1;
+    /**
+     * @brief When the bot started connecting
+     *
+     */
+    std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * @brief Max length of a received packet
+ *
+ */
+constexpr std::int32_t MAX_PACKET_LENGTH = 2097151;
+
+/**
+ * @brief Prints the usage of the load generator
+ *
+ * @param name the name of the executable
+ */
+static void usage(const char *name)
+{
+    std::printf("Usage : %s [options]\n"
+                "  --address <ip>          server address (127.0.0.1)\n"
+                "  --port <port>           server port (25565)\n"
+                "  --source <ip>           local address to connect from, 127.0.0.2 makes the\n"
+                "                          server compress as it does not for 127.0.0.1 clients\n"
+                "  --connections <n>       connections per phase (10000)\n"
+                "  --concurrency <n>       connections open at the same time (1000)\n"
+                "  --threads <n>           threads running the bots (1)\n"
+                "  --timeout <ms>          time before a bot gives up (10000)\n"
+                "  --phases <list>         comma separated phases among status,login (status,login)\n"
+                "The server must be in offline mode, with a backlog fitting the concurrency.\n",
+                name);
+}
+
+/**
+ * @brief Parses the command line
+ *
+ * @param argc the number of arguments
+ * @param argv the arguments
+ * @param options the options to fill
+ * @return true the options are valid
+ * @return false they are not, the usage should be printed
+ */
+static bool parse(int argc, char **argv, Options &options)
+{
+    try
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (i + 1 >= argc)
+                return false;
+            std::string value = argv[++i];
+
+            if (arg == "--address")
+                options.address = value;
+            else if (arg == "--port")
+                options.port = static_cast<unsigned short>(std::stoi(value));
+            else if (arg == "--source")
+                options.source = value;
+            else if (arg == "--connections")
+                options.connections = std::stoul(value);
+            else if (arg == "--concurrency")
+                options.concurrency = std::max<std::size_t>(1, std::stoul(value));
+            else if (arg == "--threads")
+                options.threads = std::max(1, std::stoi(value));
+            else if (arg == "--timeout")
+                options.timeout = std::stoi(value);
+            else if (arg == "--phases")
+            {
+                options.phases.clear();
+                std::size_t start = 0;
+                while (start <= value.size())
+                {
+                    std::size_t end = std::min(value.find(',', start), value.size());
+                    std::string phase = value.substr(start, end - start);
+                    if (phase == "status")
+                        options.phases.push_back(Phase::STATUS);
+                    else if (phase == "login")
+                        options.phases.push_back(Phase::LOGIN);
+                    else
+                        return false;
+                    start = end + 1;
+                }
+            }
+            else
+                return false;
+        }
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Opens a non-blocking connection to the server
+ *
+ * @param options the options
+ * @return int the socket, -1 on failure
+ */
+static int openConnection(const Options &options)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    if (!options.source.empty())
+    {
+        sockaddr_in local{};
+        local.sin_family = AF_INET;
+        inet_pton(AF_INET, options.source.c_str(), &local.sin_addr);
+        if (bind(fd, (sockaddr *)&local, sizeof(local)) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+    }
+
+    sockaddr_in remote{};
+    remote.sin_family = AF_INET;
+    remote.sin_port = htons(options.port);
+    inet_pton(AF_INET, options.address.c_str(), &remote.sin_addr);
+    if (connect(fd, (sockaddr *)&remote, sizeof(remote)) != 0 && errno != EINPROGRESS)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ * @brief Queues the first packets of a phase
+ *
+ * @param bot the bot
+ * @param phase the phase
+ * @param options the options
+ */
+static void greet(Bot &bot, Phase phase, const Options &options)
+{
+    HandshakePacket handshake;
+    handshake.protocolVersion = MC_VERSION_NUMBER;
+    handshake.serverAddress = options.address;
+    handshake.serverPort = options.port;
+    handshake.nextState = phase == Phase::STATUS ? ClientState::STATUS : ClientState::LOGIN;
+    handshake.send(&bot.out);
+
+    if (phase == Phase::STATUS)
+    {
+        // Status request has no field
+        std::byte request[] = {std::byte(0x00)};
+        bot.out.finishPacketWrite(request, sizeof(request));
+        bot.step = Bot::STATUS;
+    }
+    else
+    {
+        LoginStart loginStart;
+        loginStart.name = bot.name;
+        loginStart.send(&bot.out);
+        bot.step = Bot::LOGIN;
+    }
+}
+
+/**
+ * @brief Handles a received packet
+ *
+ * @param bot the bot
+ * @param packet the packet id and data
+ * @param results the results to count the compressed logins in
+ * @return true the phase is over for the bot
+ * @return false it waits for more packets
+ */
+static bool handle(Bot &bot, PacketView &packet, Results &results)
+{
+    std::int32_t id = packet.readVarInt();
+
+    switch (bot.step)
+    {
+    case Bot::STATUS:
+    {
+        if (id != 0x00 || packet.readString().empty())
+            throw std::runtime_error("Invalid status response");
+
+        PingPongPacket ping;
+        ping.payload = (long)bot.start.time_since_epoch().count();
+        ping.send(&bot.out);
+        bot.step = Bot::PONG;
+        return false;
+    }
+    case Bot::PONG:
+    {
+        PingPongPacket pong;
+        if (id != pong.id)
+            throw std::runtime_error("Invalid pong");
+        pong.read(packet);
+        if (pong.payload != (long)bot.start.time_since_epoch().count())
+            throw std::runtime_error("Invalid pong payload");
+        return true;
+    }
+    case Bot::LOGIN:
+    {
+        if (id == 0x01)
+            throw std::runtime_error("Server is in online mode");
+        if (id == 0x03)
+        {
+            SetCompression compression(-1);
+            compression.read(packet);
+            bot.threshold = compression.threshold;
+            results.compressed++;
+            return false;
+        }
+        if (id != 0x02)
+            throw std::runtime_error("Login refused");
+
+        LoginSuccess success("", MinecraftUUID());
+        success.read(packet);
+        if (success.username != bot.name)
+            throw std::runtime_error("Invalid login success name");
+        return true;
+    }
+    default:
+        throw std::runtime_error("Unexpected packet");
+    }
+}
+
+/**
+ * @brief Handles the packets fully received by a bot
+ *
+ * @param bot the bot
+ * @param results the results to count the compressed logins in
+ * @return true the phase is over for the bot
+ * @return false it waits for more packets
+ */
+static bool receive(Bot &bot, Results &results)
+{
+    // Same decompressor for all the bots of a thread
+    thread_local crypto::ZLibCompressor decompressor(-1);
+    thread_local std::vector<std::byte> uncompressed;
+
+    std::size_t offset = 0;
+    bool done = false;
+    while (!done)
+    {
+        std::int32_t len;
+        std::size_t headerSize = varint::decode(bot.in.data() + offset, bot.in.size() - offset, len);
+        if (headerSize == 0)
+            break;
+        if (len <= 0 || len > MAX_PACKET_LENGTH)
+            throw std::runtime_error("Invalid packet length");
+        if (bot.in.size() - offset - headerSize < static_cast<std::size_t>(len))
+            break;
+
+        const std::byte *frame = bot.in.data() + offset + headerSize;
+        offset += headerSize + len;
+
+        PacketView packet(frame, len);
+        if (bot.threshold >= 0)
+        {
+            // Servers may send uncompressed packets of any size
+            std::int32_t dataLength = packet.readVarInt();
+            if (dataLength != 0)
+            {
+                uncompressed.resize(dataLength);
+                std::size_t dataLengthSize = len - packet.remaining();
+                int written = decompressor.uncompress(frame + dataLengthSize, packet.remaining(), uncompressed.data(), dataLength);
+                if (written != dataLength)
+                    throw std::runtime_error("Invalid uncompressed length");
+                packet = PacketView(uncompressed.data(), uncompressed.size());
+            }
+        }
+
+        done = handle(bot, packet, results);
+    }
+
+    bot.in.erase(bot.in.begin(), bot.in.begin() + offset);
+    return done;
+}
+
+/**
+ * @brief Runs some of the bots of a phase
+ *
+ * @param options the options
+ * @param phase the phase
+ * @param count the number of connections to open
+ * @param concurrency the number of connections open at the same time
+ * @param first the index of the first bot, for their names
+ * @param results the results to fill
+ */
+static void runBots(const Options &options, Phase phase, std::size_t count, std::size_t concurrency, std::size_t first, Results &results)
+{
+    std::vector<Bot> bots(std::min(count, concurrency));
+    std::vector<pollfd> fds(bots.size());
+    std::size_t started = 0;
+    std::size_t finished = 0;
+    std::byte buffer[16384];
+
+    auto fail = [&results, &finished](Bot &bot, const std::string &reason)
+    {
+        if (results.error.empty())
+            results.error = reason;
+        results.failures++;
+        finished++;
+        close(bot.fd);
+        bot.fd = -1;
+    };
+
+    while (finished < count)
+    {
+        auto now = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < bots.size(); i++)
+        {
+            Bot &bot = bots[i];
+            if (bot.fd < 0 && started < count)
+            {
+                bot = Bot();
+                bot.name = "bot" + std::to_string(first + started);
+                bot.start = now;
+                bot.fd = openConnection(options);
+                started++;
+                if (bot.fd < 0)
+                {
+                    fail(bot, std::string("Could not connect : ") + std::strerror(errno));
+                    continue;
+                }
+            }
+
+            if (bot.fd >= 0 && now - bot.start > std::chrono::milliseconds(options.timeout))
+                fail(bot, "Timed out");
+
+            fds[i].fd = bot.fd;
+            fds[i].events = POLLIN;
+            if (bot.fd >= 0 && (bot.step == Bot::CONNECTING || bot.sent < bot.out.getData().size()))
+                fds[i].events |= POLLOUT;
+            fds[i].revents = 0;
+        }
+
+        if (poll(fds.data(), fds.size(), 100) < 0 && errno != EINTR)
+            throw std::runtime_error(std::string("Could not poll : ") + std::strerror(errno));
+
+        for (std::size_t i = 0; i < bots.size(); i++)
+        {
+            Bot &bot = bots[i];
+            if (bot.fd < 0 || fds[i].revents == 0)
+                continue;
+
+            try
+            {
+                if (bot.step == Bot::CONNECTING)
+                {
+                    int error = 0;
+                    socklen_t errorLen = sizeof(error);
+                    getsockopt(bot.fd, SOL_SOCKET, SO_ERROR, &error, &errorLen);
+                    if (error != 0)
+                        throw std::runtime_error(std::string("Could not connect : ") + std::strerror(error));
+                    if (!(fds[i].revents & POLLOUT))
+                        continue;
+                    greet(bot, phase, options);
+                }
+
+                const std::vector<std::byte> &out = bot.out.getData();
+                if (bot.sent < out.size())
+                {
+                    ssize_t written = send(bot.fd, out.data() + bot.sent, out.size() - bot.sent, MSG_NOSIGNAL);
+                    if (written < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+                        throw std::runtime_error(std::string("Could not send : ") + std::strerror(errno));
+                    if (written > 0)
+                        bot.sent += written;
+                }
+
+                if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+                    continue;
+
+                ssize_t read = recv(bot.fd, buffer, sizeof(buffer), 0);
+                if (read == 0)
+                    throw std::runtime_error("Closed by the server");
+                if (read < 0)
+                {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK)
+                        continue;
+                    throw std::runtime_error(std::string("Could not receive : ") + std::strerror(errno));
+                }
+                bot.in.insert(bot.in.end(), buffer, buffer + read);
+
+                if (receive(bot, results))
+                {
+                    results.latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bot.start).count());
+                    finished++;
+                    close(bot.fd);
+                    bot.fd = -1;
+                }
+            }
+            catch (const std::exception &err)
+            {
+                fail(bot, err.what());
+            }
+        }
+    }
+}
+
+/**
+ * @brief Gets a percentile of sorted latencies
+ *
+ * @param sorted the sorted latencies
+ * @param percentile the percentile, from 0 to 1
+ * @return double the latency
+ */
+static double percentile(const std::vector<double> &sorted, double percentile)
+{
+    if (sorted.empty())
+        return 0;
+    return sorted[static_cast<std::size_t>(percentile * (sorted.size() - 1) + 0.5)];
+}
+
+/**
+ * @brief Runs a phase and prints its results
+ *
+ * @param options the options
+ * @param phase the phase
+ * @return true every connection succeeded
+ * @return false some failed
+ */
+static bool runPhase(const Options &options, Phase phase)
+{
+    std::vector<Results> results(options.threads);
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+    std::size_t first = 0;
+    for (unsigned int i = 0; i < options.threads; i++)
+    {
+        // Connections and concurrency are split evenly
+        std::size_t count = options.connections / options.threads + (i < options.connections % options.threads);
+        std::size_t concurrency = std::max<std::size_t>(1, options.concurrency / options.threads);
+        threads.emplace_back(runBots, std::cref(options), phase, count, concurrency, first, std::ref(results[i]));
+        first += count;
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    Results merged;
+    for (Results &result : results)
+    {
+        merged.latencies.insert(merged.latencies.end(), result.latencies.begin(), result.latencies.end());
+        merged.failures += result.failures;
+        merged.compressed += result.compressed;
+        if (merged.error.empty())
+            merged.error = result.error;
+    }
+    std::sort(merged.latencies.begin(), merged.latencies.end());
+
+    std::printf("%-6s : %zu ok, %zu failed in %.2f s, %.0f /s, p50 %.2f ms, p99 %.2f ms, p999 %.2f ms\n",
+                phase == Phase::STATUS ? "status" : "login",
+                merged.latencies.size(), merged.failures, seconds, merged.latencies.size() / seconds,
+                percentile(merged.latencies, 0.5), percentile(merged.latencies, 0.99), percentile(merged.latencies, 0.999));
+    if (phase == Phase::LOGIN)
+        std::printf("         %zu logins compressed\n", merged.compressed);
+    if (merged.failures > 0)
+        std::printf("         first failure : %s\n", merged.error.c_str());
+
+    return merged.failures == 0;
+}
+
+/**
+ * @brief Main entry point for the load generator
+ *
+ * @param argc the number of arguments
+ * @param argv the arguments
+ * @return int 0 if every connection succeeded
+ */
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parse(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // Packets log every send otherwise
+    logger::setLevel(LogLevel::WARN);
+
+    bool succeeded = true;
+    for (Phase phase : options.phases)
+        succeeded = runPhase(options, phase) && succeeded;
+
+    return succeeded ? 0 : 1;
+}